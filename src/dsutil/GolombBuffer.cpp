@@ -32,16 +32,26 @@ CGolombBuffer::CGolombBuffer(BYTE* pBuffer, int nSize)
 UINT64 CGolombBuffer::BitRead(int nBits, bool fPeek)
 {
     //ASSERT(nBits >= 0 && nBits <= 64);
+    ASSERT(nBits <= 56 || !fPeek);
 
-    while (m_bitlen < nBits) {
-        m_bitbuff <<= 8;
+    if (nBits <= 0) {
+        return 0;
+    }
+    if (nBits > 56 && !fPeek) {
+        UINT64 hi = BitRead(nBits - 32);
+        return (hi << 32) | BitRead(32);
+    }
 
-        if (m_nBitPos >= m_nSize) {
+    if (m_bitlen < nBits) {
+        // Refill as many whole bytes as fit, most reads then only shift and mask. The bits above
+        // m_bitlen are left over from earlier reads and never returned.
+        while (m_bitlen <= 56 && m_nBitPos < m_nSize) {
+            m_bitbuff = (m_bitbuff << 8) | m_pBuffer[m_nBitPos++];
+            m_bitlen += 8;
+        }
+        if (m_bitlen < nBits) {
             return 0;
         }
-
-        *(BYTE*)&m_bitbuff = m_pBuffer[m_nBitPos++];
-        m_bitlen += 8;
     }
 
     int bitlen = m_bitlen - nBits;
@@ -49,7 +59,6 @@ UINT64 CGolombBuffer::BitRead(int nBits, bool fPeek)
     UINT64 ret = (m_bitbuff >> bitlen) & ((1ui64 << nBits) - 1);
 
     if (!fPeek) {
-        m_bitbuff &= ((1ui64 << bitlen) - 1);
         m_bitlen = bitlen;
     }
 
@@ -76,19 +85,16 @@ void CGolombBuffer::BitByteAlign()
     m_bitlen &= ~7;
 }
 
-int CGolombBuffer::GetPos()
-{
-    return m_nBitPos - (m_bitlen >> 3);
-}
-
 void CGolombBuffer::ReadBuffer(BYTE* pDest, int nSize)
 {
-    ASSERT(m_nBitPos + nSize <= m_nSize);
-    ASSERT(m_bitlen == 0);
-    nSize = min(nSize, m_nSize - m_nBitPos);
+    ASSERT((m_bitlen & 7) == 0);
+    int nPos = GetPos();
+    ASSERT(nPos + nSize <= m_nSize);
+    nSize = min(nSize, m_nSize - nPos);
 
-    memcpy(pDest, m_pBuffer + m_nBitPos, nSize);
-    m_nBitPos += nSize;
+    memcpy(pDest, m_pBuffer + nPos, nSize);
+    m_nBitPos = nPos + nSize;
+    m_bitlen  = 0;
 }
 
 void CGolombBuffer::Reset()
@@ -108,7 +114,7 @@ void CGolombBuffer::Reset(BYTE* pNewBuffer, int nNewSize)
 
 void CGolombBuffer::SkipBytes(int nCount)
 {
-    m_nBitPos += nCount;
+    m_nBitPos  = GetPos() + nCount;
     m_bitlen   = 0;
     m_bitbuff  = 0;
 }
@@ -40,17 +40,17 @@ public:
 
     void SetSize(int nValue) { m_nSize = nValue; };
     int GetSize() const { return m_nSize; };
-    int RemainingSize() const { return m_nSize - m_nBitPos; };
-    bool IsEOF() const { return m_nBitPos >= m_nSize; };
-    int GetPos();
-    BYTE* GetBufferPos() { return m_pBuffer + m_nBitPos; };
+    int RemainingSize() const { return m_nSize - GetPos(); };
+    bool IsEOF() const { return GetPos() >= m_nSize; };
+    int GetPos() const { return m_nBitPos - (m_bitlen >> 3); };
+    BYTE* GetBufferPos() { return m_pBuffer + GetPos(); };
 
     void SkipBytes(int nCount);
 
 private:
     BYTE* m_pBuffer;
     int   m_nSize;
-    int   m_nBitPos;
-    int   m_bitlen;
-    INT64 m_bitbuff;
+    int   m_nBitPos;    // of the next byte to load into m_bitbuff, see GetPos
+    int   m_bitlen;     // bits loaded but not read yet, at the bottom of m_bitbuff
+    UINT64 m_bitbuff;
 };
@@ -328,6 +328,24 @@ void CDirectVobSubFilter::PrintMessages(BYTE* pOut)
             );
         msg += tmp;
         delete []caches_info;
+
+        //print render timing
+        RenderTimingInfo *timing_info = NULL;
+        XyGetBin(DirectVobSubXyOptions::BIN_RENDER_TIMING_INFO, reinterpret_cast<LPVOID*>(&timing_info), &tmp_size);
+        ASSERT(timing_info);
+        static const TCHAR *stage_names[DirectVobSubXyOptions::RENDER_STAGE_COUNT] = {
+            _T("parse"), _T("path"), _T("scan convert"), _T("widen"), _T("rasterize"),
+            _T("blur"), _T("clip"), _T("composite"), _T("alpha blend")
+        };
+        msg += _T("Render timing :last_frame/max_frame/average [us]\n");
+        for (int i=0;i<DirectVobSubXyOptions::RENDER_STAGE_COUNT;i++)
+        {
+            const DirectVobSubXyOptions::RenderStageTiming& stage = timing_info->stages[i];
+            tmp.Format(_T("  %s:%.0f/%.0f/%.0f\n"), stage_names[i], stage.last_frame_us, stage.max_frame_us,
+                stage.frames>0 ? stage.total_us/stage.frames : 0.0);
+            msg += tmp;
+        }
+        delete []timing_info;
 	}
 
 	if(msg.IsEmpty()) return;
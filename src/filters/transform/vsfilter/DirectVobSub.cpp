@@ -108,6 +108,13 @@ CDirectVobSub::CDirectVobSub()
     m_xy_int_opt[INT_ASS_TAG_LIST_CACHE_ITEM_NUM] = GetCompatibleProfileInt(ResStr(IDS_R_PERFORMANCE), ResStr(IDS_RP_ASS_TAG_LIST_CACHE_ITEM_NUM)
         , CacheManager::ASS_TAG_LIST_CACHE_ITEM_NUM);
     if(m_xy_int_opt[INT_ASS_TAG_LIST_CACHE_ITEM_NUM]<0) m_xy_int_opt[INT_ASS_TAG_LIST_CACHE_ITEM_NUM] = 0;
+
+    m_xy_int_opt[INT_COLD_CACHE_MAX_SIZE] = theApp.GetProfileInt(ResStr(IDS_R_PERFORMANCE), ResStr(IDS_RP_COLD_CACHE_MAX_SIZE)
+        , CacheManager::COLD_CACHE_MAX_SIZE/1024);
+    if(m_xy_int_opt[INT_COLD_CACHE_MAX_SIZE]<0) m_xy_int_opt[INT_COLD_CACHE_MAX_SIZE] = 0;
+
+    m_xy_int_opt[INT_MAX_ANIMATION_RATE] = theApp.GetProfileInt(ResStr(IDS_R_PERFORMANCE), ResStr(IDS_RP_MAX_ANIMATION_RATE), 0);
+    if(m_xy_int_opt[INT_MAX_ANIMATION_RATE]<0) m_xy_int_opt[INT_MAX_ANIMATION_RATE] = 0;
 
     m_xy_int_opt[INT_SUBPIXEL_POS_LEVEL] = theApp.GetProfileInt(ResStr(IDS_R_PERFORMANCE), ResStr(IDS_RP_SUBPIXEL_POS_LEVEL), SubpixelPositionControler::EIGHT_X_EIGHT);
     if(m_xy_int_opt[INT_SUBPIXEL_POS_LEVEL]<0) m_xy_int_opt[INT_SUBPIXEL_POS_LEVEL]=0;
@@ -659,6 +666,17 @@ STDMETHODIMP CDirectVobSub::get_XyFlyWeightInfo(XyFlyWeightInfo* xy_fw_info)
     return S_FALSE;
 }
 
+STDMETHODIMP CDirectVobSub::get_RenderTimingInfo(RenderTimingInfo* timing_info)
+{
+    CAutoLock cAutoLock(&m_propsLock);
+    if(timing_info)
+    {
+        memset(timing_info, 0, sizeof(*timing_info));
+        return S_OK;
+    }
+    return S_FALSE;
+}
+
 STDMETHODIMP CDirectVobSub::UpdateRegistry()
 {
 	AFX_MANAGE_STATE(AfxGetStaticModuleState());
@@ -703,6 +721,8 @@ STDMETHODIMP CDirectVobSub::UpdateRegistry()
     theApp.WriteProfileInt(ResStr(IDS_R_PERFORMANCE), ResStr(IDS_RP_OVERLAY_NO_BLUR_CACHE_MAX_ITEM_NUM), m_xy_int_opt[INT_OVERLAY_NO_BLUR_CACHE_MAX_ITEM_NUM]);
     theApp.WriteProfileInt(ResStr(IDS_R_PERFORMANCE), ResStr(IDS_RP_SCAN_LINE_DATA_CACHE_MAX_ITEM_NUM), m_xy_int_opt[INT_SCAN_LINE_DATA_CACHE_MAX_ITEM_NUM]);
     theApp.WriteProfileInt(ResStr(IDS_R_PERFORMANCE), ResStr(IDS_RP_PATH_DATA_CACHE_MAX_ITEM_NUM), m_xy_int_opt[INT_PATH_DATA_CACHE_MAX_ITEM_NUM]);
+    theApp.WriteProfileInt(ResStr(IDS_R_PERFORMANCE), ResStr(IDS_RP_COLD_CACHE_MAX_SIZE), m_xy_int_opt[INT_COLD_CACHE_MAX_SIZE]);
+    theApp.WriteProfileInt(ResStr(IDS_R_PERFORMANCE), ResStr(IDS_RP_MAX_ANIMATION_RATE), m_xy_int_opt[INT_MAX_ANIMATION_RATE]);
     theApp.WriteProfileInt(ResStr(IDS_R_PERFORMANCE), ResStr(IDS_RP_SUBPIXEL_POS_LEVEL), m_xy_int_opt[INT_SUBPIXEL_POS_LEVEL]);
     theApp.WriteProfileInt(ResStr(IDS_R_GENERAL), ResStr(IDS_RG_USE_UPSTREAM_PREFERRED_ORDER), m_xy_bool_opt[BOOL_FOLLOW_UPSTREAM_PREFERRED_ORDER]);
 
@@ -1141,6 +1161,16 @@ STDMETHODIMP CDirectVobSub::XyGetBin( int field, LPVOID *value, int *size )
             *value = new XyFlyWeightInfo[1];
         }
         return get_XyFlyWeightInfo(reinterpret_cast<XyFlyWeightInfo*>(*value));
+    case BIN_RENDER_TIMING_INFO:
+        if (size)
+        {
+            *size=1;
+        }
+        if (value)
+        {
+            *value = new RenderTimingInfo[1];
+        }
+        return get_RenderTimingInfo(reinterpret_cast<RenderTimingInfo*>(*value));
 
     }
     return E_NOTIMPL;
@@ -1175,6 +1205,12 @@ STDMETHODIMP CDirectVobSub::XySetInt( int field, int value )
             return E_INVALIDARG;
         }
         break;
+    case DirectVobSubXyOptions::INT_MAX_ANIMATION_RATE:
+        if (value<0)
+        {
+            return E_INVALIDARG;
+        }
+        break;
     }
     CAutoLock cAutoLock(&m_propsLock);
 
@@ -48,6 +48,7 @@ public:
 
     typedef DirectVobSubXyOptions::CachesInfo CachesInfo;
     typedef DirectVobSubXyOptions::XyFlyWeightInfo XyFlyWeightInfo;
+    typedef DirectVobSubXyOptions::RenderTimingInfo RenderTimingInfo;
     typedef DirectVobSubXyOptions::ColorSpaceOpt ColorSpaceOpt;
 protected:
 	CDirectVobSub();
@@ -171,6 +172,7 @@ public:
 
     STDMETHOD (get_CachesInfo)(CachesInfo* caches_info);
     STDMETHOD (get_XyFlyWeightInfo)(XyFlyWeightInfo* xy_fw_info);
+    STDMETHOD (get_RenderTimingInfo)(RenderTimingInfo* timing_info);
     
 	STDMETHODIMP UpdateRegistry();
 
@@ -31,6 +31,7 @@
 #include "../../../SubPic/SimpleSubPicProviderImpl.h"
 #include "../../../SubPic/PooledSubPic.h"
 #include "../../../subpic/SimpleSubPicWrapper.h"
+#include "../../../subtitles/xy_render_timing.h"
 
 #include <initguid.h>
 #include "..\..\..\..\include\moreuuids.h"
@@ -63,6 +64,7 @@ using namespace DirectVobSubXyOptions;
 CDirectVobSubFilter::CDirectVobSubFilter(LPUNKNOWN punk, HRESULT* phr, const GUID& clsid)
 	: CBaseVideoFilter(NAME("CDirectVobSubFilter"), punk, phr, clsid)
 	, m_nSubtitleId(-1)
+	, m_rtPostedInvalidate(_I64_MAX)
 	, m_fMSMpeg4Fix(false)
 	, m_fps(25)
 {
@@ -256,6 +258,10 @@ HRESULT CDirectVobSubFilter::Transform(IMediaSample* pIn)
 
 		if(m_simple_provider)
 		{
+			LONGLONG rtInvalidate = InterlockedExchange64(&m_rtPostedInvalidate, _I64_MAX);
+			if(rtInvalidate != _I64_MAX)
+				m_simple_provider->Invalidate(rtInvalidate);
+
 			m_simple_provider->SetTime(CalcCurrentTime());
 			m_simple_provider->SetFPS(m_fps);
 		}
@@ -681,8 +687,11 @@ void CDirectVobSubFilter::InitSubPicQueue()
     CacheManager::GetOverlayNoBlurMruCache()->SetMaxItemNum(m_xy_int_opt[INT_OVERLAY_NO_BLUR_CACHE_MAX_ITEM_NUM]);
     CacheManager::GetOverlayMruCache()->SetMaxItemNum(m_xy_int_opt[INT_OVERLAY_CACHE_MAX_ITEM_NUM]);
 
-    XyFwGroupedDrawItemsHashKey::GetCacher()->SetMaxItemNum(m_xy_int_opt[INT_BITMAP_MRU_CACHE_ITEM_NUM]);
+    //the bitmaps are cached by the id of their key, which must outlive the cold tier too
+    XyFwGroupedDrawItemsHashKey::GetCacher()->SetMaxItemNum(m_xy_int_opt[INT_BITMAP_MRU_CACHE_ITEM_NUM]
+        + CacheManager::BITMAP_COLD_CACHE_ITEM_NUM);
     CacheManager::GetBitmapMruCache()->SetMaxItemNum(m_xy_int_opt[INT_BITMAP_MRU_CACHE_ITEM_NUM]);
+    CacheManager::SetColdCacheMaxSize(m_xy_int_opt[INT_COLD_CACHE_MAX_SIZE]*1024);
 
     CacheManager::GetClipperAlphaMaskMruCache()->SetMaxItemNum(m_xy_int_opt[INT_CLIPPER_MRU_CACHE_ITEM_NUM]);
     CacheManager::GetTextInfoCache()->SetMaxItemNum(m_xy_int_opt[INT_TEXT_INFO_CACHE_ITEM_NUM]);
@@ -1301,6 +1310,26 @@ STDMETHODIMP CDirectVobSubFilter::get_XyFlyWeightInfo( XyFlyWeightInfo* xy_fw_in
     return hr;
 }
 
+STDMETHODIMP CDirectVobSubFilter::get_RenderTimingInfo( RenderTimingInfo* timing_info )
+{
+    HRESULT hr = CDirectVobSub::get_RenderTimingInfo(timing_info);
+    if (hr!=S_OK)
+    {
+        return hr;
+    }
+    for (int i=0;i<DirectVobSubXyOptions::RENDER_STAGE_COUNT;i++)
+    {
+        XyRenderTiming::StageInfo info;
+        XyRenderTiming::GetStageInfo(i, &info);
+        timing_info->stages[i].total_us      = info.total_us;
+        timing_info->stages[i].last_frame_us = info.last_frame_us;
+        timing_info->stages[i].max_frame_us  = info.max_frame_us;
+        timing_info->stages[i].calls         = info.calls;
+        timing_info->stages[i].frames        = info.frames;
+    }
+    return hr;
+}
+
 STDMETHODIMP CDirectVobSubFilter::get_MediaFPS(bool* fEnabled, double* fps)
 {
 	HRESULT hr = CDirectVobSub::get_MediaFPS(fEnabled, fps);
@@ -1875,6 +1904,7 @@ void CDirectVobSubFilter::SetSubtitle(ISubStream* pSubStream, bool fApplyDefStyl
 			}
 
 			pRTS->m_ePARCompensationType = m_ePARCompensationType;
+			pRTS->m_maxAnimationRate = m_xy_int_opt[DirectVobSubXyOptions::INT_MAX_ANIMATION_RATE];
 			if (m_CurrentVIH2.dwPictAspectRatioX != 0 && m_CurrentVIH2.dwPictAspectRatioY != 0&& m_CurrentVIH2.bmiHeader.biWidth != 0 && m_CurrentVIH2.bmiHeader.biHeight != 0)
 			{
 				pRTS->m_dPARCompensation = ((double)abs(m_CurrentVIH2.bmiHeader.biWidth) / (double)abs(m_CurrentVIH2.bmiHeader.biHeight)) /
@@ -1983,6 +2013,64 @@ void CDirectVobSubFilter::InvalidateSubtitle(REFERENCE_TIME rtInvalidate, DWORD_
 	}
 }
 
+// Text scripts are diffed against the loaded lines, only the edited ones are parsed and
+// rendered again. Returns false if @fn is not a loaded script that can be reloaded this way.
+bool CDirectVobSubFilter::ReloadChangedSubtitle(const CString& fn)
+{
+	CComPtr<ISubStream> pSubStream;
+
+	{
+		// only to find the script, Transform takes m_csQueueLock for every frame and must not wait 
+		// for it to be parsed again
+		CAutoLock cAutolock(&m_csQueueLock);
+
+		POSITION pos = m_pSubStreams.GetHeadPosition();
+		while(pos)
+		{
+			ISubStream* p = m_pSubStreams.GetNext(pos);
+
+			CLSID clsid;
+			p->GetClassID(&clsid);
+			if(clsid != __uuidof(CRenderedTextSubtitle))
+				continue;
+
+			if(dynamic_cast<CRenderedTextSubtitle*>(p)->m_path.CompareNoCase(fn) == 0)
+			{
+				pSubStream = p;
+				break;
+			}
+		}
+	}
+
+	if(!pSubStream)
+		return false;
+
+	// parses the script without any lock, then updates the subtitle under its own
+	REFERENCE_TIME rtInvalidate;
+	if(!dynamic_cast<CRenderedTextSubtitle*>((ISubStream*)pSubStream)->ReloadChanges(&rtInvalidate))
+		return false;
+
+	InvalidateSubtitle(rtInvalidate, reinterpret_cast<DWORD_PTR>((ISubStream*)pSubStream));
+	return true;
+}
+
+// Called from the streaming thread of the subtitle pins, which must not wait for a frame to be
+// rendered and blended under m_csQueueLock. Keeps the earliest of the posted times.
+void CDirectVobSubFilter::PostInvalidateSubtitle(REFERENCE_TIME rtInvalidate, DWORD_PTR nSubtitleId)
+{
+	if(nSubtitleId != -1 && nSubtitleId != m_nSubtitleId)
+		return;
+
+	LONGLONG rt = m_rtPostedInvalidate;
+	while(rtInvalidate < rt)
+	{
+		LONGLONG prev = InterlockedCompareExchange64(&m_rtPostedInvalidate, rtInvalidate, rt);
+		if(prev == rt)
+			break;
+		rt = prev;
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 
 void CDirectVobSubFilter::AddSubStream(ISubStream* pSubStream)
@@ -2159,18 +2247,27 @@ DWORD CDirectVobSubFilter::ThreadProc()
 			{
 				Sleep(500);
 
+				bool fChanged = false;
+
 				POSITION pos = m_frd.files.GetHeadPosition();
 				for(int i = 0; pos; i++)
 				{
 					CFileStatus status;
-					if(CFileGetStatus(m_frd.files.GetNext(pos), status)
+					CString fn = m_frd.files.GetNext(pos);
+					if(CFileGetStatus(fn, status)
 						&& m_frd.mtime[i] != status.m_mtime)
 					{
-						Open();
-						SetupFRD(paths, handles);
-						break;
+						fChanged = true;
+						if(!ReloadChangedSubtitle(fn))
+						{
+							Open();
+							break;
+						}
 					}
 				}
+
+				if(fChanged)
+					SetupFRD(paths, handles);
 			}
 		}
 		else
@@ -2375,11 +2472,19 @@ STDMETHODIMP CDirectVobSubFilter::XySetInt( int field, int value )
         CacheManager::GetOverlayNoBlurMruCache()->SetMaxItemNum(m_xy_int_opt[field]);
         break;
     case DirectVobSubXyOptions::INT_BITMAP_MRU_CACHE_ITEM_NUM:
+        XyFwGroupedDrawItemsHashKey::GetCacher()->SetMaxItemNum(m_xy_int_opt[field]
+            + CacheManager::BITMAP_COLD_CACHE_ITEM_NUM);
         CacheManager::GetBitmapMruCache()->SetMaxItemNum(m_xy_int_opt[field]);
         break;
     case DirectVobSubXyOptions::INT_CLIPPER_MRU_CACHE_ITEM_NUM:
         CacheManager::GetClipperAlphaMaskMruCache()->SetMaxItemNum(m_xy_int_opt[field]);
         break;
+    case DirectVobSubXyOptions::INT_COLD_CACHE_MAX_SIZE:
+        CacheManager::SetColdCacheMaxSize(m_xy_int_opt[field]*1024);
+        break;
+    case DirectVobSubXyOptions::INT_MAX_ANIMATION_RATE:
+        UpdateSubtitle(false);
+        break;
     case DirectVobSubXyOptions::INT_TEXT_INFO_CACHE_ITEM_NUM:
         CacheManager::GetTextInfoCache()->SetMaxItemNum(m_xy_int_opt[field]);
         break;
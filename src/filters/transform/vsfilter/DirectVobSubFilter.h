@@ -116,6 +116,7 @@ public:
 
     STDMETHODIMP get_CachesInfo(CachesInfo* caches_info);
     STDMETHODIMP get_XyFlyWeightInfo(XyFlyWeightInfo* xy_fw_info);
+    STDMETHODIMP get_RenderTimingInfo(RenderTimingInfo* timing_info);
 
     STDMETHODIMP get_MediaFPS(bool* fEnabled, double* fps);
     STDMETHODIMP put_MediaFPS(bool fEnabled, double fps);
@@ -169,6 +170,7 @@ protected:
 	bool m_fLoading;
 
 	bool Open();
+	bool ReloadChangedSubtitle(const CString& fn);
 
 	int FindPreferedLanguage(bool fHideToo = true);
 	void UpdatePreferedLanguages(CString lang);
@@ -183,6 +185,10 @@ protected:
 	void SetSubtitle(ISubStream* pSubStream, bool fApplyDefStyle = true);
 	void InvalidateSubtitle(REFERENCE_TIME rtInvalidate = -1, DWORD_PTR nSubtitleId = -1);
 
+	// the input pins post their invalidations without locking, the next Transform applies them
+	volatile LONGLONG m_rtPostedInvalidate;
+	void PostInvalidateSubtitle(REFERENCE_TIME rtInvalidate, DWORD_PTR nSubtitleId);
+
 	// the text input pin is using these
 	void AddSubStream(ISubStream* pSubStream);
 	void RemoveSubStream(ISubStream* pSubStream);
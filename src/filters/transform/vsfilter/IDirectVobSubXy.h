@@ -24,6 +24,10 @@ namespace DirectVobSubXyOptions
         INT_SUBPIXEL_POS_LEVEL,
 
         INT_LAYOUT_SIZE_OPT,//see @LayoutSizeOpt
+
+        INT_COLD_CACHE_MAX_SIZE,//in KB, size of the compressed tier of the overlay and bitmap caches, 0 to disable
+
+        INT_MAX_ANIMATION_RATE,//in fps, animated subtitles are rendered at no more than this rate, 0 to render every frame
         INT_COUNT
     };
     enum//bool
@@ -62,6 +66,10 @@ namespace DirectVobSubXyOptions
         //size = 1
         BIN_XY_FLY_WEIGHT_INFO,
 
+        //struct RenderTimingInfo
+        //size = 1
+        BIN_RENDER_TIMING_INFO,
+
         BIN_COUNT
     };
     struct ColorSpaceOpt
@@ -95,6 +103,29 @@ namespace DirectVobSubXyOptions
         CacheInfo xy_fw_string_w;
         CacheInfo xy_fw_grouped_draw_items_hash_key;
     };
+    enum RenderStage
+    {
+        RENDER_STAGE_PARSE,//ParseScript, GetSubtitle
+        RENDER_STAGE_PATH,//path creation and transform
+        RENDER_STAGE_SCAN_CONVERT,
+        RENDER_STAGE_WIDEN,
+        RENDER_STAGE_RASTERIZE,
+        RENDER_STAGE_BLUR,
+        RENDER_STAGE_CLIP,//clipper alpha masks
+        RENDER_STAGE_COMPOSITE,//draw items and group compositing
+        RENDER_STAGE_ALPHA_BLEND,//into the video frame
+        RENDER_STAGE_COUNT
+    };
+    //time spent in a stage itself, in us, not counting the stages it calls
+    struct RenderStageTiming
+    {
+        double total_us, last_frame_us, max_frame_us;
+        std::size_t calls, frames;
+    };
+    struct RenderTimingInfo
+    {
+        RenderStageTiming stages[RENDER_STAGE_COUNT];
+    };
     enum LayoutSizeOpt
     {
         LAYOUT_SIZE_OPT_FOLLOW_ORIGINAL_VIDEO_SIZE,
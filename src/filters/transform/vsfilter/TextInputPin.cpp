@@ -42,5 +42,5 @@ void CTextInputPin::RemoveSubStream(ISubStream* pSubStream)
 
 void CTextInputPin::InvalidateSubtitle(REFERENCE_TIME rtStart, ISubStream* pSubStream)
 {
-	m_pDVS->InvalidateSubtitle(rtStart, (DWORD_PTR)(ISubStream*)pSubStream);
+	m_pDVS->PostInvalidateSubtitle(rtStart, (DWORD_PTR)(ISubStream*)pSubStream);
 }
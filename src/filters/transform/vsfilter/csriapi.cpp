@@ -26,6 +26,7 @@
 #include "..\..\..\subtitles\VobSubFile.h"
 #include "..\..\..\subtitles\RTS.h"
 #include "..\..\..\subtitles\SSF.h"
+#include "..\..\..\subpic\SimpleSubpicImpl.h"
 
 #define CSRIAPI extern "C" __declspec(dllexport)
 #define CSRI_OWN_HANDLES
@@ -135,25 +136,56 @@ CSRIAPI void csri_render(csri_inst *inst, struct csri_frame *frame, double time)
 	SubPicDesc spd;
 	spd.w = inst->screen_res.cx;
 	spd.h = inst->screen_res.cy;
+	spd.bits = frame->planes[0];
+	spd.pitch = frame->strides[0];
+	int render_type = MSP_RGBA;
 	switch (inst->pixfmt) {
 		case CSRI_F_BGR_:
 			spd.type = MSP_RGBA;
 			spd.bpp = 32;
-			spd.bits = frame->planes[0];
-			spd.pitch = frame->strides[0];
+			break;
+
+		case CSRI_F_BGR:
+			spd.type = MSP_RGB24;
+			spd.bpp = 24;
+			render_type = MSP_RGBA;
+			break;
+
+		case CSRI_F_YUY2:
+			spd.type = MSP_YUY2;
+			spd.bpp = 16;
+			render_type = MSP_XY_AUYV;
+			break;
+
+		case CSRI_F_YV12:
+			spd.type = MSP_YV12;
+			spd.bpp = 8;
+			spd.bitsU = frame->planes[1];
+			spd.bitsV = frame->planes[2];
+			spd.pitchUV = frame->strides[1];
+			render_type = MSP_AYUV_PLANAR;
 			break;
 
 		default:
-            ASSERT(0);
-            CString msg;
-            msg.Format(_T("Anything other then RGB32 is NOT supported!"));
-            MessageBox(NULL, msg, _T("Warning"), MB_OKCANCEL|MB_ICONWARNING);
-            int o = 0; o=o/o;
+			ASSERT(0); // refused by csri_request_fmt
 			return;
 	}
 	spd.vidrect = inst->video_rect;
 
-	inst->rts->Render(spd, (REFERENCE_TIME)(time*10000000), arbitrary_framerate, inst->video_rect);
+	REFERENCE_TIME rt = (REFERENCE_TIME)(time*10000000);
+	if (spd.type == MSP_RGBA) {
+		inst->rts->Render(spd, rt, arbitrary_framerate, inst->video_rect);
+		return;
+	}
+
+	// Other formats are blended straight into the frame, from a render in their own colorspace, 
+	// like the AviSynth filters do
+	CComPtr<IXySubRenderFrame> sub_render_frame;
+	if (SUCCEEDED(inst->rts->RenderEx(&sub_render_frame, render_type, inst->screen_res, inst->screen_res, 
+			inst->video_rect, rt, arbitrary_framerate)) && sub_render_frame) {
+		CComPtr<ISimpleSubPic> subpic = new SimpleSubpic(sub_render_frame, spd.type);
+		subpic->AlphaBlt(&spd);
+	}
 }
 
 
@@ -24,6 +24,7 @@
 #include <atlpath.h>
 #include "resource.h"
 #include "../../../Subtitles/VobSubFile.h"
+#include "../../../Subtitles/SupFile.h"
 #include "../../../Subtitles/RTS.h"
 #include "../../../Subtitles/SSF.h"
 #include "../../../SubPic/PooledSubPic.h"
@@ -65,6 +66,11 @@ protected:
     CSimpleTextSubtitle::YCbCrRange m_script_selected_range;
 
     bool m_fLazyInit;
+
+    // The caches of the renderer (CacheManager, the flyweights, the subpixel controler) are global 
+    // and not locked, so all the instances render under this lock. Fetching the frames and blending 
+    // the subpictures go without it, so AviSynth+ frame threads only wait on each other there.
+    static CCritSec s_csRender;
 public:
     CFilter() : CUnknown(NAME("CFilter"), NULL), m_fps(-1), m_SubPicProviderId(0), m_fLazyInit(false)
     {
@@ -74,8 +80,11 @@ public:
         CacheManager::GetOverlayNoBlurMruCache()->SetMaxItemNum(m_xy_int_opt[INT_OVERLAY_NO_BLUR_CACHE_MAX_ITEM_NUM]);
         CacheManager::GetOverlayMruCache()->SetMaxItemNum(m_xy_int_opt[INT_OVERLAY_CACHE_MAX_ITEM_NUM]);
 
-        XyFwGroupedDrawItemsHashKey::GetCacher()->SetMaxItemNum(m_xy_int_opt[INT_BITMAP_MRU_CACHE_ITEM_NUM]);
+        //the bitmaps are cached by the id of their key, which must outlive the cold tier too
+        XyFwGroupedDrawItemsHashKey::GetCacher()->SetMaxItemNum(m_xy_int_opt[INT_BITMAP_MRU_CACHE_ITEM_NUM]
+            + CacheManager::BITMAP_COLD_CACHE_ITEM_NUM);
         CacheManager::GetBitmapMruCache()->SetMaxItemNum(m_xy_int_opt[INT_BITMAP_MRU_CACHE_ITEM_NUM]);
+        CacheManager::SetColdCacheMaxSize(m_xy_int_opt[INT_COLD_CACHE_MAX_SIZE]*1024);
 
         CacheManager::GetClipperAlphaMaskMruCache()->SetMaxItemNum(m_xy_int_opt[INT_CLIPPER_MRU_CACHE_ITEM_NUM]);
         CacheManager::GetTextInfoCache()->SetMaxItemNum(m_xy_int_opt[INT_TEXT_INFO_CACHE_ITEM_NUM]);
@@ -105,7 +114,7 @@ public:
 	CString GetFileName() {CAutoLock cAutoLock(this); return m_fn;}
 	void SetFileName(CString fn) {CAutoLock cAutoLock(this); m_fn = fn;}
 
-    void SetYuvMatrix(SubPicDesc& dst)
+    void SetYuvMatrix(const SubPicDesc& dst)
     {
         ColorConvTable::YuvMatrixType yuv_matrix = ColorConvTable::BT601;
         ColorConvTable::YuvRangeType yuv_range = ColorConvTable::RANGE_TV;
@@ -178,6 +187,23 @@ public:
     }
 
     bool Render(SubPicDesc& dst, REFERENCE_TIME rt, float fps)
+    {
+        CComPtr<ISimpleSubPic> pSubPic;
+        {
+            CAutoLock cAutoLock(&s_csRender);
+            if(!LookupSubPic(dst, rt, &pSubPic))
+                return(false);
+        }
+
+        // The subpicture holds its own copy of the bitmaps, blending it needs no lock
+        if(dst.type == MSP_RGB32 || dst.type == MSP_RGB24 || dst.type == MSP_RGB16 || dst.type == MSP_RGB15)
+            dst.h = -dst.h;
+        pSubPic->AlphaBlt(&dst);
+
+        return(true);
+    }
+
+    bool LookupSubPic(const SubPicDesc& dst, REFERENCE_TIME rt, ISimpleSubPic** ppSubPic)
     {
         if(!m_pSubPicProvider)
             return(false);
@@ -211,6 +237,7 @@ public:
             {
                 CRenderedTextSubtitle* pRTS = dynamic_cast<CRenderedTextSubtitle*>((ISubPicProvider*)m_pSubPicProvider);
                 playres = pRTS->m_dstScreenSize;
+                pRTS->m_maxAnimationRate = m_xy_int_opt[INT_MAX_ANIMATION_RATE];
             }
             XySetSize(SIZE_ASS_PLAY_RESOLUTION, playres);
 
@@ -218,15 +245,7 @@ public:
             m_SubPicProviderId = (DWORD_PTR)(ISubPicProvider*)m_pSubPicProvider;
         }
 
-		CComPtr<ISimpleSubPic> pSubPic;
-		if(!m_simple_provider->LookupSubPic(rt, &pSubPic))
-			return(false);
-
-        if(dst.type == MSP_RGB32 || dst.type == MSP_RGB24 || dst.type == MSP_RGB16 || dst.type == MSP_RGB15)
-            dst.h = -dst.h;
-        pSubPic->AlphaBlt(&dst);
-
-        return(true);
+		return(m_simple_provider->LookupSubPic(rt, ppSubPic) && *ppSubPic);
     }
 
 	DWORD ThreadProc()
@@ -264,8 +283,22 @@ public:
 
 						if(CComQIPtr<ISubStream> pSubStream = m_pSubPicProvider)
 						{
-							CAutoLock cAutoLock(&m_csSubLock);
-							pSubStream->Reload();
+							REFERENCE_TIME rtInvalidate = 0;
+							CLSID clsid;
+							pSubStream->GetClassID(&clsid);
+							CRenderedTextSubtitle* pRTS = clsid == __uuidof(CRenderedTextSubtitle)
+								? dynamic_cast<CRenderedTextSubtitle*>((ISubStream*)pSubStream) : NULL;
+							// text scripts only drop the lines that were edited
+							if(!pRTS || !pRTS->ReloadChanges(&rtInvalidate))
+							{
+								CAutoLock cAutoLock(&m_csSubLock);
+								if(pRTS) pRTS->Open(pRTS->m_path, DEFAULT_CHARSET);
+								else pSubStream->Reload();
+								rtInvalidate = 0;
+							}
+							// the provider is created and read by the renders under s_csRender only
+							CAutoLock cAutoLock(&s_csRender);
+							if(m_simple_provider) m_simple_provider->Invalidate(rtInvalidate);
 						}
 					}
 				}
@@ -302,6 +335,8 @@ public:
 	}
 };
 
+CCritSec CFilter::s_csRender;
+
 class CVobSubFilter : virtual public CFilter
 {
 public:
@@ -315,6 +350,17 @@ public:
 		SetFileName(_T(""));
 		m_pSubPicProvider = NULL;
 
+		if(!fn.Right(4).CompareNoCase(_T(".sup")))
+		{
+			if(CSupFile* sup = new CSupFile(&m_csSubLock))
+			{
+				m_pSubPicProvider = (ISubPicProvider*)sup;
+				if(sup->Open(fn)) SetFileName(fn);
+				else m_pSubPicProvider = NULL;
+			}
+			return !!m_pSubPicProvider;
+		}
+
 		if(CVobSubFile* vsf = new CVobSubFile(&m_csSubLock))
 		{
 			m_pSubPicProvider = (ISubPicProvider*)vsf;
@@ -422,7 +468,7 @@ public:
                 AFX_MANAGE_STATE(AfxGetStaticModuleState());
 
                 CFileDialog fd(TRUE, NULL, GetFileName(), OFN_EXPLORER | OFN_ENABLESIZING | OFN_HIDEREADONLY,
-                               _T("VobSub files (*.idx;*.sub)|*.idx;*.sub||"), CWnd::FromHandle(hwnd), 0);
+                               _T("VobSub files (*.idx;*.sub;*.sup)|*.idx;*.sub;*.sup||"), CWnd::FromHandle(hwnd), 0);
 
                 if (fd.DoModal() != IDOK) {
                     return 1;
@@ -689,7 +735,7 @@ public:
                 AFX_MANAGE_STATE(AfxGetStaticModuleState());
 
                 CFileDialog fd(TRUE, NULL, GetFileName(), OFN_EXPLORER | OFN_ENABLESIZING | OFN_HIDEREADONLY,
-                               _T("VobSub files (*.idx;*.sub)|*.idx;*.sub||"), CWnd::FromHandle((HWND)hwnd), 0);
+                               _T("VobSub files (*.idx;*.sub;*.sup)|*.idx;*.sub;*.sup||"), CWnd::FromHandle((HWND)hwnd), 0);
 
                 if (fd.DoModal() != IDOK) {
                     return 1;
@@ -1030,12 +1076,37 @@ public:
 
         static bool s_fSwapUV = false;
 
+        // AviSynth+ 4:2:0 planar formats of more than 8 bits, unknown to the 2.5 headers: CS_YV12 with 
+        // the sample size in bits 16-18
+        // @return: the bit depth of such a format, 0 for any other
+        static int GetYuv420P16BitDepth(const VideoInfo& vi)
+        {
+            enum {CS_Sample_Bits_Mask = 7<<16};
+            if ((vi.pixel_type & ~CS_Sample_Bits_Mask) != VideoInfo::CS_YV12) {
+                return 0;
+            }
+            switch ((vi.pixel_type & CS_Sample_Bits_Mask) >> 16) {
+                case 5:
+                    return 10;
+                case 6:
+                    return 12;
+                case 7:
+                    return 14;
+                case 1:
+                    return 16;
+            }
+            return 0;   // 8 bits, or 32 bits float
+        }
+
         class CAvisynthFilter : public GenericVideoFilter, virtual public CFilter
         {
         public:
             VFRTranslator* vfr;
 
             CAvisynthFilter(PClip c, IScriptEnvironment* env, VFRTranslator* _vfr = 0) : GenericVideoFilter(c), vfr(_vfr) {}
+            virtual ~CAvisynthFilter() {
+                delete vfr;
+            }
 
             PVideoFrame __stdcall GetFrame(int n, IScriptEnvironment* env) {
                 PVideoFrame frame = child->GetFrame(n, env);
@@ -1051,7 +1122,12 @@ public:
                 dst.bitsU = frame->GetWritePtr(PLANAR_U);
                 dst.bitsV = frame->GetWritePtr(PLANAR_V);
                 dst.bpp = dst.pitch / dst.w * 8; //vi.BitsPerPixel();
+                int bit_depth = GetYuv420P16BitDepth(vi);
+                if (bit_depth) {
+                    dst.bpp = bit_depth;
+                }
                 dst.type =
+                    bit_depth ? MSP_YUV420P16 :
                     vi.IsRGB32() ? (env->GetVar("RGBA").AsBool() ? MSP_RGBA : MSP_RGB32)  :
                         vi.IsRGB24() ? MSP_RGB24 :
                         vi.IsYUY2() ? MSP_YUY2 :
@@ -1112,6 +1188,9 @@ public:
             VFRTranslator* vfr = 0;
             if (args[4].Defined()) {
                 vfr = GetVFRTranslator(args[4].AsString());
+                if (!vfr) {
+                    env->ThrowError("TextSub: Can't read the timecodes file \"%s\"", args[4].AsString());
+                }
             }
 
             return (DEBUG_NEW CTextSubAvisynthFilter(
@@ -1140,6 +1219,9 @@ public:
             VFRTranslator* vfr = 0;
             if (args[6].Defined()) {
                 vfr = GetVFRTranslator(args[6].AsString());
+                if (!vfr) {
+                    env->ThrowError("MaskSub: Can't read the timecodes file \"%s\"", args[6].AsString());
+                }
             }
 
             AVSValue rgb32("RGB32");
@@ -1171,6 +1253,20 @@ public:
                         vfr));
         }
 
+        // The filters only lock CFilter::s_csRender while rendering, so AviSynth+ may call GetFrame 
+        // from several threads on a single instance (MT_NICE_FILTER). AviSynth before AviSynth+ has 
+        // no SetFilterMTMode, nothing to register there.
+        static void SetFilterMTMode(IScriptEnvironment* env, const char* name)
+        {
+            enum {MT_NICE_FILTER = 1};
+            try {
+                AVSValue args[2] = {name, (int)MT_NICE_FILTER};
+                env->Invoke("SetFilterMTMode", AVSValue(args, 2));
+            } catch (IScriptEnvironment::NotFound) {
+            } catch (AvisynthError) {
+            }
+        }
+
         extern "C" __declspec(dllexport) const char* __stdcall AvisynthPluginInit2(IScriptEnvironment* env)
         {
             env->AddFunction("VobSub", "cs", VobSubCreateS, 0);
@@ -1178,6 +1274,9 @@ public:
             env->AddFunction("TextSubSwapUV", "b", TextSubSwapUV, 0);
             env->AddFunction("MaskSub", "[file]s[width]i[height]i[fps]f[length]i[charset]i[vfr]s", MaskSubCreate, 0);
             env->SetVar(env->SaveString("RGBA"), false);
+            SetFilterMTMode(env, "VobSub");
+            SetFilterMTMode(env, "TextSub");
+            SetFilterMTMode(env, "MaskSub");
             return NULL;
         }
     }
@@ -27,158 +27,179 @@
 #include "vfr.h"
 #include <stdio.h>
 #include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 #include <vector>
+#include <map>
+#include <string>
+#include <algorithm>
+#include <boost/shared_ptr.hpp>
 
 
 // Work with seconds per frame (spf) here instead of fps since that's more natural for the translation we're doing
 
 
-class TimecodesV1 : public VFRTranslator {
+// Both timecodes formats are expanded into the start time of every frame they describe, so that
+// a frame number is a lookup and a time a binary search, instead of a walk through the v1 sections.
+// The last timestamp is the first frame past the file, later frames go on at assumed_spf.
+struct TimecodesTable {
+	std::vector<double> timestamps;
+	double assumed_spf;
+};
+
+// v1 sections are expanded frame by frame, don't let a bogus "0,999999999,24" eat all the memory.
+// 2^24 frames is still more than a week at 24 fps.
+static const int MAX_TABLE_FRAMES = 1<<24;
+
+
+class TimecodesTranslator : public VFRTranslator {
 private:
-	// Used when sections run out
-	double default_spf;
-	double first_non_section_timestamp;
-	int first_non_section_frame;
-
-	// Also generate sections for unspecified ones
-	// (use the default framerate then)
-	struct FrameRateSection {
-		double start_time;
-		double spf;
-		int start_frame;
-		int end_frame;
-	};
-	std::vector<FrameRateSection> sections;
+	boost::shared_ptr<const TimecodesTable> table;
 
 public:
+	TimecodesTranslator(const boost::shared_ptr<const TimecodesTable> &_table) : table(_table) {}
+
 	virtual double TimeStampFromFrameNumber(int n)
 	{
-		// Find correct section
-		for (size_t i = 0; i < sections.size(); i++) {
-			FrameRateSection &sect = sections[i];
-			if (n >= sect.start_frame && n <= sect.end_frame) {
-				return sect.start_time + (n - sect.start_frame) * sect.spf;
-			}
-		}
-		// Not in a section
+		const std::vector<double> &ts = table->timestamps;
 		if (n < 0) return 0.0;
-		return first_non_section_timestamp + (n - first_non_section_frame) * default_spf;
+		if (n < (int)ts.size()) return ts[n];
+		return ts.back() + (n - (int)ts.size() + 1) * table->assumed_spf;
 	}
 
-	TimecodesV1(FILE *vfrfile)
+	virtual int FrameNumberFromTimeStamp(double t)
 	{
-		char buf[100];
-
-		default_spf = -1;
-		double cur_time = 0.0;
-
-		FrameRateSection temp_section;
-		temp_section.start_time = 0.0;
-		temp_section.spf = -1;
-		temp_section.start_frame = 0;
-		temp_section.end_frame = 0;
-
-		while (fgets(buf, 100, vfrfile)) {
-			// Comment?
-			if (buf[0] == '#') continue;
-
-			if (strnicmp(buf, "Assume ", 7) == 0 && default_spf < 0) {
-				char *num = buf+7;
-				default_spf = atof(num);
-				if (default_spf > 0)
-					default_spf = 1 / default_spf;
-				else
-					default_spf = -1;
-				temp_section.spf = default_spf;
-				continue;
-			}
-
-			int start_frame, end_frame;
-			float fps;
-			if (sscanf(buf, "%d,%d,%f", &start_frame, &end_frame, &fps) == 3) {
-				// Finish the current temp section
-				temp_section.end_frame = start_frame - 1;
-				if (temp_section.end_frame >= temp_section.start_frame) {
-					cur_time += (temp_section.end_frame - temp_section.start_frame + 1) * temp_section.spf;
-					sections.push_back(temp_section);
-				}
-				// Insert the section corresponding to this line
-				temp_section.spf = 1/fps;
-				temp_section.start_frame = start_frame;
-				temp_section.end_frame = end_frame;
-				temp_section.start_time = cur_time;
-				cur_time += (end_frame - start_frame + 1) / fps;
-				sections.push_back(temp_section);
-				// Begin new temp section
-				temp_section.spf = default_spf;
-				temp_section.start_frame = end_frame + 1;
-				temp_section.end_frame = end_frame; // yes, negative duration
-				temp_section.start_time = cur_time;
-			}
+		const std::vector<double> &ts = table->timestamps;
+		if (t >= ts.back()) {
+			if (table->assumed_spf <= 0) return (int)ts.size() - 1;
+			return (int)ts.size() - 1 + (int)((t - ts.back()) / table->assumed_spf);
 		}
-
-		first_non_section_timestamp = cur_time;
-		first_non_section_frame = temp_section.start_frame;
+		std::vector<double>::const_iterator it = std::upper_bound(ts.begin(), ts.end(), t);
+		return it == ts.begin() ? 0 : (int)(it - ts.begin()) - 1;
 	}
-
 };
 
 
-class TimecodesV2 : public VFRTranslator {
-private:
-	// Main data
-	std::vector<double> timestamps;
-	// For when data are exhausted (well, they shouldn't, then the vfr file is bad)
-	int last_known_frame;
-	double last_known_timestamp;
-	double assumed_spf;
+static bool ParseTimecodesV1(FILE *vfrfile, TimecodesTable *table)
+{
+	char buf[100];
+
+	std::vector<double> &ts = table->timestamps;
+	double default_spf = -1;
+	double cur_time = 0.0;
+
+	// Frames between the listed sections run at the default framerate
+	while (fgets(buf, 100, vfrfile)) {
+		// Comment?
+		if (buf[0] == '#') continue;
+
+		if (strnicmp(buf, "Assume ", 7) == 0 && default_spf < 0) {
+			char *num = buf+7;
+			default_spf = atof(num);
+			if (default_spf > 0)
+				default_spf = 1 / default_spf;
+			else
+				default_spf = -1;
+			continue;
+		}
 
-public:
-	virtual double TimeStampFromFrameNumber(int n)
-	{
-		if (n < (int)timestamps.size() && n >= 0) {
-			return timestamps[n];
+		int start_frame, end_frame;
+		float fps;
+		if (sscanf(buf, "%d,%d,%f", &start_frame, &end_frame, &fps) == 3 && fps > 0) {
+			if (start_frame >= MAX_TABLE_FRAMES) break;
+			start_frame = max(start_frame, 0);
+			end_frame = min(end_frame, MAX_TABLE_FRAMES - 1);
+			// Fill the gap up to this section
+			while ((int)ts.size() < start_frame) {
+				ts.push_back(cur_time);
+				cur_time += default_spf;
+			}
+			// Sections overlapping frames already listed keep the times of the first one
+			double section_time = cur_time - ((int)ts.size() - start_frame) / fps;
+			for (int n = (int)ts.size(); n <= end_frame; n++) {
+				ts.push_back(section_time + (n - start_frame) / fps);
+				cur_time = section_time + (n - start_frame + 1) / fps;
+			}
+			if (end_frame == MAX_TABLE_FRAMES - 1) {
+				default_spf = 1 / fps;
+				break;
+			}
 		}
-		if (n < 0) return 0.0;
-		return last_known_timestamp + (n - last_known_frame) * assumed_spf;
 	}
 
-	TimecodesV2(FILE *vfrfile)
-	{
-		char buf[50];
+	// First frame past the sections
+	ts.push_back(cur_time);
+	table->assumed_spf = default_spf;
+	return true;
+}
 
-		timestamps.reserve(8192); // should be enough for most cases
+static bool ParseTimecodesV2(FILE *vfrfile, TimecodesTable *table)
+{
+	char buf[50];
 
-		while (fgets(buf, 50, vfrfile)) {
-			// Comment?
-			if (buf[0] == '#') continue;
-			// Otherwise assume it's a good timestamp
-			timestamps.push_back(atof(buf)/1000);
-		}
+	std::vector<double> &ts = table->timestamps;
+	ts.reserve(8192); // should be enough for most cases
 
-		last_known_frame = (int)timestamps.size()-1;
-		last_known_timestamp = timestamps[last_known_frame];
-		assumed_spf = last_known_timestamp - timestamps[last_known_frame - 1];
+	while (fgets(buf, 50, vfrfile)) {
+		// Comment?
+		if (buf[0] == '#') continue;
+		// Otherwise assume it's a good timestamp
+		ts.push_back(atof(buf)/1000);
 	}
 
-};
-
+	// For when data are exhausted (well, they shouldn't, then the vfr file is bad)
+	if (ts.size() < 2) return false;
+	table->assumed_spf = ts.back() - ts[ts.size() - 2];
+	return true;
+}
 
-VFRTranslator *GetVFRTranslator(const char *vfrfile)
+static boost::shared_ptr<const TimecodesTable> ParseTimecodes(const char *vfrfile)
 {
+	boost::shared_ptr<TimecodesTable> table;
 	char buf[32];
 	buf[19] = 0; // In "# timecode format v1" the version number is character index 19
 	FILE *f = fopen(vfrfile, "r");
-	VFRTranslator *res = 0;
+	if (!f) return table;
 	if (fgets(buf, 32, f) && buf[0] == '#') {
 		// So do some really shoddy parsing here, assume the file is good
 		if (buf[19] == '1') {
-			res = new TimecodesV1(f);
+			table.reset(new TimecodesTable());
+			if (!ParseTimecodesV1(f, table.get())) table.reset();
 		} else if (buf[19] == '2') {
-			res = new TimecodesV2(f);
+			table.reset(new TimecodesTable());
+			if (!ParseTimecodesV2(f, table.get())) table.reset();
 		}
 	}
 	fclose(f);
-	return res;
+	return table;
 }
 
+
+struct CachedTimecodes {
+	__time64_t mtime;
+	__int64 size;
+	boost::shared_ptr<const TimecodesTable> table;
+};
+
+static CCritSec s_csTimecodesCache;
+static std::map<std::string, CachedTimecodes> s_timecodesCache;
+
+VFRTranslator *GetVFRTranslator(const char *vfrfile)
+{
+	struct _stat64 st;
+	if (_stat64(vfrfile, &st) != 0) return 0;
+
+	CAutoLock cAutoLock(&s_csTimecodesCache);
+
+	CachedTimecodes &cached = s_timecodesCache[vfrfile];
+	if (!cached.table || cached.mtime != st.st_mtime || cached.size != st.st_size) {
+		cached.table = ParseTimecodes(vfrfile);
+		cached.mtime = st.st_mtime;
+		cached.size = st.st_size;
+	}
+	if (!cached.table) {
+		s_timecodesCache.erase(vfrfile);
+		return 0;
+	}
+	return new TimecodesTranslator(cached.table);
+}
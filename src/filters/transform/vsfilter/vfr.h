@@ -29,9 +29,16 @@
 
 class VFRTranslator {
 public:
+	virtual ~VFRTranslator() {}
+	// Start time of frame n in seconds, O(1)
 	virtual double TimeStampFromFrameNumber(int n) = 0;
+	// The frame shown at time t (seconds), the last one starting at or before t, O(log n)
+	virtual int FrameNumberFromTimeStamp(double t) = 0;
 };
 
+// Returns 0 if the file can't be read or isn't a v1 or v2 timecodes file.
+// Parsed files are cached as long as they don't change on disk, opening the same timecodes
+// again (several TextSub calls, AviSynth+ instances) only costs a stat.
 VFRTranslator *GetVFRTranslator(const char *vfrfile);
 
 #endif
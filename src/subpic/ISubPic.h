@@ -40,7 +40,8 @@ enum ColorType {
     MSP_P010,
     MSP_P016,
     MSP_NV12,
-    MSP_NV21
+    MSP_NV21,
+    MSP_YUV420P16 //planar 4:2:0 with 16 bits samples, of which the bpp low bits are significant (AviSynth+ YUV420P10 to YUV420P16)
 };
 
 #pragma pack(push, 1)
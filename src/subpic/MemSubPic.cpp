@@ -325,7 +325,8 @@ STDMETHODIMP CMemSubPic::Unlock( CAtlList<CRect>* dirtyRectList )
                                 dst_type == MSP_P010 ||
                                 dst_type == MSP_P016 ||
                                 dst_type == MSP_NV12 ||
-                                dst_type == MSP_NV21)))
+                                dst_type == MSP_NV21 ||
+                                dst_type == MSP_YUV420P16)))
     {
         return UnlockOther(dirtyRectList);        
     }
@@ -336,7 +337,8 @@ STDMETHODIMP CMemSubPic::Unlock( CAtlList<CRect>* dirtyRectList )
                                    dst_type == MSP_NV12 ||
                                    dst_type == MSP_NV21 ||
                                    dst_type == MSP_P010 ||
-                                   dst_type == MSP_P016))
+                                   dst_type == MSP_P016 ||
+                                   dst_type == MSP_YUV420P16))
     {
         return UnlockRGBA_YUV(dirtyRectList);
     }
@@ -411,7 +413,7 @@ HRESULT CMemSubPic::UnlockOther(CAtlList<CRect>* dirtyRectList)
             XY_DO_ONCE( xy_logger::write_file("G:\\a1_ul", top, m_spd.pitch*(h-1)) );
         }
         else if(m_alpha_blt_dst_type == MSP_YV12 || m_alpha_blt_dst_type == MSP_IYUV 
-            || m_alpha_blt_dst_type == MSP_AYUV)
+            || m_alpha_blt_dst_type == MSP_AYUV || m_alpha_blt_dst_type == MSP_YUV420P16)
         {
             //nothing to do
         }
@@ -460,7 +462,8 @@ HRESULT CMemSubPic::UnlockRGBA_YUV(CAtlList<CRect>* dirtyRectList)
             m_alpha_blt_dst_type == MSP_P010 ||
             m_alpha_blt_dst_type == MSP_P016 ||
             m_alpha_blt_dst_type == MSP_NV12 ||
-            m_alpha_blt_dst_type == MSP_NV21) {
+            m_alpha_blt_dst_type == MSP_NV21 ||
+            m_alpha_blt_dst_type == MSP_YUV420P16) {
             for(; top < bottom ; top += m_spd.pitch) {
                 BYTE* s = top;
                 BYTE* e = s + w*4;
@@ -568,6 +571,10 @@ STDMETHODIMP CMemSubPic::AlphaBlt( const RECT* pSrc, const RECT* pDst, SubPicDes
                                            dst_type == MSP_P016 ) )
     {
         return AlphaBltAnv12_P010(pSrc, pDst, pTarget);
+    }
+    else if( src_type==MSP_AYUV_PLANAR && dst_type == MSP_YUV420P16 )
+    {
+        return AlphaBltYuv420P16(pSrc, pDst, pTarget);
     }
     else if( src_type==MSP_RGBA && (dst_type == MSP_IYUV ||
                                     dst_type == MSP_YV12)) 
@@ -584,6 +591,10 @@ STDMETHODIMP CMemSubPic::AlphaBlt( const RECT* pSrc, const RECT* pDst, SubPicDes
     {
         return AlphaBltAxyuAxyv_P010(pSrc, pDst, pTarget);
     }
+    else if( src_type==MSP_RGBA && dst_type == MSP_YUV420P16 )
+    {
+        return AlphaBltAxyuAxyv_Yuv420P16(pSrc, pDst, pTarget);
+    }
     return E_NOTIMPL;
 }
 
@@ -978,6 +989,97 @@ HRESULT CMemSubPic::AlphaBltAxyuAxyv_Yv12(const RECT* pSrc, const RECT* pDst, Su
     return S_OK;
 }
 
+HRESULT CMemSubPic::AlphaBltAxyuAxyv_Yuv420P16(const RECT* pSrc, const RECT* pDst, SubPicDesc* pTarget)
+{
+    const SubPicDesc& src = m_spd;
+    SubPicDesc dst = *pTarget; // copy, because we might modify it
+
+    CRect rs(*pSrc), rd(*pDst);
+
+    if(dst.h < 0) {
+        dst.h = -dst.h;
+        rd.bottom = dst.h - rd.bottom;
+        rd.top = dst.h - rd.top;
+    }
+
+    if(rs.Width() != rd.Width() || rs.Height() != abs(rd.Height())) {
+        return E_INVALIDARG;
+    }
+
+    int w = rs.Width(), h = rs.Height();
+    int shift = ((dst.bpp > 8 && dst.bpp <= 16) ? dst.bpp : 16) - 8;
+
+    //Y
+    BYTE* s = static_cast<BYTE*>(src.bits) + src.pitch*rs.top + rs.left*4;
+    BYTE* d = static_cast<BYTE*>(dst.bits) + dst.pitch*rd.top + rd.left*2;
+    int pitch = dst.pitch;
+
+    if(rd.top > rd.bottom) {
+        d = static_cast<BYTE*>(dst.bits) + dst.pitch*(rd.top-1) + rd.left*2;
+
+        pitch = -pitch;
+    }
+
+    for(ptrdiff_t j = 0; j < h; j++, s += src.pitch, d += pitch) {
+        BYTE* s2 = s;
+        BYTE* s2end = s2 + w*4;
+        WORD* d2 = reinterpret_cast<WORD*>(d);
+        for(; s2 < s2end; s2 += 4, d2++) {
+            if(s2[3] < 0xff) {
+                d2[0] = ((d2[0]*s2[3])>>8) + (s2[1]<<shift);
+            }
+        }
+    }
+
+    //UV, AxYU AxYV after UnlockRGBA_YUV
+    int h2 = h/2;
+
+    if(!dst.pitchUV) {
+        dst.pitchUV = abs(dst.pitch)/2;
+    }
+    if(!dst.bitsU || !dst.bitsV) {
+        dst.bitsU = static_cast<BYTE*>(dst.bits) + abs(dst.pitch)*dst.h;
+        dst.bitsV = dst.bitsU + dst.pitchUV*dst.h/2;
+    }
+
+    BYTE* ss[2];
+    ss[0] = static_cast<BYTE*>(src.bits) + src.pitch*rs.top + rs.left*4;
+    ss[1] = ss[0] + 4;
+
+    BYTE* dd[2];
+    dd[0] = dst.bitsU + dst.pitchUV*rd.top/2 + (rd.left/2)*2;
+    dd[1] = dst.bitsV + dst.pitchUV*rd.top/2 + (rd.left/2)*2;
+
+    if(rd.top > rd.bottom) {
+        dd[0] = dst.bitsU + dst.pitchUV*(rd.top/2-1) + (rd.left/2)*2;
+        dd[1] = dst.bitsV + dst.pitchUV*(rd.top/2-1) + (rd.left/2)*2;
+        dst.pitchUV = -dst.pitchUV;
+    }
+
+    for(ptrdiff_t i = 0; i < 2; i++) {
+        s = ss[i];
+        d = dd[i];
+        BYTE* a = ss[0]+3;
+        for(ptrdiff_t j = 0; j < h2; j++, s += src.pitch*2, d += dst.pitchUV, a += src.pitch*2) {
+            BYTE* s2 = s;
+            BYTE* s2end = s2 + w*4;
+            WORD* d2 = reinterpret_cast<WORD*>(d);
+            BYTE* a2 = a;
+
+            DWORD last_alpha = a2[0]+a2[0+src.pitch];
+            for(; s2 < s2end; s2 += 8, d2++, a2 += 8) {
+                unsigned int ia = (last_alpha + 2*(a2[0]+a2[0+src.pitch]) + a2[4] + a2[4+src.pitch] + 4 )>>3;
+                last_alpha = a2[4] + a2[4+src.pitch];
+                if(ia < 0xff) {
+                    *d2 = ((*d2*ia)>>8) + (((s2[0]+s2[src.pitch])<<shift)>>1);
+                }
+            }
+        }
+    }
+
+    return S_OK;
+}
+
 HRESULT CMemSubPic::AlphaBltAxyuAxyv_Nv12(const RECT* pSrc, const RECT* pDst, SubPicDesc* pTarget)
 {
     ONCER( SaveArgb2File(*pTarget, CRect(CPoint(0,0), m_size), "F:/mplayer_MinGW_full/MinGW/home/Administrator/xy_vsfilter/debug.nv12") );
@@ -1155,6 +1257,29 @@ HRESULT CMemSubPic::AlphaBltAnv12_Nv12( const RECT* pSrc, const RECT* pDst, SubP
     return AlphaBltAnv12_Nv12(sa, sy, s_uv, src.pitch, d, dUV, dst.pitch, w, h);
 }
 
+HRESULT CMemSubPic::AlphaBltYuv420P16( const RECT* pSrc, const RECT* pDst, SubPicDesc* pTarget )
+{
+    const SubPicDesc& src = m_spd;
+    SubPicDesc dst = *pTarget; // copy, because we might modify it
+
+    CRect rs(*pSrc), rd(*pDst);
+    if(dst.h < 0)
+    {
+        dst.h = -dst.h;
+        rd.bottom = dst.h - rd.bottom;
+        rd.top = dst.h - rd.top;
+    }
+    if(rs.Width() != rd.Width() || rs.Height() != abs(rd.Height())) {
+        return E_INVALIDARG;
+    }
+
+    const BYTE* sa = reinterpret_cast<const BYTE*>(src.bits) + src.pitch*rs.top + rs.left;
+    const BYTE* sy = sa + src.pitch*src.h;
+    const BYTE* su = sy + src.pitch*src.h;
+    const BYTE* sv = su + src.pitch*src.h;
+    return AlphaBltYuv420P16(sa, sy, su, sv, src.pitch, dst, rd, rs.Width(), rs.Height());
+}
+
 STDMETHODIMP CMemSubPic::SetDirtyRectEx(CAtlList<CRect>* dirtyRectList )
 {
     //if(m_spd.type == MSP_YUY2 || m_spd.type == MSP_YV12 || m_spd.type == MSP_IYUV || m_spd.type == MSP_AYUV)
@@ -1163,7 +1288,8 @@ STDMETHODIMP CMemSubPic::SetDirtyRectEx(CAtlList<CRect>* dirtyRectList )
         POSITION pos = dirtyRectList->GetHeadPosition();
         if(m_spd.type == MSP_AYUV_PLANAR || m_alpha_blt_dst_type==MSP_IYUV || m_alpha_blt_dst_type==MSP_YV12 
             || m_alpha_blt_dst_type==MSP_P010 || m_alpha_blt_dst_type==MSP_P016 
-            || m_alpha_blt_dst_type==MSP_NV12 || m_alpha_blt_dst_type==MSP_NV21 )
+            || m_alpha_blt_dst_type==MSP_NV12 || m_alpha_blt_dst_type==MSP_NV21 
+            || m_alpha_blt_dst_type==MSP_YUV420P16 )
         {
             while(pos!=NULL)
             {
@@ -1560,6 +1686,84 @@ void CMemSubPic::SubsampleAndInterlaceC( BYTE* dst, const BYTE* u, const BYTE* v
     }
 }
 
+HRESULT CMemSubPic::AlphaBltYuv420P16( const BYTE* src_a, const BYTE* src_y, const BYTE* src_u, const BYTE* src_v, 
+    int src_pitch, SubPicDesc& dst, const CRect& rd, int w, int h )
+{
+    int bit_depth = (dst.bpp > 8 && dst.bpp <= 16) ? dst.bpp : 16;
+    if(!dst.pitchUV)
+    {
+        dst.pitchUV = abs(dst.pitch)/2;
+    }
+    if(!dst.bitsU || !dst.bitsV)
+    {
+        dst.bitsU = reinterpret_cast<BYTE*>(dst.bits) + abs(dst.pitch)*dst.h;
+        dst.bitsV = dst.bitsU + dst.pitchUV*dst.h/2;
+    }
+
+    int top = rd.top, top_uv = rd.top/2;
+    int pitch = dst.pitch, pitch_uv = dst.pitchUV;
+    if(rd.top > rd.bottom)
+    {
+        top = rd.top-1;
+        top_uv = rd.top/2-1;
+        pitch = -pitch;
+        pitch_uv = -pitch_uv;
+    }
+    BYTE* d = reinterpret_cast<BYTE*>(dst.bits) + dst.pitch*top + rd.left*2;
+    BYTE* du = dst.bitsU + dst.pitchUV*top_uv + (rd.left/2)*2;
+    BYTE* dv = dst.bitsV + dst.pitchUV*top_uv + (rd.left/2)*2;
+
+    AlphaBltYuv420P16Luma(d, pitch, w, h, src_y, src_a, src_pitch, bit_depth);
+    AlphaBltYuv420P16Chroma(du, pitch_uv, w, h/2, src_u, src_a, src_pitch, bit_depth);
+    AlphaBltYuv420P16Chroma(dv, pitch_uv, w, h/2, src_v, src_a, src_pitch, bit_depth);
+    return S_OK;
+}
+
+void CMemSubPic::AlphaBltYuv420P16Luma( BYTE* dst, int dst_pitch, int w, int h, const BYTE* sub, const BYTE* alpha, 
+    int sub_pitch, int bit_depth )
+{
+    int shift = bit_depth - 8;
+    bool fSSE2 = !!(g_cpuid.m_flags & CCpuID::sse2);
+    for(int i=0; i<h; i++, dst += dst_pitch, alpha += sub_pitch, sub += sub_pitch)
+    {
+        WORD* d = reinterpret_cast<WORD*>(dst);
+        int x = 0;
+        if(fSSE2)
+        {
+            __m128i zero = _mm_setzero_si128();
+            __m128i opaque = _mm_set1_epi16(0xff);
+            __m128i shift128 = _mm_cvtsi32_si128(shift);
+            for(; x+8 <= w; x += 8)
+            {
+                __m128i a = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(alpha+x)), zero);
+                __m128i s = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(sub+x)), zero);
+                __m128i d8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(d+x));
+                __m128i keep = _mm_cmpeq_epi16(a, opaque);
+                //(d*a)>>8 is the high word of d*(a<<8)
+                __m128i mixed = _mm_add_epi16(_mm_mulhi_epu16(d8, _mm_slli_epi16(a, 8)), _mm_sll_epi16(s, shift128));
+                mixed = _mm_or_si128(_mm_and_si128(keep, d8), _mm_andnot_si128(keep, mixed));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(d+x), mixed);
+            }
+        }
+        for(; x < w; x++)
+        {
+            if(alpha[x] < 0xff)
+            {
+                d[x] = ((d[x]*alpha[x])>>8) + (sub[x]<<shift);
+            }
+        }
+    }
+}
+
+void CMemSubPic::AlphaBltYuv420P16Chroma( BYTE* dst, int dst_pitch, int w, int chroma_h, const BYTE* sub_chroma, 
+    const BYTE* alpha, int sub_pitch, int bit_depth )
+{
+    for(int j = 0; j < chroma_h; j++, sub_chroma += sub_pitch*2, alpha += sub_pitch*2, dst += dst_pitch)
+    {
+        hleft_vmid_mix_uv_yuv420p16_c(dst, w, sub_chroma, alpha, sub_pitch, bit_depth - 8);
+    }
+}
+
 void CMemSubPic::AlphaBlt_YUY2(int w, int h, BYTE* d, int dstpitch, PCUINT8 s, int srcpitch)
 {
 #ifdef _WIN64
@@ -1595,6 +1799,7 @@ CMemSubPicAllocator::CMemSubPicAllocator(int alpha_blt_dst_type, SIZE maxsize, i
         case MSP_P016:
         case MSP_NV12:
         case MSP_NV21:
+        case MSP_YUV420P16:
             m_type = MSP_AYUV_PLANAR;
             break;
         default:
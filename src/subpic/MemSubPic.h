@@ -53,6 +53,14 @@ public:
 
     static void AlphaBlt_YUY2(int w, int h, BYTE* d, int dstpitch, PCUINT8 s, int srcpitch);
 
+    // MSP_YUV420P16 target: @dst.bpp is the bit depth, @rd is upside down for bottom up targets
+    static HRESULT AlphaBltYuv420P16(const BYTE* src_a, const BYTE* src_y, const BYTE* src_u, const BYTE* src_v, 
+        int src_pitch, SubPicDesc& dst, const CRect& rd, int w, int h);
+    static void AlphaBltYuv420P16Luma(BYTE* dst, int dst_pitch, int w, int h, const BYTE* sub, const BYTE* alpha, 
+        int sub_pitch, int bit_depth);
+    static void AlphaBltYuv420P16Chroma(BYTE* dst, int dst_pitch, int w, int chroma_h, const BYTE* sub_chroma, 
+        const BYTE* alpha, int sub_pitch, int bit_depth);
+
     static void SubsampleAndInterlace(BYTE* dst, const BYTE* u, const BYTE* v, int h, int w, int pitch);
     static void SubsampleAndInterlaceC(BYTE* dst, const BYTE* u, const BYTE* v, int h, int w, int pitch);
 public:
@@ -83,8 +91,10 @@ protected:
     HRESULT AlphaBltAxyuAxyv_P010(const RECT* pSrc, const RECT* pDst, SubPicDesc* pTarget);
     HRESULT AlphaBltAxyuAxyv_Yv12(const RECT* pSrc, const RECT* pDst, SubPicDesc* pTarget);
     HRESULT AlphaBltAxyuAxyv_Nv12(const RECT* pSrc, const RECT* pDst, SubPicDesc* pTarget);
+    HRESULT AlphaBltAxyuAxyv_Yuv420P16(const RECT* pSrc, const RECT* pDst, SubPicDesc* pTarget);
     HRESULT AlphaBltAnv12_P010(const RECT* pSrc, const RECT* pDst, SubPicDesc* pTarget);   
     HRESULT AlphaBltAnv12_Nv12(const RECT* pSrc, const RECT* pDst, SubPicDesc* pTarget);
+    HRESULT AlphaBltYuv420P16(const RECT* pSrc, const RECT* pDst, SubPicDesc* pTarget);
     HRESULT AlphaBltOther(const RECT* pSrc, const RECT* pDst, SubPicDesc* pTarget);
 
     HRESULT UnlockRGBA_YUV(CAtlList<CRect>* dirtyRectList);
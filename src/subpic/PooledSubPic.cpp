@@ -94,6 +94,7 @@ CPooledSubPicAllocator::CPooledSubPicAllocator( int alpha_blt_dst_type, SIZE max
         case MSP_P016:
         case MSP_NV12:
         case MSP_NV21:
+        case MSP_YUV420P16:
             _type = MSP_AYUV_PLANAR;
             break;
         default:
@@ -187,7 +188,8 @@ STDMETHODIMP_(bool) CPooledSubPicAllocator::IsSpdColorTypeSupported( int type )
                             _alpha_blt_dst_type == MSP_P010 ||
                             _alpha_blt_dst_type == MSP_P016 ||
                             _alpha_blt_dst_type == MSP_NV12 ||
-                            _alpha_blt_dst_type == MSP_NV21)) )
+                            _alpha_blt_dst_type == MSP_NV21 ||
+                            _alpha_blt_dst_type == MSP_YUV420P16)) )
     {
         return true;
     }
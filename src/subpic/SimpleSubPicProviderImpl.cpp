@@ -280,7 +280,8 @@ bool SimpleSubPicProvider::IsSpdColorTypeSupported( int type )
                                     m_alpha_blt_dst_type == MSP_P010 ||
                                     m_alpha_blt_dst_type == MSP_P016 ||
                                     m_alpha_blt_dst_type == MSP_NV12 ||
-                                    m_alpha_blt_dst_type == MSP_NV21)) )
+                                    m_alpha_blt_dst_type == MSP_NV21 ||
+                                    m_alpha_blt_dst_type == MSP_YUV420P16)) )
     {
         return true;
     }
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "SimpleSubPicWrapper.h"
+#include "../subtitles/xy_render_timing.h"
 
 //////////////////////////////////////////////////////////////////////////
 //
@@ -29,6 +30,7 @@ STDMETHODIMP SimpleSubPicWrapper::NonDelegatingQueryInterface( REFIID riid, void
 
 STDMETHODIMP SimpleSubPicWrapper::AlphaBlt(SubPicDesc* target)
 {
+    XyRenderTiming::FlatScope timing(XyRenderTiming::ALPHA_BLEND);
     if (m_inner_obj)
     {
         CAtlList<const CRect> rect_list;
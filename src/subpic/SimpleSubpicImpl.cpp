@@ -3,6 +3,7 @@
 #include "ISimpleSubPic.h"
 #include "xy_intrinsics.h"
 #include "../subtitles/xy_malloc.h"
+#include "../subtitles/xy_render_timing.h"
 #include "MemSubPic.h"
 
 //////////////////////////////////////////////////////////////////////////
@@ -34,6 +35,7 @@ STDMETHODIMP SimpleSubpic::NonDelegatingQueryInterface( REFIID riid, void** ppv
 STDMETHODIMP SimpleSubpic::AlphaBlt( SubPicDesc* target )
 {
     ASSERT(target!=NULL);
+    XyRenderTiming::FlatScope timing(XyRenderTiming::ALPHA_BLEND);
     HRESULT hr = S_FALSE;
     int count = m_bitmap.GetCount();
     for(int i=0;i<count;i++)
@@ -48,6 +50,9 @@ STDMETHODIMP SimpleSubpic::AlphaBlt( SubPicDesc* target )
         case MSP_P016:
             hr = AlphaBltAnv12_P010(target, m_bitmap.GetAt(i));
             break;
+        case MSP_YUV420P16:
+            hr = AlphaBltYuv420P16(target, m_bitmap.GetAt(i));
+            break;
         default:
             hr = AlphaBlt(target, m_bitmap.GetAt(i));
             break;
@@ -138,6 +143,26 @@ HRESULT SimpleSubpic::AlphaBltAnv12_Nv12( SubPicDesc* target, const Bitmap& src
     return CMemSubPic::AlphaBltAnv12_Nv12(sa, sy, s_uv, src.pitch, d, dUV, dst.pitch, w, h);
 }
 
+HRESULT SimpleSubpic::AlphaBltYuv420P16( SubPicDesc* target, const Bitmap& src )
+{
+    SubPicDesc dst = *target; // copy, because we might modify it
+
+    CRect rd(src.pos, src.size);
+    if(dst.h < 0)
+    {
+        dst.h = -dst.h;
+        rd.bottom = dst.h - rd.bottom;
+        rd.top = dst.h - rd.top;
+    }
+
+    enum PLANS{A=0,Y,U,V};
+    const BYTE* sa = reinterpret_cast<const BYTE*>(src.extra.plans[A]);
+    const BYTE* sy = reinterpret_cast<const BYTE*>(src.extra.plans[Y]);
+    const BYTE* su = reinterpret_cast<const BYTE*>(src.extra.plans[U]);
+    const BYTE* sv = reinterpret_cast<const BYTE*>(src.extra.plans[V]);
+    return CMemSubPic::AlphaBltYuv420P16(sa, sy, su, sv, src.pitch, dst, rd, src.size.cx, src.size.cy);
+}
+
 HRESULT SimpleSubpic::AlphaBlt( SubPicDesc* target, const Bitmap& src )
 {
     SubPicDesc dst = *target; // copy, because we might modify it
@@ -449,7 +474,8 @@ HRESULT SimpleSubpic::ConvertColorSpace()
             }            
             XY_DO_ONCE( xy_logger::write_file("G:\\a1_ul", dst, bitmap.pitch*(h-1)) );
         }
-        else if(m_alpha_blt_dst_type == MSP_YV12 || m_alpha_blt_dst_type == MSP_IYUV )
+        else if(m_alpha_blt_dst_type == MSP_YV12 || m_alpha_blt_dst_type == MSP_IYUV 
+            || m_alpha_blt_dst_type == MSP_YUV420P16 )
         {
             ASSERT(xy_color_space==XY_CS_AYUV_PLANAR);
             //nothing to do
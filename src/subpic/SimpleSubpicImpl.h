@@ -30,6 +30,7 @@ private:
 
     HRESULT AlphaBltAnv12_P010( SubPicDesc* target, const Bitmap& src );
     HRESULT AlphaBltAnv12_Nv12(SubPicDesc* target, const Bitmap& src);
+    HRESULT AlphaBltYuv420P16(SubPicDesc* target, const Bitmap& src);
     HRESULT AlphaBlt(SubPicDesc* target, const Bitmap& src);
     HRESULT ConvertColorSpace();
     void SubsampleAndInterlace(int index, Bitmap*bitmap, bool u_first );
@@ -691,6 +691,38 @@ static __forceinline void hleft_vmid_mix_uv_p010_c(BYTE* dst, int w, const BYTE*
     }
 }
 
+//Same as hleft_vmid_mix_uv_yv12_c, on planar 16 bits samples of 8+shift bits
+static __forceinline void hleft_vmid_mix_uv_yuv420p16_c(BYTE* dst, int w, const BYTE* src, const BYTE* am, int src_pitch, int shift, int last_src_id=0)
+{
+    int last_alpha = (am[last_src_id]+am[last_src_id+src_pitch]+1)/2;
+    int last_sub = (src[last_src_id]+src[last_src_id+src_pitch]+1)/2;
+    const BYTE* end = src + w;
+    WORD* dst_word = reinterpret_cast<WORD*>(dst);
+    for(; src < end; src += 2, am += 2, dst_word++)
+    {
+        int ia = (am[0]+am[0+src_pitch]+1)/2;
+        int tmp1 = (am[1]+am[1+src_pitch]+1)/2;
+        last_alpha = (last_alpha + tmp1 + 1)/2;
+        ia = (ia + last_alpha + 1)/2;
+        last_alpha = tmp1;
+
+        if(ia!=0xff)
+        {
+            tmp1 = (src[0]+src[0+src_pitch]+1)/2;
+            int tmp2 = (src[1]+src[1+src_pitch]+1)/2;
+            last_sub = (last_sub+tmp2+1)/2;
+            tmp1 = (tmp1+last_sub+1)/2;
+            last_sub = tmp2;
+
+            *dst_word = (((*dst_word)*ia)>>8) + (tmp1<<shift);
+        }
+        else
+        {
+            last_sub = (src[1]+src[1+src_pitch]+1)/2;
+        }
+    }
+}
+
 //0<=w15<=15
 static __forceinline void hleft_vmid_mix_uv_p010_c2(BYTE* dst, int w15, const BYTE* src, const BYTE* am, int src_pitch, int last_src_id=0)
 {
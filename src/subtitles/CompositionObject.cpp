@@ -22,6 +22,8 @@
 #include "CompositionObject.h"
 #include "../DSUtil/GolombBuffer.h"
 #include "../subpic/color_conv_table.h"
+#include "../dsutil/vd.h"
+#include <emmintrin.h>
 
 
 CompositionObject::CompositionObject()
@@ -29,8 +31,15 @@ CompositionObject::CompositionObject()
     m_pRLEData      = NULL;
     m_nRLEDataSize  = 0;
     m_nRLEPos       = 0;
+    m_pIndexes.reset(DEBUG_NEW DecodedIndexes());
+
+    m_OriginalColorType    = NONE;
+    m_OriginalYuvRangeType = RANGE_NONE;
+    m_colorType     = -1;
 	
     memsetd(m_Colors, 0x00000000, sizeof(m_Colors));
+    m_nLutTransparent = 0xFF;
+    InitBlendLut();
 }
 
 CompositionObject::~CompositionObject()
@@ -40,6 +49,11 @@ CompositionObject::~CompositionObject()
 
 void CompositionObject::SetPalette(int nNbEntry, HDMV_PALETTE* pPalette, ColorType color_type, YuvRangeType yuv_range)
 {
+    if (color_type == m_OriginalColorType && yuv_range == m_OriginalYuvRangeType
+            && nNbEntry == (int)m_Palette.GetCount()
+            && (nNbEntry <= 0 || memcmp(m_Palette.GetData(), pPalette, nNbEntry * sizeof(pPalette[0])) == 0)) {
+        return;   // Same palette, keep the colors already converted by InitColor
+    }
     m_OriginalColorType = color_type;
     m_OriginalYuvRangeType = yuv_range;
 
@@ -304,6 +318,7 @@ void CompositionObject::InitColor(const SubPicDesc& spd)
             ASSERT(0);
             return;
         }
+        InitBlendLut();
     }
 }
 
@@ -313,6 +328,7 @@ void CompositionObject::SetRLEData(const BYTE* pBuffer, int nSize, int nTotalSiz
     m_pRLEData     = DEBUG_NEW BYTE[nTotalSize];
     m_nRLEDataSize = nTotalSize;
     m_nRLEPos      = nSize;
+    m_pIndexes.reset(DEBUG_NEW DecodedIndexes());
 
     memcpy(m_pRLEData, pBuffer, nSize);
 }
@@ -323,9 +339,19 @@ void CompositionObject::AppendRLEData(const BYTE* pBuffer, int nSize)
     if (m_nRLEPos + nSize <= m_nRLEDataSize) {
         memcpy(m_pRLEData + m_nRLEPos, pBuffer, nSize);
         m_nRLEPos += nSize;
+        m_pIndexes.reset(DEBUG_NEW DecodedIndexes());
     }
 }
 
+void CompositionObject::SetObjectData(const CompositionObject& source)
+{
+    m_width = source.m_width;
+    m_height = source.m_height;
+
+    SetRLEData(source.m_pRLEData, source.m_nRLEDataSize, source.m_nRLEDataSize);
+    m_pIndexes = source.m_pIndexes;
+}
+
 
 void CompositionObject::RenderHdmv(SubPicDesc& spd)
 {
@@ -333,15 +359,35 @@ void CompositionObject::RenderHdmv(SubPicDesc& spd)
         return;
     }
 
+    if (!m_pIndexes->IsDecoded(m_width, m_height)) {
+        DecodeHdmv();
+    }
+    BlendIndexes(spd, m_horizontal_position, m_vertical_position);
+}
+
+void CompositionObject::DecodeHdmv()
+{
+    CAtlArray<BYTE>& indexes = m_pIndexes->data;
+    m_pIndexes->bDecoded = true;
+    m_pIndexes->width = m_width;
+    m_pIndexes->height = m_height;
+    if (m_width <= 0 || m_height <= 0) {
+        indexes.RemoveAll();
+        return;
+    }
+    indexes.SetCount(m_width * m_height);
+    BYTE* pIndexes = indexes.GetData();
+    memset(pIndexes, 0xFF, indexes.GetCount());
+
     CGolombBuffer GBuffer(m_pRLEData, m_nRLEDataSize);
     BYTE  bTemp;
     BYTE  bSwitch;
     BYTE  nPaletteIndex = 0;
     short nCount;
-    short nX = m_horizontal_position;
-    short nY = m_vertical_position;
+    short nX = 0;
+    short nY = 0;
 
-    while ((nY < (m_vertical_position + m_height)) && !GBuffer.IsEOF()) {
+    while ((nY < m_height) && !GBuffer.IsEOF()) {
         bTemp = GBuffer.ReadByte();
         if (bTemp != 0) {
             nPaletteIndex = bTemp;
@@ -370,13 +416,156 @@ void CompositionObject::RenderHdmv(SubPicDesc& spd)
         }
 
         if (nCount > 0) {
-            if (nPaletteIndex != 0xFF) {    // Fully transparent (§9.14.4.2.2.1.1)
-                FillSolidRect(spd, nX, nY, nCount, 1, m_Colors[nPaletteIndex]);
+            // 0xFF is fully transparent (§9.14.4.2.2.1.1), which is also what the bitmap is cleared to
+            if (nPaletteIndex != 0xFF && nX < m_width) {
+                memset(pIndexes + nY * m_width + nX, nPaletteIndex, min(nCount, m_width - nX));
             }
             nX += nCount;
         } else {
             nY++;
-            nX = m_horizontal_position;
+            nX = 0;
+        }
+    }
+}
+
+// Same blending as Rasterizer::FillSolidRect: d = (d*(256-a) + c*(a+1))>>8 for every channel, 
+// with the alpha channel blended against 0. Index m_nLutTransparent (0xFF unless a DVB object 
+// uses it) is left as it is.
+void CompositionObject::InitBlendLut()
+{
+    for (int i = 0; i < 256; i++) {
+        DWORD color = m_Colors[i];
+        int a = (i != m_nLutTransparent) ? (color >> 24) : 0;
+        for (int c = 0; c < 3; c++) {
+            m_BlendLut[i][c] = (WORD)(((color >> (8 * c)) & 0xFF) * (a + 1));
+        }
+        m_BlendLut[i][3] = 0;
+        for (int c = 4; c < 8; c++) {
+            m_BlendLut[i][c] = (WORD)(0x100 - a);
+        }
+    }
+}
+
+static __forceinline __m128i BlendLutGather8(const WORD (*lut)[8], const BYTE* idx, int c)
+{
+    return _mm_setr_epi16(lut[idx[0]][c], lut[idx[1]][c], lut[idx[2]][c], lut[idx[3]][c],
+                          lut[idx[4]][c], lut[idx[5]][c], lut[idx[6]][c], lut[idx[7]][c]);
+}
+
+static __forceinline bool IsTransparent16(const BYTE* idx, BYTE transparent)
+{
+    __m128i i16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(idx));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(i16, _mm_set1_epi8((char)transparent))) == 0xFFFF;
+}
+
+static void BlendIndexesPacked_c(DWORD* dst, const BYTE* idx, int w, const WORD (*lut)[8], BYTE transparent)
+{
+    for (int x = 0; x < w; x++) {
+        const WORD* l = lut[idx[x]];
+        BYTE* d = reinterpret_cast<BYTE*>(dst + x);
+        for (int c = 0; c < 4; c++) {
+            d[c] = (BYTE)((d[c] * l[4] + l[c]) >> 8);
+        }
+    }
+}
+
+static void BlendIndexesPacked_sse2(DWORD* dst, const BYTE* idx, int w, const WORD (*lut)[8], BYTE transparent)
+{
+    __m128i zero = _mm_setzero_si128();
+    int x = 0;
+    while (x + 16 <= w) {
+        if (IsTransparent16(idx + x, transparent)) {
+            x += 16;
+            continue;
+        }
+        for (int x_end = x + 16; x < x_end; x += 2) {
+            __m128i l0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lut[idx[x]]));
+            __m128i l1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lut[idx[x + 1]]));
+            __m128i premul = _mm_unpacklo_epi64(l0, l1);
+            __m128i ia = _mm_unpackhi_epi64(l0, l1);
+            __m128i d = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(dst + x));
+            d = _mm_unpacklo_epi8(d, zero);
+            d = _mm_add_epi16(_mm_mullo_epi16(d, ia), premul);   // <= 255*257, no overflow
+            d = _mm_srli_epi16(d, 8);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(d, d));
+        }
+    }
+    BlendIndexesPacked_c(dst + x, idx + x, w - x, lut, transparent);
+}
+
+static void BlendIndexesPlanar_c(BYTE* dst, int plane_size, const BYTE* idx, int w, const WORD (*lut)[8], BYTE transparent)
+{
+    // planes: A, Y, U, V, i.e. channels 3, 2, 1, 0 of the packed color
+    for (int x = 0; x < w; x++) {
+        const WORD* l = lut[idx[x]];
+        BYTE* d = dst + x;
+        for (int p = 0; p < 4; p++, d += plane_size) {
+            *d = (BYTE)((*d * l[4] + l[3 - p]) >> 8);
+        }
+    }
+}
+
+static void BlendIndexesPlanar_sse2(BYTE* dst, int plane_size, const BYTE* idx, int w, const WORD (*lut)[8], BYTE transparent)
+{
+    __m128i zero = _mm_setzero_si128();
+    int x = 0;
+    while (x + 16 <= w) {
+        if (IsTransparent16(idx + x, transparent)) {
+            x += 16;
+            continue;
+        }
+        for (int x_end = x + 16; x < x_end; x += 8) {
+            __m128i ia = BlendLutGather8(lut, idx + x, 4);
+            BYTE* d = dst + x;
+            for (int p = 0; p < 4; p++, d += plane_size) {
+                __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(d));
+                v = _mm_unpacklo_epi8(v, zero);
+                v = _mm_add_epi16(_mm_mullo_epi16(v, ia), BlendLutGather8(lut, idx + x, 3 - p));
+                v = _mm_srli_epi16(v, 8);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(d), _mm_packus_epi16(v, v));
+            }
+        }
+    }
+    BlendIndexesPlanar_c(dst + x, plane_size, idx + x, w - x, lut, transparent);
+}
+
+void CompositionObject::BlendIndexes(SubPicDesc& spd, int nX, int nY)
+{
+    if (!m_pIndexes->IsDecoded(m_width, m_height) || m_pIndexes->data.IsEmpty()) {
+        return;
+    }
+    if (m_pIndexes->transparent != m_nLutTransparent) {
+        m_nLutTransparent = m_pIndexes->transparent;
+        InitBlendLut();
+    }
+    // DVB objects are placed by their region and may stick out of the picture
+    int left = max(0, -nX), top = max(0, -nY);
+    int right = min((int)m_width, spd.w - nX), bottom = min((int)m_height, spd.h - nY);
+    if (left >= right || top >= bottom) {
+        return;
+    }
+    int w = right - left;
+    BYTE transparent = m_pIndexes->transparent;
+    bool fSSE2 = !!(g_cpuid.m_flags & CCpuID::sse2);
+    const BYTE* idx = m_pIndexes->data.GetData() + top * m_width + left;
+    if (spd.type == MSP_AYUV_PLANAR) {
+        int plane_size = spd.pitch * spd.h;
+        BYTE* dst = reinterpret_cast<BYTE*>(spd.bits) + spd.pitch * (nY + top) + nX + left;
+        for (int y = top; y < bottom; y++, idx += m_width, dst += spd.pitch) {
+            if (fSSE2) {
+                BlendIndexesPlanar_sse2(dst, plane_size, idx, w, m_BlendLut, transparent);
+            } else {
+                BlendIndexesPlanar_c(dst, plane_size, idx, w, m_BlendLut, transparent);
+            }
+        }
+    } else {
+        BYTE* dst = reinterpret_cast<BYTE*>(spd.bits) + spd.pitch * (nY + top) + (nX + left) * 4;
+        for (int y = top; y < bottom; y++, idx += m_width, dst += spd.pitch) {
+            if (fSSE2) {
+                BlendIndexesPacked_sse2(reinterpret_cast<DWORD*>(dst), idx, w, m_BlendLut, transparent);
+            } else {
+                BlendIndexesPacked_c(reinterpret_cast<DWORD*>(dst), idx, w, m_BlendLut, transparent);
+            }
         }
     }
 }
@@ -388,6 +577,49 @@ void CompositionObject::RenderDvb(SubPicDesc& spd, short nX, short nY)
         return;
     }
 
+    // m_width and m_height come from the region, set again on every render
+    if (!m_pIndexes->IsDecoded(m_width, m_height)) {
+        DecodeDvb();
+    }
+    BlendIndexes(spd, nX, nY);
+}
+
+void CompositionObject::DecodeDvb()
+{
+    CAtlArray<BYTE>& indexes = m_pIndexes->data;
+    m_pIndexes->bDecoded = true;
+    m_pIndexes->width = m_width;
+    m_pIndexes->height = m_height;
+    m_pIndexes->transparent = 0xFF;
+    if (m_width <= 0 || m_height <= 0) {
+        indexes.RemoveAll();
+        return;
+    }
+    indexes.SetCount(m_width * m_height);
+
+    // The pixels no code string covers are left as they are. They are marked 0xFF like HDMV, 
+    // unless the object uses that entry, then with an entry it does not use.
+    bool used[256];
+    DvbDecodeFields(indexes.GetData(), 0xFF, used);
+    if (used[0xFF]) {
+        for (int i = 0; i < 0xFF; i++) {
+            if (!used[i]) {
+                m_pIndexes->transparent = (BYTE)i;
+                DvbDecodeFields(indexes.GetData(), (BYTE)i, used);
+                break;
+            }
+        }
+    }
+}
+
+void CompositionObject::DvbDecodeFields(BYTE* pIndexes, BYTE transparent, bool* used)
+{
+    memset(pIndexes, transparent, m_width * m_height);
+    memset(used, 0, 256 * sizeof(used[0]));
+
+    if (m_nRLEDataSize < 4) {
+        return;
+    }
     CGolombBuffer gb(m_pRLEData, m_nRLEDataSize);
     short sTopFieldLength;
     short sBottomFieldLength;
@@ -395,31 +627,26 @@ void CompositionObject::RenderDvb(SubPicDesc& spd, short nX, short nY)
     sTopFieldLength    = gb.ReadShort();
     sBottomFieldLength = gb.ReadShort();
 
-    DvbRenderField(spd, gb, nX, nY,     sTopFieldLength);
-    DvbRenderField(spd, gb, nX, nY + 1, sBottomFieldLength);
+    DvbDecodeField(pIndexes, gb, 0, sTopFieldLength, used);
+    DvbDecodeField(pIndexes, gb, 1, sBottomFieldLength, used);
 }
 
-
-void CompositionObject::DvbRenderField(SubPicDesc& spd, CGolombBuffer& gb, short nXStart, short nYStart, short nLength)
+void CompositionObject::DvbDecodeField(BYTE* pIndexes, CGolombBuffer& gb, short nYStart, short nLength, bool* used)
 {
-    //FillSolidRect(spd, nXStart, nYStart, m_width, m_height, 0xFFFF0000);  // Red opaque
-    //FillSolidRect(spd, nXStart, nYStart, m_width, m_height, 0xCC00FF00);  // Green 80%
-    //FillSolidRect(spd, nXStart, nYStart, m_width, m_height, 0x100000FF);  // Blue 60%
-    //return;
-    short nX = nXStart;
+    short nX = 0;
     short nY = nYStart;
     int nEnd = gb.GetPos() + nLength;
-    while (gb.GetPos() < nEnd) {
+    while (gb.GetPos() < nEnd && !gb.IsEOF()) {
         BYTE bType = gb.ReadByte();
         switch (bType) {
             case 0x10:
-                Dvb2PixelsCodeString(spd, gb, nX, nY);
+                Dvb2PixelsCodeString(pIndexes, gb, nX, nY, used);
                 break;
             case 0x11:
-                Dvb4PixelsCodeString(spd, gb, nX, nY);
+                Dvb4PixelsCodeString(pIndexes, gb, nX, nY, used);
                 break;
             case 0x12:
-                Dvb8PixelsCodeString(spd, gb, nX, nY);
+                Dvb8PixelsCodeString(pIndexes, gb, nX, nY, used);
                 break;
             case 0x20:
                 gb.SkipBytes(2);
@@ -431,7 +658,7 @@ void CompositionObject::DvbRenderField(SubPicDesc& spd, CGolombBuffer& gb, short
                 gb.SkipBytes(16);
                 break;
             case 0xF0:
-                nX  = nXStart;
+                nX  = 0;
                 nY += 2;
                 break;
             default:
@@ -441,8 +668,16 @@ void CompositionObject::DvbRenderField(SubPicDesc& spd, CGolombBuffer& gb, short
     }
 }
 
+// Runs past the object are clipped, the code string goes on so that the next one is found
+void CompositionObject::DvbWriteRun(BYTE* pIndexes, short nX, short nY, short nCount, BYTE nPaletteIndex, bool* used)
+{
+    if (nY < m_height && nX < m_width) {
+        memset(pIndexes + nY * m_width + nX, nPaletteIndex, min(nCount, (short)(m_width - nX)));
+        used[nPaletteIndex] = true;
+    }
+}
 
-void CompositionObject::Dvb2PixelsCodeString(SubPicDesc& spd, CGolombBuffer& gb, short& nX, short& nY)
+void CompositionObject::Dvb2PixelsCodeString(BYTE* pIndexes, CGolombBuffer& gb, short& nX, short& nY, bool* used)
 {
     BYTE  bTemp;
     BYTE  nPaletteIndex = 0;
@@ -484,13 +719,8 @@ void CompositionObject::Dvb2PixelsCodeString(SubPicDesc& spd, CGolombBuffer& gb,
             }
         }
 
-        if (nX + nCount > m_width) {
-            ASSERT(FALSE);
-            break;
-        }
-
         if (nCount > 0) {
-            FillSolidRect(spd, nX, nY, nCount, 1, m_Colors[nPaletteIndex]);
+            DvbWriteRun(pIndexes, nX, nY, nCount, nPaletteIndex, used);
             nX += nCount;
         }
     }
@@ -498,7 +728,7 @@ void CompositionObject::Dvb2PixelsCodeString(SubPicDesc& spd, CGolombBuffer& gb,
     gb.BitByteAlign();
 }
 
-void CompositionObject::Dvb4PixelsCodeString(SubPicDesc& spd, CGolombBuffer& gb, short& nX, short& nY)
+void CompositionObject::Dvb4PixelsCodeString(BYTE* pIndexes, CGolombBuffer& gb, short& nX, short& nY, bool* used)
 {
     BYTE  bTemp;
     BYTE  nPaletteIndex = 0;
@@ -545,15 +775,8 @@ void CompositionObject::Dvb4PixelsCodeString(SubPicDesc& spd, CGolombBuffer& gb,
             }
         }
 
-#if 0
-        if (nX + nCount > m_width) {
-            ASSERT(FALSE);
-            break;
-        }
-#endif
-
         if (nCount > 0) {
-            FillSolidRect(spd, nX, nY, nCount, 1, m_Colors[nPaletteIndex]);
+            DvbWriteRun(pIndexes, nX, nY, nCount, nPaletteIndex, used);
             nX += nCount;
         }
     }
@@ -561,7 +784,7 @@ void CompositionObject::Dvb4PixelsCodeString(SubPicDesc& spd, CGolombBuffer& gb,
     gb.BitByteAlign();
 }
 
-void CompositionObject::Dvb8PixelsCodeString(SubPicDesc& spd, CGolombBuffer& gb, short& nX, short& nY)
+void CompositionObject::Dvb8PixelsCodeString(BYTE* pIndexes, CGolombBuffer& gb, short& nX, short& nY, bool* used)
 {
     BYTE  bTemp;
     BYTE  nPaletteIndex = 0;
@@ -587,13 +810,8 @@ void CompositionObject::Dvb8PixelsCodeString(SubPicDesc& spd, CGolombBuffer& gb,
             }
         }
 
-        if (nX + nCount > m_width) {
-            ASSERT(FALSE);
-            break;
-        }
-
         if (nCount > 0) {
-            FillSolidRect(spd, nX, nY, nCount, 1, m_Colors[nPaletteIndex]);
+            DvbWriteRun(pIndexes, nX, nY, nCount, nPaletteIndex, used);
             nX += nCount;
         }
     }
@@ -21,6 +21,7 @@
 #pragma once
 
 #include "Rasterizer.h"
+#include <boost/shared_ptr.hpp>
 
 
 struct HDMV_PALETTE {
@@ -71,6 +72,7 @@ public:
 
     void  SetRLEData(const BYTE* pBuffer, int nSize, int nTotalSize);
     void  AppendRLEData(const BYTE* pBuffer, int nSize);
+    void  SetObjectData(const CompositionObject& source);
     const BYTE* GetRLEData() { return m_pRLEData; };
     int   GetRLEDataSize() { return m_nRLEDataSize; };
     bool  IsRLEComplete() { return m_nRLEPos >= m_nRLEDataSize; };
@@ -89,6 +91,33 @@ private:
     int   m_nRLEDataSize;
     int   m_nRLEPos;
 
+    // HDMV and DVB objects are decoded once into m_width x m_height palette indexes, then blended 
+    // through m_BlendLut on every render. Both are only rebuilt when the RLE data or the 
+    // palette changes.
+    // The indexes are shared by all the copies of the same object data (see SetObjectData), so 
+    // palette updates, e.g. fades, go without decoding the RLE data again.
+    struct DecodedIndexes {
+        CAtlArray<BYTE> data;
+        bool  bDecoded;
+        BYTE  transparent;      // the index of the pixels left as they are
+        short width;            // the size data was decoded at
+        short height;
+
+        DecodedIndexes() : bDecoded(false), transparent(0xFF), width(0), height(0) {}
+
+        bool IsDecoded(short w, short h) const {
+            return bDecoded && width == w && height == h;
+        }
+    };
+    boost::shared_ptr<DecodedIndexes> m_pIndexes;
+    WORD  m_BlendLut[256][8];   // per index: color*(alpha+1) for the 4 channels, then 4x (256-alpha)
+    BYTE  m_nLutTransparent;
+
+    void  DecodeHdmv();
+    void  DecodeDvb();
+    void  InitBlendLut();
+    void  BlendIndexes(SubPicDesc& spd, int nX, int nY);
+
     CAtlArray<HDMV_PALETTE> m_Palette;
     ColorType   m_OriginalColorType;
     YuvRangeType m_OriginalYuvRangeType;
@@ -96,8 +125,10 @@ private:
     DWORD       m_Colors[256];
     int         m_colorType;
 
-    void  DvbRenderField(SubPicDesc& spd, CGolombBuffer& gb, short nXStart, short nYStart, short nLength);
-    void  Dvb2PixelsCodeString(SubPicDesc& spd, CGolombBuffer& gb, short& nX, short& nY);
-    void  Dvb4PixelsCodeString(SubPicDesc& spd, CGolombBuffer& gb, short& nX, short& nY);
-    void  Dvb8PixelsCodeString(SubPicDesc& spd, CGolombBuffer& gb, short& nX, short& nY);
+    void  DvbDecodeFields(BYTE* pIndexes, BYTE transparent, bool* used);
+    void  DvbDecodeField(BYTE* pIndexes, CGolombBuffer& gb, short nYStart, short nLength, bool* used);
+    void  DvbWriteRun(BYTE* pIndexes, short nX, short nY, short nCount, BYTE nPaletteIndex, bool* used);
+    void  Dvb2PixelsCodeString(BYTE* pIndexes, CGolombBuffer& gb, short& nX, short& nY, bool* used);
+    void  Dvb4PixelsCodeString(BYTE* pIndexes, CGolombBuffer& gb, short& nX, short& nY, bool* used);
+    void  Dvb8PixelsCodeString(BYTE* pIndexes, CGolombBuffer& gb, short& nX, short& nY, bool* used);
 };
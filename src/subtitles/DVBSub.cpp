@@ -29,21 +29,15 @@
 #define TRACE_DVB __noop
 #endif
 
-#define BUFFER_CHUNK_GROW 0x1000
-
 CDVBSub::CDVBSub(void)
     : CBaseSub(ST_DVB)
 {
-    m_nBufferReadPos  = 0;
-    m_nBufferWritePos = 0;
-    m_nBufferSize     = 0;
-    m_pBuffer         = NULL;
+    m_bSynchronized = false;
 }
 
 CDVBSub::~CDVBSub(void)
 {
     Reset();
-    SAFE_DELETE(m_pBuffer);
 }
 
 CDVBSub::DVB_PAGE* CDVBSub::FindPage(REFERENCE_TIME rt)
@@ -105,41 +99,6 @@ CompositionObject* CDVBSub::FindObject(DVB_PAGE* pPage, short sObjectId)
     return NULL;
 }
 
-HRESULT CDVBSub::AddToBuffer(BYTE* pData, int nSize)
-{
-    bool bFirstChunk = (*((LONG*)pData) & 0x00FFFFFF) == 0x000f0020; // DVB sub start with 0x20 0x00 0x0F ...
-
-    if (m_nBufferWritePos > 0 || bFirstChunk) {
-        if (bFirstChunk) {
-            m_nBufferWritePos = 0;
-            m_nBufferReadPos  = 0;
-        }
-
-        if (m_nBufferWritePos + nSize > m_nBufferSize) {
-            if (m_nBufferWritePos + nSize > 20 * BUFFER_CHUNK_GROW) {
-                // Too big to be a DVB sub !
-                TRACE_DVB(_T("DVB - Too much data received...\n"));
-                ASSERT(FALSE);
-
-                Reset();
-                return E_INVALIDARG;
-            }
-
-            BYTE* pPrev = m_pBuffer;
-            m_nBufferSize = max(m_nBufferWritePos + nSize, m_nBufferSize + BUFFER_CHUNK_GROW);
-            m_pBuffer = DEBUG_NEW BYTE[m_nBufferSize];
-            if (pPrev != NULL) {
-                memcpy_s(m_pBuffer, m_nBufferSize, pPrev, m_nBufferWritePos);
-                SAFE_DELETE(pPrev);
-            }
-        }
-        memcpy_s(m_pBuffer + m_nBufferWritePos, m_nBufferSize, pData, nSize);
-        m_nBufferWritePos += nSize;
-        return S_OK;
-    }
-    return S_FALSE;
-}
-
 #define MARKER              \
     if (gb.BitRead(1) != 1) \
     {                       \
@@ -218,25 +177,35 @@ HRESULT CDVBSub::ParseSample(IMediaSample* pSample)
         pSample->SetTime(&m_rtStart, &m_rtStop);
     }
 
-    if (AddToBuffer(pData, nSize) == S_OK) {
-        CGolombBuffer gb(m_pBuffer + m_nBufferReadPos, m_nBufferWritePos - m_nBufferReadPos);
-        int nLastPos = 0;
+    bool bFirstChunk = nSize >= 4 && (*((LONG*)pData) & 0x00FFFFFF) == 0x000f0020; // DVB sub start with 0x20 0x00 0x0F ...
+    if (bFirstChunk) {
+        m_segments.Reset();
+        m_bSynchronized = true;
+    }
+
+    if (m_bSynchronized) {
+        // Segments are parsed in place, only the ones split over several samples are gathered
+        BYTE* pHeader;
 
-        while (gb.RemainingSize() >= 6) { // Ensure there is enough data to parse the entire segment header
-            if (gb.ReadByte() == 0x0F) {
+        m_segments.SetInput(pData, nSize);
+        while ((pHeader = m_segments.Peek(6)) != NULL) { // Ensure there is enough data to parse the entire segment header
+            if (pHeader[0] == 0x0F) {
                 TRACE_DVB(_T("DVB - ParseSample\n"));
 
                 WORD wPageId;
                 WORD wSegLength;
 
-                nCurSegment = (DVB_SEGMENT_TYPE) gb.ReadByte();
-                wPageId = gb.ReadShort();
-                wSegLength = gb.ReadShort();
+                nCurSegment = (DVB_SEGMENT_TYPE) pHeader[1];
+                wPageId = (pHeader[2] << 8) | pHeader[3];
+                wSegLength = (pHeader[4] << 8) | pHeader[5];
+                UNREFERENCED_PARAMETER(wPageId);
 
-                if (gb.RemainingSize() < wSegLength) {
+                BYTE* pSegment = m_segments.Peek(6 + wSegLength);
+                if (pSegment == NULL) {
                     hr = S_FALSE;
                     break;
                 }
+                CGolombBuffer gb(pSegment + 6, wSegLength);
 
                 switch (nCurSegment) {
                     case PAGE: {
@@ -301,10 +270,12 @@ HRESULT CDVBSub::ParseSample(IMediaSample* pSample)
                     default:
                         break;
                 }
-                nLastPos = gb.GetPos();
+                m_segments.Consume(6 + wSegLength);
+            } else {
+                m_segments.Consume(1);
             }
         }
-        m_nBufferReadPos += nLastPos;
+        m_segments.EndInput();
     }
 
     return hr;
@@ -422,8 +393,8 @@ REFERENCE_TIME CDVBSub::GetStop(POSITION nPos)
 
 void CDVBSub::Reset()
 {
-    m_nBufferReadPos  = 0;
-    m_nBufferWritePos = 0;
+    m_segments.Reset();
+    m_bSynchronized = false;
     m_pCurrentPage.Free();
 
     DVB_PAGE* pPage;
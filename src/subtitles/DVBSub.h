@@ -21,6 +21,7 @@
 #pragma once
 
 #include "BaseSub.h"
+#include "xy_segment_assembler.h"
 
 #define MAX_REGIONS     10
 #define MAX_OBJECTS     10          // Max number of objects per region
@@ -190,17 +191,14 @@ public:
 private:
     static const REFERENCE_TIME INVALID_TIME = _I64_MIN;
 
-    int                 m_nBufferSize;
-    int                 m_nBufferReadPos;
-    int                 m_nBufferWritePos;
-    BYTE*               m_pBuffer;
+    XySegmentAssembler  m_segments;
+    bool                m_bSynchronized;   // a first chunk was received since the last reset
     CAtlList<DVB_PAGE*> m_Pages;
     CAutoPtr<DVB_PAGE>  m_pCurrentPage;
     DVB_DISPLAY         m_Display;
     REFERENCE_TIME      m_rtStart;
     REFERENCE_TIME      m_rtStop;
 
-    HRESULT             AddToBuffer(BYTE* pData, int nSize);
     DVB_PAGE*           FindPage(REFERENCE_TIME rt);
     DVB_REGION*         FindRegion(DVB_PAGE* pPage, BYTE bRegionId);
     DVB_CLUT*           FindClut(DVB_PAGE* pPage, BYTE bClutId);
@@ -31,11 +31,6 @@
 
 CHdmvSub::CHdmvSub(void)
     : CBaseSub(ST_HDMV)
-    , m_nCurSegment(NO_SEGMENT)
-    , m_pSegBuffer(NULL)
-    , m_nTotalSegBuffer(0)
-    , m_nSegBufferPos(0)
-    , m_nSegSize(0)
     , m_pCurrentPresentationSegment(NULL)
 {
 }
@@ -44,22 +39,9 @@ CHdmvSub::~CHdmvSub()
 {
     Reset();
 
-    delete [] m_pSegBuffer;
     delete m_pCurrentPresentationSegment;
 }
 
-
-void CHdmvSub::AllocSegment(int nSize)
-{
-    if (nSize > m_nTotalSegBuffer) {
-        delete [] m_pSegBuffer;
-        m_pSegBuffer = DEBUG_NEW BYTE[nSize];
-        m_nTotalSegBuffer = nSize;
-    }
-    m_nSegBufferPos = 0;
-    m_nSegSize = nSize;
-}
-
 POSITION CHdmvSub::GetStartPosition(REFERENCE_TIME rt, double fps)
 {
     HDMV_PRESENTATION_SEGMENT* pPresentationSegment;
@@ -121,81 +103,74 @@ HRESULT CHdmvSub::ParseSample(IMediaSample* pSample)
     lSampleLen = pSample->GetActualDataLength();
 
     pSample->GetTime(&rtStart, &rtStop);
-    if (pData) {
-        CGolombBuffer SampleBuffer(pData, lSampleLen);
-
-        while (!SampleBuffer.IsEOF()) {
-            if (m_nCurSegment == NO_SEGMENT) {
-                HDMV_SEGMENT_TYPE nSegType = (HDMV_SEGMENT_TYPE)SampleBuffer.ReadByte();
-                unsigned short nUnitSize = SampleBuffer.ReadShort();
-                lSampleLen -= 3;
-
-                switch (nSegType) {
-                    case PALETTE:
-                    case OBJECT:
-                    case PRESENTATION_SEG:
-                    case END_OF_DISPLAY:
-                        m_nCurSegment = nSegType;
-                        AllocSegment(nUnitSize);
-                        break;
-
-                    case WINDOW_DEF:
-                    case INTERACTIVE_SEG:
-                    case HDMV_SUB1:
-                    case HDMV_SUB2:
-                        // Ignored stuff...
-                        SampleBuffer.SkipBytes(nUnitSize);
-                        break;
-                    default:
-                        return VFW_E_SAMPLE_REJECTED;
-                }
-            }
+    return ParseData(pData, lSampleLen, rtStart);
+}
 
-            if (m_nCurSegment != NO_SEGMENT) {
-                if (m_nSegBufferPos < m_nSegSize) {
-                    int nSize = min(m_nSegSize - m_nSegBufferPos, lSampleLen);
-                    SampleBuffer.ReadBuffer(m_pSegBuffer + m_nSegBufferPos, nSize);
-                    m_nSegBufferPos += nSize;
-                }
+// Segments are parsed straight from @pData, only the ones split over several samples are
+// gathered by m_segments
+HRESULT CHdmvSub::ParseData(BYTE* pData, int nSize, REFERENCE_TIME rtStart)
+{
+    BYTE* pHeader;
+
+    m_segments.SetInput(pData, nSize);
+    while ((pHeader = m_segments.Peek(3)) != NULL) {
+        HDMV_SEGMENT_TYPE nSegType = (HDMV_SEGMENT_TYPE)pHeader[0];
+        unsigned short nUnitSize = (pHeader[1] << 8) | pHeader[2];
+
+        switch (nSegType) {
+            case PALETTE:
+            case OBJECT:
+            case PRESENTATION_SEG:
+            case END_OF_DISPLAY:
+            case WINDOW_DEF:
+            case INTERACTIVE_SEG:
+            case HDMV_SUB1:
+            case HDMV_SUB2:
+                break;
+            default:
+                m_segments.Reset();
+                return VFW_E_SAMPLE_REJECTED;
+        }
 
-                if (m_nSegBufferPos >= m_nSegSize) {
-                    CGolombBuffer SegmentBuffer(m_pSegBuffer, m_nSegSize);
-
-                    switch (m_nCurSegment) {
-                        case PALETTE:
-                            TRACE_HDMVSUB( (_T("CHdmvSub:PALETTE            rtStart=%10I64d\n"), rtStart) );
-                            ParsePalette(&SegmentBuffer, m_nSegSize);
-                            break;
-                        case OBJECT:
-                            TRACE_HDMVSUB( (_T("CHdmvSub:OBJECT             %lS\n"), ReftimeToCString(rtStart)) );
-                            ParseObject(&SegmentBuffer, m_nSegSize);
-                            break;
-                        case PRESENTATION_SEG:
-                            TRACE_HDMVSUB( (_T("CHdmvSub:PRESENTATION_SEG   %lS (size=%d)\n"), ReftimeToCString(rtStart), m_nSegSize) );
-
-                            // Enqueue the current presentation segment if any
-                            EnqueuePresentationSegment(rtStart);
-                            // Parse the new presentation segment
-                            ParsePresentationSegment(rtStart, &SegmentBuffer);
-
-                            break;
-                        case WINDOW_DEF:
-                            //TRACE_HDMVSUB( (_T("CHdmvSub:WINDOW_DEF         %lS\n"), ReftimeToCString(rtStart)) );
-                            break;
-                        case END_OF_DISPLAY:
-                            //TRACE_HDMVSUB( (_T("CHdmvSub:END_OF_DISPLAY     %lS\n"), ReftimeToCString(rtStart)) );
-                            break;
-                        default:
-                            TRACE_HDMVSUB( (_T("CHdmvSub:UNKNOWN Seg %d     rtStart=0x%10dd\n"), m_nCurSegment, rtStart) );
-                    }
-
-                    m_nCurSegment = NO_SEGMENT;
-                }
-            }
+        BYTE* pSegment = m_segments.Peek(3 + nUnitSize);
+        if (pSegment == NULL) {
+            break;  // Completed by the next samples
         }
+        CGolombBuffer SegmentBuffer(pSegment + 3, nUnitSize);
+
+        switch (nSegType) {
+            case PALETTE:
+                TRACE_HDMVSUB( (_T("CHdmvSub:PALETTE            rtStart=%10I64d\n"), rtStart) );
+                ParsePalette(&SegmentBuffer, nUnitSize);
+                break;
+            case OBJECT:
+                TRACE_HDMVSUB( (_T("CHdmvSub:OBJECT             %lS\n"), ReftimeToCString(rtStart)) );
+                ParseObject(&SegmentBuffer, nUnitSize);
+                break;
+            case PRESENTATION_SEG:
+                TRACE_HDMVSUB( (_T("CHdmvSub:PRESENTATION_SEG   %lS (size=%d)\n"), ReftimeToCString(rtStart), nUnitSize) );
+
+                // Enqueue the current presentation segment if any
+                EnqueuePresentationSegment(rtStart);
+                // Parse the new presentation segment
+                ParsePresentationSegment(rtStart, &SegmentBuffer);
+
+                break;
+            case WINDOW_DEF:
+                //TRACE_HDMVSUB( (_T("CHdmvSub:WINDOW_DEF         %lS\n"), ReftimeToCString(rtStart)) );
+                break;
+            case END_OF_DISPLAY:
+                //TRACE_HDMVSUB( (_T("CHdmvSub:END_OF_DISPLAY     %lS\n"), ReftimeToCString(rtStart)) );
+                break;
+            default:
+                // Ignored stuff...
+                break;
+        }
+        m_segments.Consume(3 + nUnitSize);
     }
+    m_segments.EndInput();
 
-    return hr;
+    return S_OK;
 }
 
 int CHdmvSub::ParsePresentationSegment(REFERENCE_TIME rt, CGolombBuffer* pGBuffer)
@@ -237,10 +212,9 @@ void CHdmvSub::EnqueuePresentationSegment(REFERENCE_TIME rt)
 
                 CompositionObject& pObjectData = m_compositionObjects[pObject->m_object_id_ref];
 
-                pObject->m_width = pObjectData.m_width;
-                pObject->m_height = pObjectData.m_height;
-
-                pObject->SetRLEData(pObjectData.GetRLEData(), pObjectData.GetRLEDataSize(), pObjectData.GetRLEDataSize());
+                // Palette updates (fades) come without new object data: the decoded bitmap of the
+                // previous segments is shared then and only the palette is applied again
+                pObject->SetObjectData(pObjectData);
             }
 
             m_pPresentationSegments.AddTail(m_pCurrentPresentationSegment);
@@ -405,6 +379,12 @@ HRESULT CHdmvSub::GetTextureSize(POSITION pos, SIZE& MaxTextureSize, SIZE& Video
 
 void CHdmvSub::Reset()
 {
+    m_segments.Reset();
+
+    // Left open, it would be closed by whatever comes after the seek
+    delete m_pCurrentPresentationSegment;
+    m_pCurrentPresentationSegment = NULL;
+
     HDMV_PRESENTATION_SEGMENT* pPresentationSegment;
     while (m_pPresentationSegments.GetCount() > 0) {
         pPresentationSegment = m_pPresentationSegments.RemoveHead();
@@ -21,6 +21,7 @@
 #pragma once
 
 #include "BaseSub.h"
+#include "xy_segment_assembler.h"
 
 class CGolombBuffer;
 
@@ -97,6 +98,7 @@ public:
     ~CHdmvSub();
 
     HRESULT   ParseSample(IMediaSample* pSample);
+    HRESULT   ParseData(BYTE* pData, int nSize, REFERENCE_TIME rtStart);
 
 
     POSITION  GetStartPosition(REFERENCE_TIME rt, double fps);
@@ -121,11 +123,7 @@ public:
     virtual HRESULT         SetYuvType(ColorType colorType, YuvRangeType yuvRangeType);
 private:
 
-    HDMV_SEGMENT_TYPE            m_nCurSegment;
-    BYTE*                        m_pSegBuffer;
-    int                          m_nTotalSegBuffer;
-    int                          m_nSegBufferPos;
-    int                          m_nSegSize;
+    XySegmentAssembler           m_segments;
 
     HDMV_PRESENTATION_SEGMENT*           m_pCurrentPresentationSegment;
     CAtlList<HDMV_PRESENTATION_SEGMENT*> m_pPresentationSegments;
@@ -144,8 +142,6 @@ private:
     void                ParseCompositionDescriptor(CGolombBuffer* pGBuffer, COMPOSITION_DESCRIPTOR* pCompositionDescriptor);
     void                ParseCompositionObject(CGolombBuffer* pGBuffer, CompositionObject* pCompositionObject);
 
-    void                AllocSegment(int nSize);
-
     HDMV_PRESENTATION_SEGMENT* FindPresentationSegment(REFERENCE_TIME rt);
     CompositionObject*  FindObject(HDMV_PRESENTATION_SEGMENT* pPresentationSegment, short sObjectId);
 };
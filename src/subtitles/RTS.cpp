@@ -28,6 +28,7 @@
 #include "subpixel_position_controler.h"
 #include "xy_overlay_paint_machine.h"
 #include "xy_clipper_paint_machine.h"
+#include "xy_render_timing.h"
 
 // WARNING: this isn't very thread safe, use only one RTS a time.
 static HDC g_hDC;
@@ -231,7 +232,10 @@ bool CWord::PaintFromPathData(const CPointCoor2& psub, const CPointCoor2& trans_
     SharedPtrConstPathData shared_ptr_path_data2(path_data2);
     bool need_transform = NeedTransform();
     if(need_transform)
+    {
+        XyRenderTiming::Scope timing(XyRenderTiming::PATH);
         Transform(path_data2, CPoint(trans_org.x*8, trans_org.y*8));
+    }
 
     CPoint left_top;
     CSize size;
@@ -320,9 +324,12 @@ bool CWord::PaintFromRawData( const CPointCoor2& psub, const CPointCoor2& trans_
 
     PathData *tmp=new PathData();
     SharedPtrPathData path_data(tmp);
-    if(!CreatePath(tmp))
     {
-        return false;
+        XyRenderTiming::Scope timing(XyRenderTiming::PATH);
+        if(!CreatePath(tmp))
+        {
+            return false;
+        }
     }
     path_data_cache->UpdateCache(key, path_data);
     return PaintFromPathData(psub, trans_org, *tmp, key, overlay);
@@ -1364,6 +1371,7 @@ void CClipper::SetEffect( const Effect& effect, int effectType )
 
 SharedPtrGrayImage2 CClipper::GetAlphaMask( const SharedPtrCClipper& clipper )
 {
+    XyRenderTiming::Scope timing(XyRenderTiming::CLIP);
     SharedPtrGrayImage2 result;
     CClipperPaintMachine paint_machine(clipper);
     paint_machine.Paint(&result);
@@ -1859,6 +1867,8 @@ CAtlMap<CStringW, CRenderedTextSubtitle::AssCmdType, CStringElementTraits<CStrin
 CRenderedTextSubtitle::CRenderedTextSubtitle(CCritSec* pLock)
     : CSubPicProviderImpl(pLock)
     , m_target_scale_x(1.0), m_target_scale_y(1.0)
+    , m_pendingStart(0)
+    , m_maxAnimationRate(0)
 {
     if( m_cmdMap.IsEmpty() )
     {
@@ -2019,6 +2029,7 @@ void CRenderedTextSubtitle::Deinit()
     CacheManager::GetOverlayNoOffsetMruCache()->RemoveAll();
 
     CacheManager::GetSubpixelVarianceCache()->RemoveAll();
+    CacheManager::GetShadowOverlayCache()->RemoveAll();
     CacheManager::GetOverlayMruCache()->RemoveAll();
     CacheManager::GetOverlayNoBlurMruCache()->RemoveAll();
     CacheManager::GetScanLineData2MruCache()->RemoveAll();
@@ -3118,23 +3129,52 @@ STDMETHODIMP CRenderedTextSubtitle::NonDelegatingQueryInterface(REFIID riid, voi
 
 // ISubPicProvider
 
-STDMETHODIMP_(POSITION) CRenderedTextSubtitle::GetStartPosition(REFERENCE_TIME rt, double fps)
-{    
-    m_fps = fps;
-    if (m_fps>0)
+int CRenderedTextSubtitle::GetAnimationPeriod(double fps) const
+{
+    int period;
+    if (fps>0)
     {
-        m_period = 1000/m_fps;
-        if(m_period<=0)
+        period = 1000/fps;
+        if(period<=0)
         {
-            m_period = 1;
+            period = 1;
         }
     }
     else
     {
         //Todo: fix me. max has been defined as a macro. Use #define NOMINMAX to fix it.
         //std::numeric_limits<int>::max(); 
-        m_period = INT_MAX;
+        period = INT_MAX;
+    }
+    int rate = m_animationRate>=0 ? m_animationRate : m_maxAnimationRate;
+    if(rate>0 && period<1000/rate)
+    {
+        period = 1000/rate;
+    }
+    return period;
+}
+
+int CRenderedTextSubtitle::GetAnimationStep(int t, int segment, double fps)
+{
+    int period = GetAnimationPeriod(fps);
+    return period!=INT_MAX ? (t-TranslateSegmentStart(segment, fps))/period : t;
+}
+
+int CRenderedTextSubtitle::GetAnimationTime(int t, int segment, double fps)
+{
+    int period = GetAnimationPeriod(fps);
+    if (fps<=0 || period<=(int)(1000/fps))
+    {
+        return t;
     }
+    int start = TranslateSegmentStart(segment, fps);
+    return t>start ? start + (t-start)/period*period : t;
+}
+
+STDMETHODIMP_(POSITION) CRenderedTextSubtitle::GetStartPosition(REFERENCE_TIME rt, double fps)
+{    
+    m_fps = fps;
+    m_period = GetAnimationPeriod(fps);
 
     int iSegment;
     int subIndex = 1;//If a segment has animate effect then it corresponds to several subpics.
@@ -3282,11 +3322,18 @@ static int lscomp(const void* ls1, const void* ls2)
 HRESULT CRenderedTextSubtitle::ParseScript(REFERENCE_TIME rt, double fps, CSubtitle2List *outputSub2List )
 {
     //fix me: check input and log error
+    XyRenderTiming::Scope timing(XyRenderTiming::PARSE);
     int t = (int)(rt / 10000);
     int segment;
     //const
     STSSegment* stss = SearchSubs2(t, fps, &segment);
     if(!stss) return S_FALSE;
+    EnterSegment(t, segment, stss);
+    return ParseSegment(GetAnimationTime(t, segment, fps), fps, segment, stss, outputSub2List);
+}
+
+void CRenderedTextSubtitle::EnterSegment( int t, int segment, const STSSegment* stss )
+{
     // clear any cached subs not in the range of +/-90secs measured from the segment's bounds
     {
         POSITION pos = m_subtitleCache.GetStartPosition();
@@ -3305,6 +3352,12 @@ HRESULT CRenderedTextSubtitle::ParseScript(REFERENCE_TIME rt, double fps, CSubti
         }
     }
     m_sla.AdvanceToSegment(segment, stss->subs);
+}
+
+HRESULT CRenderedTextSubtitle::ParseSegment( int t, double fps, int segment, STSSegment* stss, 
+    CSubtitle2List *outputSub2List )
+{
+    XyRenderTiming::Scope timing(XyRenderTiming::PARSE);
     CAtlArray<LSub> subs;
     for(int i = 0, j = stss->subs.GetCount(); i < j; i++)
     {
@@ -3508,6 +3561,106 @@ STDMETHODIMP CRenderedTextSubtitle::RenderEx( IXySubRenderFrame**subRenderFrame,
         return S_FALSE;
     }
     
+    SetupRender(spd_type, size_scale_to, size1, video_rect);
+
+    CSubtitle2List sub2List;
+    HRESULT hr = ParseScript(rt, fps, &sub2List);
+    if(hr!=S_OK)
+    {
+        XyRenderTiming::EndFrame(0, XyRenderTiming::RENDER_STAGE_END);
+        return hr;
+    }
+
+    CompositeDrawItemListList compDrawItemListList;   
+    DoRender(size_scale_to, sub2List, &compDrawItemListList);
+
+    XySubRenderFrame *sub_render_frame;
+    CompositeDrawItem::Draw(&sub_render_frame, compDrawItemListList);
+    (*subRenderFrame = sub_render_frame)->AddRef();
+    XyRenderTiming::EndFrame(0, XyRenderTiming::RENDER_STAGE_END);
+
+    return hr;
+}
+
+STDMETHODIMP CRenderedTextSubtitle::RenderBatch( IXySubRenderFrame**subRenderFrames, const REFERENCE_TIME *rts, 
+    int count, int spd_type, const SIZECoor2& size_scale_to, const SIZE& size1, const CRect& video_rect, 
+    double fps )
+{
+    if (!subRenderFrames || (!rts && count>0))
+    {
+        return E_POINTER;
+    }
+    for (int i=0;i<count;i++)
+    {
+        subRenderFrames[i] = NULL;
+    }
+
+    SetupRender(spd_type, size_scale_to, size1, video_rect);
+
+    int segment_count = m_segments.GetCount();
+    int segment = -1, entered_segment = -1;
+    int last_t = INT_MIN;
+    //the last frame of the entered segment, it holds until the animation moves to its next step
+    XySubRenderFrame *last_frame = NULL;
+    int last_step = -1;
+    HRESULT hr = S_FALSE;
+    for (int i=0;i<count;i++)
+    {
+        int t = (int)(rts[i] / 10000);
+        if (segment<0 || t<last_t || (segment+1<segment_count && t>=TranslateSegmentEnd(segment+1, fps)))
+        {
+            //first frame, not sorted, or past the next segment: binary search, the step below is only
+            //meant for neighbouring segments. Start before the first segment ending after t
+            int next = 0;
+            SearchSubs(t, fps, &next);
+            segment = next-1;
+        }
+        last_t = t;
+        //segments are sorted and disjoint: move forward to the last one starting at or before t
+        while (segment+1<segment_count && TranslateSegmentStart(segment+1, fps)<=t)
+        {
+            segment++;
+        }
+        if (segment<0 || segment>=segment_count || t>=TranslateSegmentEnd(segment, fps))
+        {
+            continue;
+        }
+        STSSegment *stss = &m_segments[segment];
+        if (segment!=entered_segment)
+        {
+            EnterSegment(t, segment, stss);
+            entered_segment = segment;
+            last_frame = NULL;
+        }
+        else if (last_frame && (!stss->animated || GetAnimationStep(t, segment, fps)==last_step))
+        {
+            (subRenderFrames[i] = last_frame)->AddRef();
+            continue;
+        }
+
+        CSubtitle2List sub2List;
+        if (ParseSegment(GetAnimationTime(t, segment, fps), fps, segment, stss, &sub2List)!=S_OK)
+        {
+            XyRenderTiming::EndFrame(0, XyRenderTiming::RENDER_STAGE_END);
+            continue;
+        }
+        CompositeDrawItemListList compDrawItemListList;
+        DoRender(size_scale_to, sub2List, &compDrawItemListList);
+
+        XySubRenderFrame *sub_render_frame;
+        CompositeDrawItem::Draw(&sub_render_frame, compDrawItemListList);
+        (subRenderFrames[i] = sub_render_frame)->AddRef();
+        XyRenderTiming::EndFrame(0, XyRenderTiming::RENDER_STAGE_END);
+        last_frame = sub_render_frame;
+        last_step = GetAnimationStep(t, segment, fps);//whether the segment is animated is known once parsed
+        hr = S_OK;
+    }
+    return hr;
+}
+
+void CRenderedTextSubtitle::SetupRender( int spd_type, const SIZECoor2& size_scale_to, const SIZE& size1, 
+    const CRect& video_rect )
+{
     XyColorSpace color_space = XY_CS_ARGB;
     switch(spd_type)
     {
@@ -3536,28 +3689,13 @@ STDMETHODIMP CRenderedTextSubtitle::RenderEx( IXySubRenderFrame**subRenderFrame,
         render_frame_creater->SetOutputRect(CRect(0, 0, size_scale_to.cx, size_scale_to.cy));
         render_frame_creater->SetClipRect(CRect(0, 0, size_scale_to.cx, size_scale_to.cy));
     }
-
-    CSubtitle2List sub2List;
-    HRESULT hr = ParseScript(rt, fps, &sub2List);
-    if(hr!=S_OK)
-    {
-        return hr;
-    }
-
-    CompositeDrawItemListList compDrawItemListList;   
-    DoRender(size_scale_to, sub2List, &compDrawItemListList);
-
-    XySubRenderFrame *sub_render_frame;
-    CompositeDrawItem::Draw(&sub_render_frame, compDrawItemListList);
-    (*subRenderFrame = sub_render_frame)->AddRef();
-
-    return hr;
 }
 
 void CRenderedTextSubtitle::DoRender( const SIZECoor2& output_size, const CSubtitle2List& sub2List, 
     CompositeDrawItemListList *compDrawItemListList /*output*/)
 {
     //check input and log error
+    XyRenderTiming::Scope timing(XyRenderTiming::COMPOSITE);
     POSITION pos=sub2List.GetHeadPosition();
     while ( pos!=NULL )
     {
@@ -3688,7 +3826,215 @@ STDMETHODIMP CRenderedTextSubtitle::Reload()
 {
     CFileStatus s;
     if(!CFile::GetStatus(m_path, s)) return E_FAIL;
-    return !m_path.IsEmpty() && Open(m_path, DEFAULT_CHARSET) ? S_OK : E_FAIL;
+    if(m_path.IsEmpty()) return E_FAIL;
+    REFERENCE_TIME rtInvalidate;
+    if(ReloadChanges(&rtInvalidate)) return S_OK;
+    Lock();
+    bool fOpened = Open(m_path, DEFAULT_CHARSET);
+    Unlock();
+    return fOpened ? S_OK : E_FAIL;
+}
+
+static bool SameEntry(const STSEntry& a, const STSEntry& b)
+{
+    return a.start==b.start && a.end==b.end && a.layer==b.layer && a.fUnicode==b.fUnicode
+        && a.marginRect==b.marginRect && a.style==b.style && a.actor==b.actor && a.effect==b.effect
+        && a.str==b.str;
+}
+
+bool CRenderedTextSubtitle::ReloadChanges( REFERENCE_TIME *rtInvalidate )
+{
+    *rtInvalidate = 0;
+    if(m_path.IsEmpty())
+    {
+        return false;
+    }
+    // the slow part, parsing, is done without holding the renderer
+    CSimpleTextSubtitle sts;
+    if(!sts.Open(m_path, DEFAULT_CHARSET))
+    {
+        return false;
+    }
+
+    Lock();
+    if(sts.m_mode!=m_mode || sts.m_dstScreenSize!=m_dstScreenSize 
+        || sts.m_defaultWrapStyle!=m_defaultWrapStyle || sts.m_collisions!=m_collisions 
+        || sts.m_fScaledBAS!=m_fScaledBAS || sts.m_eYCbCrMatrix!=m_eYCbCrMatrix 
+        || sts.m_eYCbCrRange!=m_eYCbCrRange || sts.m_animationRate!=m_animationRate 
+        || sts.m_fUsingAutoGeneratedDefaultStyle!=m_fUsingAutoGeneratedDefaultStyle)
+    {
+        Unlock();
+        return false;
+    }
+    if(m_fUsingAutoGeneratedDefaultStyle)
+    {
+        //the owner replaced the generated default style with its own, keep it
+        STSStyle def;
+        if(GetDefaultStyle(def))
+        {
+            sts.SetDefaultStyle(def);
+        }
+    }
+
+    bool fStylesChanged = sts.m_styles.GetCount()!=m_styles.GetCount();
+    CAtlMap<CString, bool, CStringElementTraits<CString>> changedStyles;
+    POSITION pos = sts.m_styles.GetStartPosition();
+    while(pos)
+    {
+        CString name;
+        STSStyle* s;
+        sts.m_styles.GetNextAssoc(pos, name, s);
+        STSStyle* old;
+        if(!m_styles.Lookup(name, old) || !(*old==*s))
+        {
+            changedStyles[name] = true;
+            fStylesChanged = true;
+        }
+    }
+
+    //lines are matched on their content, not their position, so that lines added or removed 
+    //in the middle of the script don't shift the rest out of the cache
+    CAtlMap<CStringW, CAtlList<int>*, CStringElementTraits<CStringW>> oldEntries;
+    for(size_t i=0;i<m_entries.GetCount();i++)
+    {
+        CAtlList<int>* indexes = NULL;
+        if(!oldEntries.Lookup(m_entries[i].str, indexes))
+        {
+            indexes = new CAtlList<int>();
+            oldEntries.SetAt(m_entries[i].str, indexes);
+        }
+        indexes->AddTail((int)i);
+    }
+
+    bool fChanged = m_entries.GetCount()!=sts.m_entries.GetCount();
+    int firstChange = INT_MAX;
+    CAtlArray<bool> oldKept;
+    oldKept.SetCount(m_entries.GetCount());
+    for(size_t i=0;i<oldKept.GetCount();i++)
+    {
+        oldKept[i] = false;
+    }
+    CAtlMap<int, CSubtitle*> subtitleCache;
+    for(size_t i=0;i<sts.m_entries.GetCount();i++)
+    {
+        const STSEntry& stse = sts.m_entries[i];
+        bool fStyleChanged = changedStyles.Lookup(stse.style)!=NULL 
+            || (fStylesChanged && stse.str.Find(L"\\r")>=0);//{\r<style>} may switch to any style
+        int match = -1;
+        CAtlList<int>* indexes = NULL;
+        if(!fStyleChanged && oldEntries.Lookup(stse.str, indexes))
+        {
+            for(POSITION p=indexes->GetHeadPosition();p;indexes->GetNext(p))
+            {
+                int j = indexes->GetAt(p);
+                if(SameEntry(m_entries[j], stse))
+                {
+                    match = j;
+                    indexes->RemoveAt(p);
+                    break;
+                }
+            }
+        }
+        if(match<0)
+        {
+            firstChange = min(firstChange, stse.start);
+            fChanged = true;
+            continue;
+        }
+        oldKept[match] = true;
+        fChanged |= match!=(int)i;
+        CSubtitle* s;
+        if(m_subtitleCache.Lookup(match, s))
+        {
+            subtitleCache[(int)i] = s;
+            m_subtitleCache.RemoveKey(match);
+        }
+    }
+    for(size_t i=0;i<oldKept.GetCount();i++)
+    {
+        if(!oldKept[i])
+        {
+            firstChange = min(firstChange, m_entries[i].start);
+            fChanged = true;
+        }
+    }
+    pos = oldEntries.GetStartPosition();
+    while(pos)
+    {
+        delete oldEntries.GetNextValue(pos);
+    }
+
+    //what is left in the cache belongs to changed or removed lines
+    pos = m_subtitleCache.GetStartPosition();
+    while(pos)
+    {
+        delete m_subtitleCache.GetNextValue(pos);
+    }
+    m_subtitleCache.RemoveAll();
+    pos = subtitleCache.GetStartPosition();
+    while(pos)
+    {
+        int i;
+        CSubtitle* s;
+        subtitleCache.GetNextAssoc(pos, i, s);
+        m_subtitleCache[i] = s;
+    }
+    //nothing changed: the segments keep their animated flags
+    if(fChanged || fStylesChanged)
+    {
+        m_sla.Empty();
+
+        CopyStyles(sts.m_styles);
+        m_entries.Copy(sts.m_entries);
+        //built while parsing, the segments of the new entries only cost a copy
+        m_segments.Copy(sts.m_segments);
+        m_name = sts.m_name;
+        m_encoding = sts.m_encoding;
+    }
+    Unlock();
+
+    if(firstChange==INT_MAX)
+    {
+        *rtInvalidate = _I64_MAX;
+    }
+    else if(m_mode==TIME)
+    {
+        *rtInvalidate = 10000i64*firstChange;
+    }
+    return true;
+}
+
+bool CRenderedTextSubtitle::AddPendingEntry( const STSEntry& stse )
+{
+    CAutoLock cAutoLock(&m_csPendingEntries);
+    m_pendingEntries.Add(stse);
+    if(m_pendingEntries.GetCount()==1 || stse.start<m_pendingStart)
+    {
+        m_pendingStart = stse.start;
+        return true;
+    }
+    return false;
+}
+
+void CRenderedTextSubtitle::ClearPendingEntries()
+{
+    CAutoLock cAutoLock(&m_csPendingEntries);
+    m_pendingEntries.RemoveAll();
+}
+
+void CRenderedTextSubtitle::CommitPendingEntries()
+{
+    CAtlArray<STSEntry> entries;
+    {
+        CAutoLock cAutoLock(&m_csPendingEntries);
+        if(m_pendingEntries.IsEmpty())
+        {
+            return;
+        }
+        entries.Copy(m_pendingEntries);
+        m_pendingEntries.RemoveAll();
+    }
+    AddBatch(entries);
 }
 
 STDMETHODIMP_(bool) CRenderedTextSubtitle::IsColorTypeSupported( int type )
@@ -3701,7 +4047,12 @@ STDMETHODIMP_(bool) CRenderedTextSubtitle::IsColorTypeSupported( int type )
 
 STDMETHODIMP CRenderedTextSubtitle::Lock()
 {
-    return CSubPicProviderImpl::Lock();
+    HRESULT hr = CSubPicProviderImpl::Lock();
+    if(SUCCEEDED(hr))
+    {
+        CommitPendingEntries();
+    }
+    return hr;
 }
 
 STDMETHODIMP CRenderedTextSubtitle::Unlock()
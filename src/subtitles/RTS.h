@@ -410,6 +410,11 @@ public:
 private:
     CAtlMap<int, CSubtitle*> m_subtitleCache;   
 
+    // entries received from an input pin, added at the next Lock() of the renderer
+    CCritSec m_csPendingEntries;
+    CAtlArray<STSEntry> m_pendingEntries;
+    int m_pendingStart;
+
     CScreenLayoutAllocator m_sla;
 
     CSizeCoor2 m_size_scale_to;
@@ -425,7 +430,7 @@ private:
     int m_nPolygon;
     int m_polygonBaselineOffset;
     double m_fps;
-    int m_period;//1000/m_fps
+    int m_period;//1000/m_fps, or longer if the animations are capped, see GetAnimationPeriod
     double m_target_scale_x, m_target_scale_y;
 
     static void InitCmdMap();
@@ -444,6 +449,14 @@ private:
 
     CSubtitle* GetSubtitle(int entry);
 
+    // in ms, how long a subpic of an animated segment holds at @fps, with the animation rate applied
+    int GetAnimationPeriod(double fps) const;
+    // index of the step of GetAnimationPeriod that @t falls in, relative to the start of @segment
+    int GetAnimationStep(int t, int segment, double fps);
+    // the time to draw @t at: when the animations are capped, the start of its step, so that the frame
+    // shared by a step does not depend on which of its video frames is rendered first
+    int GetAnimationTime(int t, int segment, double fps);
+
 protected:
     virtual void OnChanged();
     
@@ -468,6 +481,13 @@ public:
         const SIZECoor2& size_scale_to,
         const SIZE& size1, const CRect& video_rect, 
         REFERENCE_TIME rt, double fps);
+    // Renders the frames of @count timestamps @rts in one call, NULL for the ones without subtitles.
+    // @rts should be sorted: segments are then walked forward and every non animated segment is
+    // parsed and drawn only once, the following frames of the segment share its render frame.
+    // Animated segments are drawn once per step of GetAnimationPeriod in the same way.
+    STDMETHODIMP RenderBatch(IXySubRenderFrame**subRenderFrames, const REFERENCE_TIME *rts, int count, 
+        int spd_type, const SIZECoor2& size_scale_to, const SIZE& size1, const CRect& video_rect, 
+        double fps);
 
     // ISubPicProviderEx && ISubPicProviderEx2
     STDMETHODIMP_(POSITION) GetStartPosition(REFERENCE_TIME rt, double fps);
@@ -479,6 +499,9 @@ public:
     STDMETHODIMP Render(SubPicDesc& spd, REFERENCE_TIME rt, double fps, RECTCoor2& bbox);
     STDMETHODIMP RenderEx(SubPicDesc& spd, REFERENCE_TIME rt, double fps, CAtlList<CRectCoor2>& rectList);
     HRESULT ParseScript(REFERENCE_TIME rt, double fps, CSubtitle2List *outputSub2List );
+    void EnterSegment(int t, int segment, const STSSegment* stss);
+    HRESULT ParseSegment(int t, double fps, int segment, STSSegment* stss, CSubtitle2List *outputSub2List );
+    void SetupRender(int spd_type, const SIZECoor2& size_scale_to, const SIZE& size1, const CRect& video_rect);
     static void DoRender( const SIZECoor2& output_size, const CSubtitle2List& sub2List, 
         CompositeDrawItemListList *compDrawItemListList /*output*/);
     static void RenderOneSubtitle(const SIZECoor2& output_size, const CSubtitle2& sub2, 
@@ -494,4 +517,23 @@ public:
     STDMETHODIMP_(int) GetStream();
     STDMETHODIMP SetStream(int iStream);
     STDMETHODIMP Reload();    
+
+    // Reparses m_path and only drops what the edit touched: the cached subtitles of the lines
+    // that did not change (same timing, text and style) are kept and moved to their new index.
+    // @rtInvalidate: the start of the earliest changed line, the frames before it are still valid
+    // @return: false if the file can't be read, or if its header changed and it must be reopened
+    bool ReloadChanges(REFERENCE_TIME *rtInvalidate);
+
+    // Queues an entry without waiting for the renderer, it is added with the other pending ones
+    // in a single segment update when the renderer locks the subtitle.
+    // @return: true if the frames from @stse.start on must be invalidated, false if the 
+    //   invalidation of an earlier pending entry already covers them
+    bool AddPendingEntry(const STSEntry& stse);
+    void ClearPendingEntries();
+    // called by Lock()
+    void CommitPendingEntries();
+
+    // in fps, animations are rendered at no more than this rate unless the script sets its own 
+    // "Animation Rate", the video frames in between reuse the last render. 0 renders every frame
+    int m_maxAnimationRate;
 };
@@ -30,6 +30,7 @@
 #include <boost/flyweight/key_value.hpp>
 #include "xy_bitmap.h"
 #include "xy_widen_regoin.h"
+#include "xy_render_timing.h"
 
 #ifndef _MAX	/* avoid collision with common (nonconforming) macros */
 #define _MAX	(std::max)
@@ -597,6 +598,9 @@ void xy_gaussian_blur(PUINT8 dst, int dst_stride,
 
 void xy_be_blur(PUINT8 src, int width, int height, int stride, float pass_x, float pass_y);
 
+void xy_bilinear_shift(PUINT8 dst, int dst_width, int dst_height, int dst_stride, 
+    PCUINT8 src, int width, int height, int stride, int xshift, int yshift);
+
 /**
  * \brief blur with [[1,2,1]. [2,4,2], [1,2,1]] kernel.
  */
@@ -784,44 +788,10 @@ static void be_blur_c(unsigned char *buf, unsigned *tmp_base, int w, int h, int
     xy_free(col_pix_buf_base);
 }
 
-static void Bilinear(unsigned char *buf, int w, int h, int stride, int x_factor, int y_factor)
-{   
-    WORD *col_pix_buf_base = reinterpret_cast<WORD*>(xy_malloc(w*sizeof(WORD)));
-    if(!col_pix_buf_base)
-    {
-        //ToDo: error handling
-        return;
-    }
-    memset(col_pix_buf_base, 0, w*sizeof(WORD));
-
-    for (int y = 0; y < h; y++){
-        unsigned char *src=buf+y*stride;
-
-        WORD *col_pix_buf = col_pix_buf_base;
-        int last=0;
-        for(int x = 0; x < w; x++)
-        {
-            int temp1 = src[x];
-            int temp2 = temp1*x_factor;
-            temp1 <<= 3;
-            temp1 -= temp2;
-            temp1 += last;
-            last = temp2;
-
-            temp2 = temp1*y_factor;
-            temp1 <<= 3;
-            temp1 -= temp2;
-            temp1 += col_pix_buf[x];
-            src[x] = ((temp1+32)>>6);
-            col_pix_buf[x] = temp2;
-        }
-    }
-    xy_free(col_pix_buf_base);
-}
-
 bool Rasterizer::Rasterize(const ScanLineData2& scan_line_data2, int xsub, int ysub, SharedPtrOverlay overlay)
 {
     using namespace ::boost::flyweights;
+    XyRenderTiming::Scope timing(XyRenderTiming::RASTERIZE);
 
     if(!overlay)
     {
@@ -910,7 +880,7 @@ bool Rasterizer::Rasterize(const ScanLineData2& scan_line_data2, int xsub, int y
             }
         }
     }
-
+    overlay->UpdateTileFlags();
     return true;
 }
 
@@ -1076,7 +1046,7 @@ bool Rasterizer::OldFixedPointBlur(const Overlay& input_overlay, float be_streng
         xy_be_blur(blur_plan, output_overlay->mOverlayWidth, output_overlay->mOverlayHeight, pitch, 
             scaled_be_strength-pass_num, scaled_be_strength-pass_num);
     }
-
+    output_overlay->UpdateTileFlags();
     return true;
 }
 
@@ -1087,6 +1057,7 @@ bool Rasterizer::Blur(const Overlay& input_overlay, float be_strength,
     SharedPtrOverlay output_overlay)
 {
     using namespace ::boost::flyweights;
+    XyRenderTiming::Scope timing(XyRenderTiming::BLUR);
 
     ASSERT(IsItReallyBlur(be_strength, gaussian_blur_strength));
     if(!output_overlay || !IsItReallyBlur(be_strength, gaussian_blur_strength))
@@ -1128,6 +1099,7 @@ bool Rasterizer::Blur(const Overlay& input_overlay, float be_strength,
         bool rv = BeBlur(input_overlay, be_strength, target_scale_x, target_scale_y, output_overlay);
         ASSERT(rv);
     }
+    output_overlay->UpdateTileFlags();
     return true;
 }
 
@@ -1785,10 +1757,50 @@ void Rasterizer::Draw(XyBitmap* bitmap, SharedPtrOverlay overlay, const CRect& c
     if(PLANAR)
         draw_method |= DM::AYUV_PLANAR;
     
+    if (!overlay->mTileFlags)
+    {
+        _Draw(bitmap, s_base, overlayPitch, x, y, w, h, xo, yo, switchpts, draw_method);
+        return;
+    }
+    // Only draw runs of tiles that are not empty. Alpha 0 pixels leave the bitmap untouched anyway.
+    const int tile_x_begin = xo>>Overlay::TILE_SHIFT;
+    const int tile_x_end = (xo+w-1)>>Overlay::TILE_SHIFT;
+    const int tile_y_end = (yo+h-1)>>Overlay::TILE_SHIFT;
+    for (int tile_y=yo>>Overlay::TILE_SHIFT; tile_y<=tile_y_end; tile_y++)
+    {
+        int y0 = max(yo, tile_y<<Overlay::TILE_SHIFT);
+        int y1 = min(yo+h, (tile_y+1)<<Overlay::TILE_SHIFT);
+        int tile_x = tile_x_begin;
+        while (tile_x<=tile_x_end)
+        {
+            while (tile_x<=tile_x_end && overlay->GetTileCoverage(tile_x, tile_y, fBody, fBorder)==0)
+            {
+                tile_x++;
+            }
+            if (tile_x>tile_x_end)
+            {
+                break;
+            }
+            int run_begin = tile_x;
+            while (tile_x<=tile_x_end && overlay->GetTileCoverage(tile_x, tile_y, fBody, fBorder)!=0)
+            {
+                tile_x++;
+            }
+            int x0 = max(xo, run_begin<<Overlay::TILE_SHIFT);
+            int x1 = min(xo+w, tile_x<<Overlay::TILE_SHIFT);
+            _Draw(bitmap, s_base, overlayPitch, x+x0-xo, y+y0-yo, x1-x0, y1-y0, x0, y0, switchpts, draw_method);
+        }
+    }
+}
+
+void Rasterizer::_Draw(XyBitmap* bitmap, const byte* s_base, int overlayPitch, 
+    int x, int y, int w, int h, int xo, int yo, 
+    const DWORD* switchpts, int draw_method)
+{
     // draw
     // Grab the first colour
     DWORD color = switchpts[0];
-    const byte* s = s_base + overlay->mOverlayPitch*yo + xo;
+    const byte* s = s_base + overlayPitch*yo + xo;
     
     int dst_offset = 0;
     if (bitmap->type==XyBitmap::PLANNA)
@@ -2435,6 +2447,64 @@ void Overlay::_DoFillAlphaMash_c(byte* outputAlphaMask, const byte* pBody, const
 }
 
 void Overlay::FillAlphaMash( byte* outputAlphaMask, bool fBody, bool fBorder, int x, int y, int w, int h, const byte* pAlphaMask, int pitch, DWORD color_alpha)
+{
+    if (!mTileFlags || w<=0 || h<=0)
+    {
+        _FillAlphaMash(outputAlphaMask, fBody, fBorder, x, y, w, h, pAlphaMask, pitch, color_alpha);
+        return;
+    }
+    // Merge horizontal runs of tiles with the same constant coverage (-1 for non constant ones), 
+    // fill constant runs directly and only composite the others.
+    const int tile_x_end = (x+w-1)>>TILE_SHIFT;
+    const int tile_y_end = (y+h-1)>>TILE_SHIFT;
+    for (int tile_y=y>>TILE_SHIFT; tile_y<=tile_y_end; tile_y++)
+    {
+        int y0 = max(y, tile_y<<TILE_SHIFT);
+        int y1 = min(y+h, (tile_y+1)<<TILE_SHIFT);
+        int run_begin = x;
+        int run_coverage = GetTileCoverage(x>>TILE_SHIFT, tile_y, fBody, fBorder);
+        if (pAlphaMask!=NULL && run_coverage>0)
+        {
+            run_coverage = -1;
+        }
+        for (int tile_x=(x>>TILE_SHIFT)+1; tile_x<=tile_x_end+1; tile_x++)
+        {
+            int coverage = -2;//end of line
+            if (tile_x<=tile_x_end)
+            {
+                coverage = GetTileCoverage(tile_x, tile_y, fBody, fBorder);
+                if (pAlphaMask!=NULL && coverage>0)
+                {
+                    coverage = -1;
+                }
+            }
+            if (coverage==run_coverage)
+            {
+                continue;
+            }
+            int run_end = min(x+w, tile_x<<TILE_SHIFT);
+            if (run_coverage<0)
+            {
+                _FillAlphaMash(outputAlphaMask, fBody, fBorder, run_begin, y0, run_end-run_begin, y1-y0, 
+                    pAlphaMask!=NULL ? pAlphaMask + (y0-y)*pitch + (run_begin-x) : NULL, pitch, color_alpha);
+            }
+            else
+            {
+                byte value = (run_coverage * color_alpha)>>6;
+                byte* dst = outputAlphaMask + y0*mOverlayPitch + run_begin;
+                for (int i=y0;i<y1;i++)
+                {
+                    memset(dst, value, run_end-run_begin);
+                    dst += mOverlayPitch;
+                }
+            }
+            run_begin = run_end;
+            run_coverage = coverage;
+        }
+    }
+}
+
+void Overlay::_FillAlphaMash( byte* outputAlphaMask, bool fBody, bool fBorder, int x, int y, int w, int h, const byte* pAlphaMask, int pitch, DWORD color_alpha)
 {
     if(!fBorder && fBody && pAlphaMask==NULL)
     {
@@ -2463,6 +2533,94 @@ void Overlay::FillAlphaMash( byte* outputAlphaMask, bool fBody, bool fBorder, in
     }
 }
 
+static BYTE GetPlanTileFlag(const BYTE* plan, int pitch, int w, int h, BYTE not_empty_flag, BYTE full_flag)
+{
+    bool not_empty = false;
+    bool full = true;
+    for (int i=0;i<h;i++)
+    {
+        for (int j=0;j<w;j++)
+        {
+            not_empty |= plan[j]!=0;
+            full &= plan[j]==Overlay::FULL_COVERAGE;
+        }
+        if (not_empty && !full)
+        {
+            break;
+        }
+        plan += pitch;
+    }
+    return (not_empty ? not_empty_flag : 0) | (full ? full_flag : 0);
+}
+
+bool Overlay::UpdateTileFlags()
+{
+    mTileFlags.reset((BYTE*)NULL);
+    mTileColumns = (mOverlayWidth+TILE_SIZE-1)>>TILE_SHIFT;
+    mTileRows = (mOverlayHeight+TILE_SIZE-1)>>TILE_SHIFT;
+    if (mTileColumns<=0 || mTileRows<=0 || !mBody)
+    {
+        mTileColumns = mTileRows = 0;
+        return false;
+    }
+    BYTE* flags = reinterpret_cast<BYTE*>(xy_malloc(mTileColumns*mTileRows));
+    if (flags==NULL)
+    {
+        mTileColumns = mTileRows = 0;
+        return false;
+    }
+    for (int tile_y=0;tile_y<mTileRows;tile_y++)
+    {
+        int y = tile_y<<TILE_SHIFT;
+        int h = min(TILE_SIZE, mOverlayHeight-y);
+        for (int tile_x=0;tile_x<mTileColumns;tile_x++)
+        {
+            int x = tile_x<<TILE_SHIFT;
+            int w = min(TILE_SIZE, mOverlayWidth-x);
+            int offset = y*mOverlayPitch + x;
+            BYTE flag = GetPlanTileFlag(mBody.get()+offset, mOverlayPitch, w, h, TILE_BODY_NOT_EMPTY, TILE_BODY_FULL);
+            if (mBorder)
+            {
+                flag |= GetPlanTileFlag(mBorder.get()+offset, mOverlayPitch, w, h, TILE_BORDER_NOT_EMPTY, TILE_BORDER_FULL);
+            }
+            flags[tile_y*mTileColumns + tile_x] = flag;
+        }
+    }
+    mTileFlags.reset(flags, xy_free);
+    return true;
+}
+
+int Overlay::GetTileCoverage( int tile_x, int tile_y, bool fBody, bool fBorder ) const
+{
+    if (!mTileFlags || tile_x<0 || tile_y<0 || tile_x>=mTileColumns || tile_y>=mTileRows)
+    {
+        return -1;
+    }
+    BYTE flag = mTileFlags.get()[tile_y*mTileColumns + tile_x];
+    if (fBody && !fBorder)
+    {
+        return !(flag & TILE_BODY_NOT_EMPTY) ? 0 : (flag & TILE_BODY_FULL) ? FULL_COVERAGE : -1;
+    }
+    else if (fBody && fBorder)
+    {
+        //the border plan contains the body
+        return !(flag & TILE_BORDER_NOT_EMPTY) ? 0 : (flag & TILE_BORDER_FULL) ? FULL_COVERAGE : -1;
+    }
+    else
+    {
+        //border - body
+        if (!(flag & TILE_BORDER_NOT_EMPTY) || (flag & TILE_BODY_FULL))
+        {
+            return 0;
+        }
+        if ((flag & TILE_BORDER_FULL) && !(flag & TILE_BODY_NOT_EMPTY))
+        {
+            return FULL_COVERAGE;
+        }
+        return -1;
+    }
+}
+
 Overlay* Overlay::GetSubpixelVariance(unsigned int xshift, unsigned int yshift)
 {
     Overlay* overlay = new Overlay();
@@ -2485,81 +2643,37 @@ Overlay* Overlay::GetSubpixelVariance(unsigned int xshift, unsigned int yshift)
 
     overlay->mfWideOutlineEmpty = mfWideOutlineEmpty;
 
-    if (overlay->mOverlayPitch * overlay->mOverlayHeight<=0)
+    if (overlay->mOverlayPitch * overlay->mOverlayHeight<=0 || !mBody || 
+        (!mfWideOutlineEmpty && !mBorder) ||
+        overlay->mOverlayWidth<mOverlayWidth || overlay->mOverlayHeight<mOverlayHeight)
     {
+        delete overlay;
         return NULL;
     }
 
+    // no memset/memcpy needed: xy_bilinear_shift writes every byte of the destination plan
     BYTE* body = reinterpret_cast<BYTE*>(xy_malloc(overlay->mOverlayPitch * overlay->mOverlayHeight));
     if( body==NULL )
     {
+        delete overlay;
         return NULL;
     }
     overlay->mBody.reset(body, xy_free);
-    memset(body, 0, overlay->mOverlayPitch*overlay->mOverlayHeight);
-    BYTE* border = NULL;
+    xy_bilinear_shift(body, overlay->mOverlayWidth, overlay->mOverlayHeight, overlay->mOverlayPitch, 
+        mBody.get(), mOverlayWidth, mOverlayHeight, mOverlayPitch, xshift, yshift);
     if (!overlay->mfWideOutlineEmpty)
     {
-        border = reinterpret_cast<BYTE*>(xy_malloc(overlay->mOverlayPitch * overlay->mOverlayHeight));
+        BYTE* border = reinterpret_cast<BYTE*>(xy_malloc(overlay->mOverlayPitch * overlay->mOverlayHeight));
         if (border==NULL)
         {
+            delete overlay;
             return NULL;
         }
         overlay->mBorder.reset(border, xy_free);
-        memset(border, 0, overlay->mOverlayPitch*overlay->mOverlayHeight);
+        xy_bilinear_shift(border, overlay->mOverlayWidth, overlay->mOverlayHeight, overlay->mOverlayPitch, 
+            mBorder.get(), mOverlayWidth, mOverlayHeight, mOverlayPitch, xshift, yshift);
     }
-    
-    if( overlay->mOverlayPitch==mOverlayPitch && overlay->mOverlayWidth==mOverlayWidth &&
-        overlay->mOverlayHeight>=mOverlayHeight )
-    {
-        if (body && mBody)
-        {
-            memcpy(body, mBody.get(), mOverlayPitch * mOverlayHeight);
-        }
-        else if ( (!!body)!=(!!mBody)/*==NULL*/)
-        {
-            return NULL;
-        }
-        
-        if (border && mBorder)
-        {
-            memcpy(border, mBorder.get(), mOverlayPitch * mOverlayHeight);
-        }
-        else if ( (!!border)!=(!!mBorder)/*==NULL*/ )
-        {
-            return NULL;
-        }
-    }
-    else
-    {
-        byte* dst = body;
-        const byte* src = mBody.get();
-        for (int i=0;i<mOverlayHeight;i++)
-        {
-            memcpy(dst, src, mOverlayWidth);
-            dst += overlay->mOverlayPitch;
-            src += mOverlayPitch;
-        }
-        if (!overlay->mfWideOutlineEmpty)
-        {
-            ASSERT(border && mBorder);
-            dst = border;
-            src = mBorder.get();
-            for (int i=0;i<mOverlayHeight;i++)
-            {
-                memcpy(dst, src, mOverlayWidth);
-                dst += overlay->mOverlayPitch;
-                src += mOverlayPitch;
-            }
-        }
-    }
-    //not equal
-    //  Bilinear(overlay->mpOverlayBuffer.base, overlay->mOverlayWidth, 2*overlay->mOverlayHeight, overlay->mOverlayPitch, xshift, yshift);
-    Bilinear(body, overlay->mOverlayWidth, overlay->mOverlayHeight, overlay->mOverlayPitch, xshift, yshift);
-    if (!overlay->mfWideOutlineEmpty)
-    {
-        Bilinear(border, overlay->mOverlayWidth, overlay->mOverlayHeight, overlay->mOverlayPitch, xshift, yshift);
-    }    
+    overlay->UpdateTileFlags();
     return overlay;
 }
 
@@ -2913,6 +3027,7 @@ void ScanLineData::_EvaluateLine(int x0, int y0, int x1, int y1)
 
 bool ScanLineData::ScanConvert(const PathData& path_data, const CSize& size)
 {
+    XyRenderTiming::Scope timing(XyRenderTiming::SCAN_CONVERT);
     int lastmoveto = -1;
     int i;
     // Drop any outlines we may have.
@@ -3033,6 +3148,7 @@ void ScanLineData::DeleteOutlines()
 
 bool ScanLineData2::CreateWidenedRegion(int rx, int ry)
 {
+    XyRenderTiming::Scope timing(XyRenderTiming::WIDEN);
     if(rx < 0) rx = 0;
     if(ry < 0) ry = 0;
     mWideBorder = max(rx,ry);
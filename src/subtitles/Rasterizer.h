@@ -144,11 +144,27 @@ typedef ::boost::shared_ptr<BYTE> SharedPtrByte;
 struct Overlay
 {
 public:
+    // Tiles of TILE_SIZE*TILE_SIZE overlay pixels, flagged by UpdateTileFlags so that 
+    // empty or fully covered areas of big, mostly empty masks can be skipped or filled quickly
+    enum
+    {
+        TILE_SHIFT = 5,
+        TILE_SIZE = 1<<TILE_SHIFT,
+
+        TILE_BODY_NOT_EMPTY   = 1,
+        TILE_BODY_FULL        = 1<<1,
+        TILE_BORDER_NOT_EMPTY = 1<<2,
+        TILE_BORDER_FULL      = 1<<3,
+
+        FULL_COVERAGE = 64 //8x8 subsamples
+    };
+
     Overlay()
     {
         mOffsetX=mOffsetY=mWidth=mHeight=0;
         mOverlayWidth=mOverlayHeight=mOverlayPitch=0;
         mfWideOutlineEmpty = false;
+        mTileColumns=mTileRows=0;
     }
     ~Overlay()
     {
@@ -162,6 +178,8 @@ public:
         mOffsetX=mOffsetY=mWidth=mHeight=0;
         mOverlayWidth=mOverlayHeight=mOverlayPitch=0;
         mfWideOutlineEmpty = false;
+        mTileFlags.reset((BYTE*)NULL);
+        mTileColumns=mTileRows=0;
     }
 
     void FillAlphaMash(byte* outputAlphaMask, bool fBody, bool fBorder, 
@@ -169,6 +187,12 @@ public:
         const byte* pAlphaMask, int pitch, DWORD color_alpha);
 
     Overlay* GetSubpixelVariance(unsigned int xshift, unsigned int yshift);
+
+    // Rebuild mTileFlags from mBody/mBorder. MUST be called again after the plans are modified.
+    bool UpdateTileFlags();
+    // @return: the coverage (0 or FULL_COVERAGE) shared by all pixels of the tile in the alpha mask 
+    //   selected by @fBody and @fBorder (see FillAlphaMash), or -1 if it is unknown or not constant.
+    int GetTileCoverage(int tile_x, int tile_y, bool fBody, bool fBorder) const;
 public:
     SharedPtrByte mBody;
     SharedPtrByte mBorder;
@@ -178,7 +202,13 @@ public:
     int mOverlayWidth, mOverlayHeight, mOverlayPitch;
 
     bool mfWideOutlineEmpty;//specially for blur
+
+    SharedPtrByte mTileFlags;//NULL if not available
+    int mTileColumns, mTileRows;
 private:
+    void _FillAlphaMash(byte* outputAlphaMask, bool fBody, bool fBorder, 
+        int x, int y, int w, int h, 
+        const byte* pAlphaMask, int pitch, DWORD color_alpha);
     void _DoFillAlphaMash(byte* outputAlphaMask, const byte* pBody, const byte* pBorder,
         int x, int y, int w, int h,
         const byte* pAlphaMask, int pitch, DWORD color_alpha);
@@ -248,6 +278,10 @@ public:
         const DWORD* switchpts, bool fBody, bool fBorder);
 		
 	static void FillSolidRect(SubPicDesc& spd, int x, int y, int nWidth, int nHeight, DWORD lColor);
-	
+private:
+    // draw s_base[yo..yo+h, xo..xo+w] to bitmap at (x,y)
+    static void _Draw(XyBitmap* bitmap, const byte* s_base, int overlay_pitch, 
+        int x, int y, int w, int h, int xo, int yo, 
+        const DWORD* switchpts, int draw_method);
 };
 
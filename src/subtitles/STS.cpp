@@ -1396,6 +1396,7 @@ static bool OpenSubStationAlpha(CTextFile* file, CSimpleTextSubtitle& ret, int C
 
     ret.m_eYCbCrMatrix = CSimpleTextSubtitle::YCbCrMatrix_BT601;
     ret.m_eYCbCrRange  = CSimpleTextSubtitle::YCbCrRange_TV;
+    ret.m_animationRate = -1;
 
     CStringW buff;
     while(file->ReadString(buff))
@@ -1512,6 +1513,20 @@ static bool OpenSubStationAlpha(CTextFile* file, CSimpleTextSubtitle& ret, int C
             buff.MakeLower();
             ret.m_fScaledBAS = buff.Find(L"yes") >= 0;
         }
+        else if(entry == L"animation rate")
+        {
+            buff = GetStr(buff);
+            buff.MakeLower();
+            if(buff.Find(L"exact") >= 0)
+            {
+                ret.m_animationRate = 0;
+            }
+            else
+            {
+                try {ret.m_animationRate = max(GetInt(buff), 0);}
+                catch(...) {ret.m_animationRate = -1;}
+            }
+        }
         else if(entry == L"[v4 styles]")
         {
             fRet = true;
@@ -1890,6 +1905,7 @@ CSimpleTextSubtitle::CSimpleTextSubtitle()
     m_dPARCompensation = 1.0;
     m_eYCbCrMatrix = YCbCrMatrix_AUTO;
     m_eYCbCrRange = YCbCrRange_AUTO;
+    m_animationRate = -1;
 }
 
 CSimpleTextSubtitle::~CSimpleTextSubtitle()
@@ -1932,6 +1948,7 @@ void CSimpleTextSubtitle::Copy(CSimpleTextSubtitle& sts)
     m_defaultWrapStyle = sts.m_defaultWrapStyle;
     m_collisions = sts.m_collisions;
     m_fScaledBAS = sts.m_fScaledBAS;
+    m_animationRate = sts.m_animationRate;
     m_encoding = sts.m_encoding;
     m_fUsingAutoGeneratedDefaultStyle = sts.m_fUsingAutoGeneratedDefaultStyle;
     CopyStyles(sts.m_styles);
@@ -2211,6 +2228,32 @@ void CSimpleTextSubtitle::AddSTSEntryOnly( CStringW str, bool fUnicode, int star
     return;
 }
 
+void CSimpleTextSubtitle::AddBatch( const CAtlArray<STSEntry>& entries )
+{
+    //Add() inserts into the segments in linear time, past a few entries rebuilding them all is cheaper
+    const size_t MIN_REBUILD_BATCH = 8;
+    if(entries.GetCount() < MIN_REBUILD_BATCH)
+    {
+        for(size_t i = 0; i < entries.GetCount(); i++)
+        {
+            const STSEntry& e = entries[i];
+            Add(e.str, e.fUnicode, e.start, e.end, e.style, e.actor, e.effect, e.marginRect, e.layer, e.readorder);
+        }
+        return;
+    }
+    size_t count = m_entries.GetCount();
+    for(size_t i = 0; i < entries.GetCount(); i++)
+    {
+        const STSEntry& e = entries[i];
+        CStringW str = e.str;
+        AddSTSEntryOnly(str.Trim(), e.fUnicode, e.start, e.end, e.style, e.actor, e.effect, e.marginRect, e.layer, e.readorder);
+    }
+    if(m_entries.GetCount() != count)
+    {
+        BuildSegments();
+    }
+}
+
 STSStyle* CSimpleTextSubtitle::CreateDefaultStyle(int CharSet)
 {
     STSStyle* ret = NULL;
@@ -2707,6 +2750,12 @@ static int intcomp(const void* i1, const void* i2)
 }
 
 void CSimpleTextSubtitle::CreateSegments()
+{
+    BuildSegments();
+    OnChanged();
+}
+
+void CSimpleTextSubtitle::BuildSegments()
 {
     m_segments.RemoveAll();
 
@@ -2761,7 +2810,6 @@ void CSimpleTextSubtitle::CreateSegments()
             if(tempSegments[i].subs.GetCount()>0)
                 m_segments.Add(tempSegments[i]);
     }
-    OnChanged();
 /*
     for(i = 0, j = m_segments.GetCount(); i < j; i++)
     {
@@ -2947,6 +2995,8 @@ bool CSimpleTextSubtitle::SaveAs(CString fn, exttype et, double fps, CTextFile::
         str += (et == EXTSSA) ? _T("ScriptType: v4.00\n") : _T("ScriptType: v4.00+\n");
         str += (m_collisions == 0) ? _T("Collisions: Normal\n") : _T("Collisions: Reverse\n");
         if(et == EXTASS && m_fScaledBAS) str += _T("ScaledBorderAndShadow: Yes\n");
+        if(et == EXTASS && m_animationRate == 0) str += _T("Animation Rate: Exact\n");
+        else if(et == EXTASS && m_animationRate > 0) str.AppendFormat(_T("Animation Rate: %d\n"), m_animationRate);
         str += _T("PlayResX: %d\n");
         str += _T("PlayResY: %d\n");
         str += _T("Timer: 100.0000\n");
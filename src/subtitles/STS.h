@@ -162,6 +162,8 @@ protected:
     CAtlArray<STSEntry> m_entries;
     CAtlArray<STSSegment> m_segments;
 	virtual void OnChanged() {}
+    //CreateSegments() without OnChanged(): the entry indexes are left untouched
+    void BuildSegments();
 
 public:
 	CString m_name;
@@ -204,6 +206,10 @@ public:
     };
     YCbCrMatrix m_eYCbCrMatrix;
     YCbCrRange m_eYCbCrRange;
+
+    //"Animation Rate" of [Script Info], in fps: the animations of the script are rendered at no more
+    //than this rate, 0 ("exact") for every video frame, <0 if not set and left to the user's option
+    int m_animationRate;
 public:
 	CSimpleTextSubtitle();
 	virtual ~CSimpleTextSubtitle();
@@ -236,6 +242,9 @@ public:
     //remember to call sort when all STSEntrys are ready
 	void AddSTSEntryOnly(CStringW str, bool fUnicode, int start, int end, CString style = _T("Default"), const CString& actor = _T(""), const CString& effect = _T(""), const CRect& marginRect = CRect(0,0,0,0), int layer = 0, int readorder = -1);
 
+    //add the STSEntrys as Add() would one by one, with a single segment update for large batches
+    void AddBatch(const CAtlArray<STSEntry>& entries);
+
 	STSStyle* CreateDefaultStyle(int CharSet);
 	void ChangeUnknownStylesToDefault();
 	void AddStyle(CString name, STSStyle* style); // style will be stored and freed in Empty() later
@@ -198,6 +198,7 @@ STDMETHODIMP CSubtitleInputPin::NewSegment(REFERENCE_TIME tStart, REFERENCE_TIME
 	{
 		CAutoLock cAutoLock(m_pSubLock);
 		CRenderedTextSubtitle* pRTS = dynamic_cast<CRenderedTextSubtitle*>(static_cast<ISubStream*>(m_pSubStream));
+		pRTS->ClearPendingEntries();
 		pRTS->RemoveAllEntries();
         pRTS->CreateSegments();
 	}
@@ -225,6 +226,20 @@ STDMETHODIMP CSubtitleInputPin::NewSegment(REFERENCE_TIME tStart, REFERENCE_TIME
 	return __super::NewSegment(tStart, tStop, dRate);
 }
 
+static STSEntry MakeEntry(const CStringW& str, bool fUnicode, int start, int end)
+{
+	STSEntry stse;
+	stse.str = str;
+	stse.fUnicode = fUnicode;
+	stse.style = _T("Default");
+	stse.marginRect = CRect(0,0,0,0);
+	stse.layer = 0;
+	stse.start = start;
+	stse.end = end;
+	stse.readorder = -1;
+	return stse;
+}
+
 interface __declspec(uuid("D3D92BC3-713B-451B-9122-320095D51EA5"))
 IMpeg2DemultiplexerTesting :
 public IUnknown {
@@ -253,11 +268,11 @@ STDMETHODIMP CSubtitleInputPin::Receive(IMediaSample* pSample)
 
 	int len = pSample->GetActualDataLength();
 
+	// text entries are queued on the subtitle instead of taking m_pSubLock for every sample
 	bool fInvalidate = false;
 
 	if(m_mt.majortype == MEDIATYPE_Text)
 	{
-		CAutoLock cAutoLock(m_pSubLock);
 		CRenderedTextSubtitle* pRTS = dynamic_cast<CRenderedTextSubtitle*>(static_cast<ISubStream*>(m_pSubStream));
 
 		if(!strncmp((char*)pData, __GAB1__, strlen(__GAB1__)))
@@ -272,21 +287,21 @@ STDMETHODIMP CSubtitleInputPin::Receive(IMediaSample* pSample)
 
 				if(tag == __GAB1_LANGUAGE__)
 				{
+					CAutoLock cAutoLock(m_pSubLock);
 					pRTS->m_name = CString(ptr);
 				}
 				else if(tag == __GAB1_ENTRY__)
 				{
-					pRTS->Add(AToW(&ptr[8]), false, *(int*)ptr, *(int*)(ptr+4));
-					fInvalidate = true;
+					fInvalidate |= pRTS->AddPendingEntry(MakeEntry(AToW(&ptr[8]), false, *(int*)ptr, *(int*)(ptr+4)));
 				}
 				else if(tag == __GAB1_LANGUAGE_UNICODE__)
 				{
+					CAutoLock cAutoLock(m_pSubLock);
 					pRTS->m_name = (WCHAR*)ptr;
 				}
 				else if(tag == __GAB1_ENTRY_UNICODE__)
 				{
-					pRTS->Add((WCHAR*)(ptr+8), true, *(int*)ptr, *(int*)(ptr+4));
-					fInvalidate = true;
+					fInvalidate |= pRTS->AddPendingEntry(MakeEntry((WCHAR*)(ptr+8), true, *(int*)ptr, *(int*)(ptr+4)));
 				}
 
 				ptr += size;
@@ -304,11 +319,20 @@ STDMETHODIMP CSubtitleInputPin::Receive(IMediaSample* pSample)
 
 				if(tag == __GAB1_LANGUAGE_UNICODE__)
 				{
+					CAutoLock cAutoLock(m_pSubLock);
 					pRTS->m_name = (WCHAR*)ptr;
 				}
 				else if(tag == __GAB1_RAWTEXTSUBTITLE__)
 				{
-					pRTS->Open((BYTE*)ptr, size, DEFAULT_CHARSET, pRTS->m_name);
+					// parse the script aside, the renderer only waits for the copy
+					CSimpleTextSubtitle sts;
+					sts.Open((BYTE*)ptr, size, DEFAULT_CHARSET, pRTS->m_name);
+
+					CAutoLock cAutoLock(m_pSubLock);
+					pRTS->ClearPendingEntries();
+					pRTS->Copy(sts);
+					pRTS->m_eYCbCrMatrix = sts.m_eYCbCrMatrix;
+					pRTS->m_eYCbCrRange = sts.m_eYCbCrRange;
 					fInvalidate = true;
 				}
 
@@ -324,15 +348,12 @@ STDMETHODIMP CSubtitleInputPin::Receive(IMediaSample* pSample)
 
 			if(!str.IsEmpty())
 			{
-				pRTS->Add(AToW(str), false, (int)(tStart / 10000), (int)(tStop / 10000));
-				fInvalidate = true;
+				fInvalidate = pRTS->AddPendingEntry(MakeEntry(AToW(str), false, (int)(tStart / 10000), (int)(tStop / 10000)));
 			}
 		}
 	}
 	else if(m_mt.majortype == MEDIATYPE_Subtitle)
 	{
-		CAutoLock cAutoLock(m_pSubLock);
-
 		if(m_mt.subtype == MEDIASUBTYPE_UTF8)
 		{
 			CRenderedTextSubtitle* pRTS = dynamic_cast<CRenderedTextSubtitle*>(static_cast<ISubStream*>(m_pSubStream));
@@ -340,8 +361,7 @@ STDMETHODIMP CSubtitleInputPin::Receive(IMediaSample* pSample)
 			CStringW str = UTF8To16(CStringA((LPCSTR)pData, len)).Trim();
 			if(!str.IsEmpty())
 			{
-				pRTS->Add(str, true, (int)(tStart / 10000), (int)(tStop / 10000));
-				fInvalidate = true;
+				fInvalidate = pRTS->AddPendingEntry(MakeEntry(str, true, (int)(tStart / 10000), (int)(tStop / 10000)));
 			}
 		}
 		else if(m_mt.subtype == MEDIASUBTYPE_SSA || m_mt.subtype == MEDIASUBTYPE_ASS || m_mt.subtype == MEDIASUBTYPE_ASS2)
@@ -351,7 +371,7 @@ STDMETHODIMP CSubtitleInputPin::Receive(IMediaSample* pSample)
 			CStringW str = UTF8To16(CStringA((LPCSTR)pData, len)).Trim();
 			if(!str.IsEmpty())
 			{
-				STSEntry stse;
+				STSEntry stse = MakeEntry(L"", true, (int)(tStart / 10000), (int)(tStop / 10000));
 
 				int fields = m_mt.subtype == MEDIASUBTYPE_ASS2 ? 10 : 9;
 
@@ -373,14 +393,13 @@ STDMETHODIMP CSubtitleInputPin::Receive(IMediaSample* pSample)
 
 				if(!stse.str.IsEmpty())
 				{
-					pRTS->Add(stse.str, true, (int)(tStart / 10000), (int)(tStop / 10000), 
-						stse.style, stse.actor, stse.effect, stse.marginRect, stse.layer, stse.readorder);
-					fInvalidate = true;
+					fInvalidate = pRTS->AddPendingEntry(stse);
 				}
 			}
 		}
 		else if(m_mt.subtype == MEDIASUBTYPE_SSF)
 		{
+			CAutoLock cAutoLock(m_pSubLock);
 			ssf::CRenderer* pSSF = dynamic_cast<ssf::CRenderer*>(static_cast<ISubStream*>(m_pSubStream));
 
 			CStringW str = UTF8To16(CStringA((LPCSTR)pData, len)).Trim();
@@ -392,6 +411,9 @@ STDMETHODIMP CSubtitleInputPin::Receive(IMediaSample* pSample)
 		}
 		else if(m_mt.subtype == MEDIASUBTYPE_VOBSUB)
 		{
+			// the renderer keeps the POSITIONs of the subpictures across several calls under this lock,
+			// and Add may remove the ones at the tail
+			CAutoLock cAutoLock(m_pSubLock);
 			CVobSubStream* pVSS = dynamic_cast<CVobSubStream*>(static_cast<ISubStream*>(m_pSubStream));
 			pVSS->Add(tStart, tStop, pData, len);
 		}
@@ -37,6 +37,9 @@ class CSubtitleInputPin : public CBaseInputPin
 protected:
 	virtual void AddSubStream(ISubStream* pSubStream) = 0;
 	virtual void RemoveSubStream(ISubStream* pSubStream) = 0;
+	// Called from the streaming thread, without any lock held and possibly while the new entries
+	// are still pending: it must not wait for the renderer, only make the next lookup drop the 
+	// frames after rtStart.
 	virtual void InvalidateSubtitle(REFERENCE_TIME rtStart, ISubStream* pSubStream) = 0;
 	bool		 IsHdmvSub(const CMediaType* pmt);
 
@@ -0,0 +1,280 @@
+#include "stdafx.h"
+#include "SupFile.h"
+
+CSupFile::CSupFile(CCritSec* pLock)
+    : CSubPicProviderImpl(pLock)
+    , m_hFile(INVALID_HANDLE_VALUE)
+    , m_hMapping(NULL)
+    , m_pData(NULL)
+    , m_nSize(0)
+    , m_nFirstFed(0)
+    , m_nFed(0)
+    , m_rtLast(0)
+{
+}
+
+CSupFile::~CSupFile(void)
+{
+    Close();
+}
+
+bool CSupFile::Open(CString fn)
+{
+    CAutoLock cAutoLock(&m_csCritSec);
+
+    Close();
+
+    m_hFile = CreateFile(fn, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+    if (m_hFile == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_hFile, &size) || size.QuadPart < RECORD_HEADER_SIZE + 3 || (SIZE_T)size.QuadPart != size.QuadPart) {
+        Close();
+        return false;
+    }
+    m_nSize = size.QuadPart;
+    m_hMapping = CreateFileMapping(m_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (m_hMapping) {
+        m_pData = (const BYTE*)MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+    }
+    if (!m_pData || !BuildIndex()) {
+        Close();
+        return false;
+    }
+
+    m_fn = fn;
+    m_name = fn.Mid(fn.ReverseFind('\\') + 1);
+    return true;
+}
+
+void CSupFile::Close()
+{
+    CAutoLock cAutoLock(&m_csCritSec);
+
+    m_sub.Reset();
+    m_index.clear();
+    m_nFirstFed = m_nFed = 0;
+    m_rtLast = 0;
+
+    if (m_pData) {
+        UnmapViewOfFile(m_pData);
+        m_pData = NULL;
+    }
+    if (m_hMapping) {
+        CloseHandle(m_hMapping);
+        m_hMapping = NULL;
+    }
+    if (m_hFile != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_hFile);
+        m_hFile = INVALID_HANDLE_VALUE;
+    }
+    m_nSize = 0;
+}
+
+bool CSupFile::BuildIndex()
+{
+    m_index.clear();
+
+    __int64 pos = 0;
+    while (pos + RECORD_HEADER_SIZE + 3 <= m_nSize) {
+        const BYTE* p = m_pData + pos;
+        if (p[0] != 'P' || p[1] != 'G') {
+            break;
+        }
+        __int64 pts = ((__int64)p[2] << 24) | (p[3] << 16) | (p[4] << 8) | p[5];
+        BYTE type = p[RECORD_HEADER_SIZE];
+        int size = (p[RECORD_HEADER_SIZE + 1] << 8) | p[RECORD_HEADER_SIZE + 2];
+        if (pos + RECORD_HEADER_SIZE + 3 + size > m_nSize) {
+            break;  // Truncated
+        }
+        if (type == CHdmvSub::PRESENTATION_SEG && size >= 8) {
+            DisplaySet ds;
+            ds.rtStart = pts * 1000 / 9;
+            ds.offset = pos;
+            ds.bState = p[RECORD_HEADER_SIZE + 3 + 7] >> 6;
+            m_index.push_back(ds);
+        }
+        pos += RECORD_HEADER_SIZE + 3 + size;
+    }
+    if (pos < m_nSize) {
+        XY_LOG_WARN("Garbage or truncated record at "<<pos<<" in "<<m_nSize<<" bytes");
+    }
+    return !m_index.empty();
+}
+
+// @return: the last display set starting at or before @rt, -1 if none
+int CSupFile::FindDisplaySet(REFERENCE_TIME rt)
+{
+    int lo = 0, hi = (int)m_index.size();
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (m_index[mid].rtStart <= rt) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo - 1;
+}
+
+void CSupFile::FeedDisplaySet(int i)
+{
+    __int64 pos = m_index[i].offset;
+    __int64 end = i + 1 < (int)m_index.size() ? m_index[i + 1].offset : m_nSize;
+    while (pos + RECORD_HEADER_SIZE + 3 <= end) {
+        const BYTE* p = m_pData + pos;
+        __int64 pts = ((__int64)p[2] << 24) | (p[3] << 16) | (p[4] << 8) | p[5];
+        int size = 3 + ((p[RECORD_HEADER_SIZE + 1] << 8) | p[RECORD_HEADER_SIZE + 2]);
+        // CHdmvSub only reads the segments, parsed in place
+        m_sub.ParseData(const_cast<BYTE*>(p + RECORD_HEADER_SIZE), size, pts * 1000 / 9);
+        pos += RECORD_HEADER_SIZE + size;
+    }
+}
+
+// ISubPicProvider
+
+STDMETHODIMP_(POSITION) CSupFile::GetStartPosition(REFERENCE_TIME rt, double fps)
+{
+    CAutoLock cAutoLock(&m_csCritSec);
+
+    int i = FindDisplaySet(rt);
+    if (i < 0) {
+        return NULL;
+    }
+
+    // Decoding must start from an acquisition point, and display sets are only complete once the 
+    // next one is parsed. Going back (m_sub drops what is over) or far ahead, start again rather
+    // than parse all the way.
+    int start = i;
+    while (start > 0 && m_index[start].bState == 0) {
+        start--;
+    }
+    if (i < m_nFirstFed || i < FindDisplaySet(m_rtLast) || start > m_nFed) {
+        m_sub.Reset();
+        m_nFirstFed = m_nFed = start;
+    }
+    m_rtLast = rt;
+
+    while (m_nFed <= i + 1 && m_nFed < (int)m_index.size()) {
+        FeedDisplaySet(m_nFed++);
+    }
+
+    return m_sub.GetStartPosition(rt, fps);
+}
+
+STDMETHODIMP_(POSITION) CSupFile::GetNext(POSITION pos)
+{
+    CAutoLock cAutoLock(&m_csCritSec);
+    return m_sub.GetNext(pos);
+}
+
+STDMETHODIMP_(REFERENCE_TIME) CSupFile::GetStart(POSITION pos, double fps)
+{
+    CAutoLock cAutoLock(&m_csCritSec);
+    return m_sub.GetStart(pos);
+}
+
+STDMETHODIMP_(REFERENCE_TIME) CSupFile::GetStop(POSITION pos, double fps)
+{
+    CAutoLock cAutoLock(&m_csCritSec);
+    return m_sub.GetStop(pos);
+}
+
+STDMETHODIMP_(bool) CSupFile::IsAnimated(POSITION pos)
+{
+    return false;
+}
+
+STDMETHODIMP CSupFile::Render(SubPicDesc& spd, REFERENCE_TIME rt, double fps, RECT& bbox)
+{
+    CAutoLock cAutoLock(&m_csCritSec);
+    m_sub.Render(spd, rt, bbox);
+    return S_OK;
+}
+
+STDMETHODIMP CSupFile::GetTextureSize(POSITION pos, SIZE& MaxTextureSize, SIZE& VideoSize, POINT& VideoTopLeft)
+{
+    CAutoLock cAutoLock(&m_csCritSec);
+    return m_sub.GetTextureSize(pos, MaxTextureSize, VideoSize, VideoTopLeft);
+}
+
+STDMETHODIMP_(bool) CSupFile::IsColorTypeSupported(int type)
+{
+    return type == MSP_AYUV_PLANAR ||
+           type == MSP_AYUV ||
+           type == MSP_XY_AUYV ||
+           type == MSP_RGBA;
+}
+
+// IUnknown
+
+STDMETHODIMP CSupFile::NonDelegatingQueryInterface(REFIID riid, void** ppv)
+{
+    CheckPointer(ppv, E_POINTER);
+    *ppv = NULL;
+
+    return
+        QI(IPersist)
+        QI(ISubStream)
+        QI(ISubPicProvider)
+        __super::NonDelegatingQueryInterface(riid, ppv);
+}
+
+// IPersist
+
+STDMETHODIMP CSupFile::GetClassID(CLSID* pClassID)
+{
+    return pClassID ? *pClassID = __uuidof(this), S_OK : E_POINTER;
+}
+
+// ISubStream
+
+STDMETHODIMP_(int) CSupFile::GetStreamCount()
+{
+    return 1;
+}
+
+STDMETHODIMP CSupFile::GetStreamInfo(int iStream, WCHAR** ppName, LCID* pLCID)
+{
+    if (iStream != 0) {
+        return E_INVALIDARG;
+    }
+
+    if (ppName) {
+        *ppName = (WCHAR*)CoTaskMemAlloc((m_name.GetLength() + 1) * sizeof(WCHAR));
+        if (!(*ppName)) {
+            return E_OUTOFMEMORY;
+        }
+
+        wcscpy_s(*ppName, m_name.GetLength() + 1, CStringW(m_name));
+    }
+
+    if (pLCID) {
+        *pLCID = 0;
+    }
+
+    return S_OK;
+}
+
+STDMETHODIMP_(int) CSupFile::GetStream()
+{
+    return 0;
+}
+
+STDMETHODIMP CSupFile::SetStream(int iStream)
+{
+    return iStream == 0 ? S_OK : E_FAIL;
+}
+
+STDMETHODIMP CSupFile::Reload()
+{
+    CString fn = m_fn;
+    return !fn.IsEmpty() && Open(fn) ? S_OK : E_FAIL;
+}
+
+HRESULT CSupFile::SetYuvType(CBaseSub::ColorType colorType, CBaseSub::YuvRangeType yuvRangeType)
+{
+    CAutoLock cAutoLock(&m_csCritSec);
+    return m_sub.SetYuvType(colorType, yuvRangeType);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vector>
+#include "../SubPic/SubPicProviderImpl.h"
+#include "HdmvSub.h"
+
+/****
+ * Blu-ray subtitles (PGS) read from a .sup file, for the cases without a demuxer, e.g. the 
+ * AviSynth and VirtualDub plugins.
+ *
+ * The file is memory mapped and only indexed on Open: the start time, offset and composition 
+ * state of every presentation segment. Display sets are fed to a CHdmvSub as they are needed, 
+ * on a seek starting again from the last acquisition point (or epoch start) before it, so that 
+ * only a few display sets are parsed at a time, whatever the length of the stream.
+ *
+ * Every record of a .sup file is: "PG", PTS (32 bits, 90KHz), DTS (32 bits), then the segment
+ * itself: type (8 bits), size (16 bits) and payload.
+ **/
+class __declspec(uuid("6A1D3E4F-2C58-4B7A-9E03-D5F8B1C6A247"))
+    CSupFile : public CSubPicProviderImpl, public ISubStream
+{
+public:
+    CSupFile(CCritSec* pLock);
+    ~CSupFile(void);
+
+    bool Open(CString fn);
+    void Close();
+
+    DECLARE_IUNKNOWN
+    STDMETHODIMP NonDelegatingQueryInterface(REFIID riid, void** ppv);
+
+    // ISubPicProvider
+    STDMETHODIMP_(POSITION) GetStartPosition(REFERENCE_TIME rt, double fps);
+    STDMETHODIMP_(POSITION) GetNext(POSITION pos);
+    STDMETHODIMP_(REFERENCE_TIME) GetStart(POSITION pos, double fps);
+    STDMETHODIMP_(REFERENCE_TIME) GetStop(POSITION pos, double fps);
+    STDMETHODIMP_(bool) IsAnimated(POSITION pos);
+    STDMETHODIMP Render(SubPicDesc& spd, REFERENCE_TIME rt, double fps, RECT& bbox);
+    STDMETHODIMP GetTextureSize(POSITION pos, SIZE& MaxTextureSize, SIZE& VirtualSize, POINT& VirtualTopLeft);
+
+    // ISubPicProviderEx
+    STDMETHODIMP_(bool) IsColorTypeSupported(int type);
+
+    // IPersist
+    STDMETHODIMP GetClassID(CLSID* pClassID);
+
+    // ISubStream
+    STDMETHODIMP_(int) GetStreamCount();
+    STDMETHODIMP GetStreamInfo(int i, WCHAR** ppName, LCID* pLCID);
+    STDMETHODIMP_(int) GetStream();
+    STDMETHODIMP SetStream(int iStream);
+    STDMETHODIMP Reload();
+
+    HRESULT SetYuvType(CBaseSub::ColorType colorType, CBaseSub::YuvRangeType yuvRangeType);
+private:
+    static const int RECORD_HEADER_SIZE = 10;   // "PG", PTS, DTS
+
+    struct DisplaySet {
+        REFERENCE_TIME rtStart;
+        __int64        offset;
+        BYTE           bState;      // composition state: 0 normal, 1 acquisition point, 2 epoch start
+    };
+
+    CString                 m_fn;
+    CString                 m_name;
+
+    HANDLE                  m_hFile;
+    HANDLE                  m_hMapping;
+    const BYTE*             m_pData;
+    __int64                 m_nSize;
+
+    std::vector<DisplaySet> m_index;
+    int                     m_nFirstFed;    // display sets [m_nFirstFed, m_nFed) are in m_sub
+    int                     m_nFed;
+    REFERENCE_TIME          m_rtLast;
+
+    CHdmvSub                m_sub;
+    CCritSec                m_csCritSec;
+
+    bool                    BuildIndex();
+    int                     FindDisplaySet(REFERENCE_TIME rt);
+    void                    FeedDisplaySet(int i);
+};
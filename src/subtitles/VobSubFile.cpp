@@ -207,11 +207,24 @@ CString FindLangFromId(WORD id)
 CVobSubFile::CVobSubFile(CCritSec* pLock)
 	: CSubPicProviderImpl(pLock)
 	, m_sub(1024*1024)
+	, m_hSubFile(INVALID_HANDLE_VALUE)
+	, m_hSubMapping(NULL)
+	, m_pSubView(NULL)
+	, m_nSubViewSize(0)
 {
+	for(int i = 0; i < 32; i++)
+		m_langs[i].nIndexedLen = -1;
 }
 
 CVobSubFile::~CVobSubFile()
 {
+	if(m_pFrameDecoder)
+	{
+		m_pFrameDecoder->CallWorker(CFrameDecoder::CMD_EXIT);
+		m_pFrameDecoder->Close();
+	}
+
+	UnmapSub();
 }
 
 //
@@ -224,7 +237,9 @@ bool CVobSubFile::Copy(CVobSubFile& vsf)
 	m_title = vsf.m_title;
 	m_iLang = vsf.m_iLang;
 
-	m_sub.SetLength(vsf.m_sub.GetLength());
+	CAutoLock cAutoLock(&vsf.m_csFrames);
+
+	m_sub.SetLength(0);
 	m_sub.SeekToBegin();
 
 	for(int i = 0; i < 32; i++)
@@ -236,39 +251,25 @@ bool CVobSubFile::Copy(CVobSubFile& vsf)
 		dst.name = src.name;
 		dst.alt = src.alt;
 
-		for(size_t j = 0; j < src.subpos.GetCount(); j++)
-		{
-			SubPos& sp = src.subpos[j];
-			if(!sp.fValid) continue;
-
-			if(sp.filepos != vsf.m_sub.Seek(sp.filepos, CFile::begin))
-				continue;
+		if(src.subpos.IsEmpty())
+			continue;
 
-			sp.filepos = m_sub.GetPosition();
+		if(vsf.IsIndexStale(i))
+			vsf.IndexPackets(i);
 
-			BYTE buff[2048];
-			vsf.m_sub.Read(buff, 2048);
-			m_sub.Write(buff, 2048);
+		__int64 len = 0;
+		const BYTE* data = vsf.GetSubData(len);
 
-			WORD packetsize = (buff[buff[0x16]+0x18]<<8) | buff[buff[0x16]+0x19];
+		for(size_t j = 0; j < src.subpos.GetCount(); j++)
+		{
+			SubPos sp = src.subpos[j];
+			SubPacket& pk = src.packets[j];
+			if(!sp.fValid || pk.nFrags == 0) continue;
 
-			for(int k = 0, size, sizeleft = packetsize - 4; 
-				k < packetsize - 4; 
-				k += size, sizeleft -= size)
-			{
-				int hsize = buff[0x16]+0x18 + ((buff[0x15]&0x80) ? 4 : 0);
-				size = min(sizeleft, 2048 - hsize);
-	
-				if(size != sizeleft) 
-				{
-					while(vsf.m_sub.Read(buff, 2048))
-					{
-						if(!(buff[0x15]&0x80) && buff[buff[0x16]+0x17] == (i|0x20)) break;
-					}
+			sp.filepos = m_sub.GetPosition();
 
-					m_sub.Write(buff, 2048);
-				}
-			}
+			for(size_t k = 0; k < pk.nFrags; k++)
+				m_sub.Write(data + src.frags[pk.iFrag + k].filepos, 0x800);
 
 			dst.subpos.Add(sp);
 		}
@@ -317,6 +318,8 @@ bool CVobSubFile::Open(CString fn)
 		{
 			CAtlArray<SubPos>& sp = m_langs[i].subpos;
 
+			IndexPackets(i);
+
 			for(size_t j = 0; j < sp.GetCount(); j++)
 			{
 				sp[j].stop = sp[j].start;
@@ -371,10 +374,11 @@ bool CVobSubFile::Save(CString fn, SubFormat sf)
 
 void CVobSubFile::Close()
 {
+	FlushFrames();
 	InitSettings();
 	m_title.Empty();
 	m_sub.SetLength(0);
-	m_img.Invalidate();
+	UnmapSub();
 	m_iLang = -1;
 	for(int i = 0; i < 32; i++)
 	{
@@ -382,6 +386,9 @@ void CVobSubFile::Close()
 		m_langs[i].name.Empty();
 		m_langs[i].alt.Empty();
 		m_langs[i].subpos.RemoveAll();
+		m_langs[i].packets.RemoveAll();
+		m_langs[i].frags.RemoveAll();
+		m_langs[i].nIndexedLen = -1;
 	}
 }
 
@@ -663,6 +670,23 @@ bool CVobSubFile::ReadIdx(CString fn, int& ver)
 
 bool CVobSubFile::ReadSub(CString fn)
 {
+	m_hSubFile = CreateFile(fn, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+	if(m_hSubFile != INVALID_HANDLE_VALUE)
+	{
+		LARGE_INTEGER size;
+		if(GetFileSizeEx(m_hSubFile, &size) && size.QuadPart > 0 && (SIZE_T)size.QuadPart == size.QuadPart
+		&& (m_hSubMapping = CreateFileMapping(m_hSubFile, NULL, PAGE_READONLY, 0, 0, NULL))
+		&& (m_pSubView = (const BYTE*)MapViewOfFile(m_hSubMapping, FILE_MAP_READ, 0, 0, 0)))
+		{
+			m_nSubViewSize = size.QuadPart;
+			return(true);
+		}
+
+		UnmapSub();
+	}
+
+	// could not map it, read it into memory
+
 	CFile f;
 	if(!f.Open(fn, CFile::modeRead|CFile::typeBinary|CFile::shareDenyWrite))
 		return(false);
@@ -1031,26 +1055,63 @@ bool CVobSubFile::WriteSub(CString fn)
 
 //
 
-BYTE* CVobSubFile::GetPacket(int idx, int& packetsize, int& datasize, int iLang)
+const BYTE* CVobSubFile::GetSubData(__int64& len)
 {
-	BYTE* ret = NULL;
+	if(m_pSubView)
+	{
+		len = m_nSubViewSize;
+		return(m_pSubView);
+	}
 
-	if(iLang < 0 || iLang >= 32) iLang = m_iLang;
-	CAtlArray<SubPos>& sp = m_langs[iLang].subpos;
+	void* pStart = NULL;
+	void* pMax = NULL;
+	ULONGLONG pos = m_sub.GetPosition();
+	m_sub.SeekToBegin();
+	len = m_sub.GetBufferPtr(CFile::bufferRead, (UINT)m_sub.GetLength(), &pStart, &pMax);
+	m_sub.Seek(pos, CFile::begin);
 
-	do
-	{
-		if(idx < 0 || idx >= sp.GetCount())
-			break;
+	return((const BYTE*)pStart);
+}
 
-		if(m_sub.Seek(sp[idx].filepos, CFile::begin) != sp[idx].filepos) 
-			break;
+void CVobSubFile::UnmapSub()
+{
+	if(m_pSubView) UnmapViewOfFile(m_pSubView);
+	m_pSubView = NULL;
+	m_nSubViewSize = 0;
 
-		BYTE buff[0x800];
-		if(sizeof(buff) != m_sub.Read(buff, sizeof(buff)))
-			break;
+	if(m_hSubMapping) CloseHandle(m_hSubMapping);
+	m_hSubMapping = NULL;
 
-		BYTE offset = buff[0x16];
+	if(m_hSubFile != INVALID_HANDLE_VALUE) CloseHandle(m_hSubFile);
+	m_hSubFile = INVALID_HANDLE_VALUE;
+}
+
+// Walks the packs of every subpicture of iLang once, and keeps where their payload is, 
+// GetPacket only has to gather it then.
+
+void CVobSubFile::IndexPackets(int iLang)
+{
+	SubLang& sl = m_langs[iLang];
+
+	sl.packets.SetCount(sl.subpos.GetCount());
+	sl.frags.RemoveAll();
+
+	__int64 len = 0;
+	const BYTE* data = GetSubData(len);
+	sl.nIndexedLen = len;
+
+	for(size_t j = 0; j < sl.subpos.GetCount(); j++)
+	{
+		SubPacket& pk = sl.packets[j];
+		pk.iFrag = sl.frags.GetCount();
+		pk.nFrags = 0;
+		pk.packetsize = pk.datasize = 0;
+
+		__int64 pos = sl.subpos[j].filepos;
+		if(!data || pos < 0 || pos + 0x800 > len)
+			continue;
+
+		const BYTE* buff = data + pos;
 
 		// let's check a few things to make sure...
 		if(*(DWORD*)&buff[0x00] != 0xba010000
@@ -1059,37 +1120,91 @@ BYTE* CVobSubFile::GetPacket(int idx, int& packetsize, int& datasize, int iLang)
 		|| (buff[0x17] & 0xf0) != 0x20
 		|| (buff[buff[0x16] + 0x17] & 0xe0) != 0x20
 		|| (buff[buff[0x16] + 0x17] & 0x1f) != iLang)
-			break;
-
-        packetsize = (buff[buff[0x16] + 0x18] << 8) + buff[buff[0x16] + 0x19];
-		datasize = (buff[buff[0x16] + 0x1a] << 8) + buff[buff[0x16] + 0x1b];
+			continue;
 
-		ret = new BYTE[packetsize];
-		if(!ret) break;
+		int packetsize = (buff[buff[0x16] + 0x18] << 8) + buff[buff[0x16] + 0x19];
+		int datasize = (buff[buff[0x16] + 0x1a] << 8) + buff[buff[0x16] + 0x1b];
 
-		int i = 0, sizeleft = packetsize;
-        for(int size; 
-			i < packetsize; 
-			i += size, sizeleft -= size)
+		int sizeleft = packetsize;
+		while(sizeleft > 0)
 		{
-			int hsize = 0x18 + buff[0x16];
-			size = min(sizeleft, 0x800 - hsize);
-			memcpy(&ret[i], &buff[hsize], size);
+			SubFrag f;
+			f.filepos = pos;
+			f.offset = 0x18 + buff[0x16];
+			f.size = min(sizeleft, 0x800 - f.offset);
+			sl.frags.Add(f);
 
-            if(size != sizeleft) 
+			if((sizeleft -= f.size) == 0)
+				break;
+
+			// the rest is in the next pack of this stream, the packs of other streams and anything 
+			// that is not a pack in between are skipped
+			while((pos += 0x800) + 0x800 <= len)
 			{
-				while(m_sub.Read(buff, sizeof(buff)))
-				{
-					if(/*!(buff[0x15] & 0x80) &&*/ buff[buff[0x16] + 0x17] == (iLang|0x20)) 
-						break;
-				}
+				buff = data + pos;
+				if(*(DWORD*)&buff[0x00] == 0xba010000 && buff[buff[0x16] + 0x17] == (iLang|0x20))
+					break;
 			}
+
+			if(pos + 0x800 > len)
+				break;
 		}
 
-		if(i != packetsize || sizeleft > 0)
-			delete [] ret, ret = NULL;
+		if(sizeleft > 0 || packetsize <= 0)
+		{
+			sl.frags.SetCount(pk.iFrag);
+			continue;
+		}
+
+		pk.nFrags = sl.frags.GetCount() - pk.iFrag;
+		pk.packetsize = packetsize;
+		pk.datasize = datasize;
 	}
-	while(false);
+}
+
+bool CVobSubFile::IsIndexStale(int iLang)
+{
+	SubLang& sl = m_langs[iLang];
+
+	__int64 len = 0;
+	GetSubData(len);
+
+	return(sl.packets.GetCount() != sl.subpos.GetCount() || sl.nIndexedLen != len);
+}
+
+BYTE* CVobSubFile::GetPacket(int idx, int& packetsize, int& datasize, int iLang)
+{
+	if(iLang < 0 || iLang >= 32) iLang = m_iLang;
+	SubLang& sl = m_langs[iLang];
+
+	if(idx < 0 || idx >= sl.subpos.GetCount())
+		return(NULL);
+
+	CAutoLock cAutoLock(&m_csFrames);
+
+	// subpos or m_sub changed since Open, e.g. CVobSubFileRipper and Copy filling m_sub
+	if(IsIndexStale(iLang))
+		IndexPackets(iLang);
+
+	SubPacket& pk = sl.packets[idx];
+	if(pk.nFrags == 0)
+		return(NULL);
+
+	__int64 len = 0;
+	const BYTE* data = GetSubData(len);
+
+	BYTE* ret = new BYTE[pk.packetsize];
+	if(!ret) return(NULL);
+
+	for(size_t k = 0, i = 0; k < pk.nFrags; k++)
+	{
+		SubFrag& f = sl.frags[pk.iFrag + k];
+		memcpy(&ret[i], &data[f.filepos + f.offset], f.size);
+		i += f.size;
+	}
+
+	packetsize = pk.packetsize;
+	datasize = pk.datasize;
 
 	return(ret);
 }
@@ -1104,30 +1219,261 @@ bool CVobSubFile::GetFrame(int idx, int iLang)
 
 	if(m_img.iLang != iLang || m_img.iIdx != idx) 
 	{
-		int packetsize = 0, datasize = 0;
-		CAutoVectorPtr<BYTE> buff;
-		buff.Attach(GetPacket(idx, packetsize, datasize, iLang));
-		if(!buff || packetsize <= 0 || datasize <= 0) return(false);
+		CAutoPtr<CVobSubImage> img;
+
+		{
+			CAutoLock cAutoLock(&m_csFrames);
+			if(POSITION pos = FindFrame(idx, iLang))
+			{
+				img = m_frames.GetAt(pos);
+				m_frames.RemoveAt(pos);
+			}
+		}
 
-		m_img.start = sp[idx].start;
-		m_img.delay = idx < (sp.GetCount()-1)
-			? sp[idx+1].start - sp[idx].start
-			: 3000;
+		if(!img)
+		{
+			img.Attach(new CVobSubImage());
+			if(!DecodeFrame(*img, idx, iLang)) return(false);
+		}
 
-		bool ret = m_img.Decode(buff, packetsize, datasize, m_fCustomPal, m_tridx, m_orgpal, m_cuspal, true);
-		
-		if(idx < (sp.GetCount()-1))
-			m_img.delay = min(m_img.delay, sp[idx+1].start - m_img.start);
+		bool fDecodeAhead = false;
 
-		if(!ret) return(false);
-		
-		m_img.iIdx = idx;
-		m_img.iLang = iLang;
+		{
+			CAutoLock cAutoLock(&m_csFrames);
+			// keep the frame we are leaving, it is likely to be asked for again
+			m_img.Swap(*img);
+			AddFrame(img);
+			for(int i = idx+1; i <= idx+DECODE_AHEAD && i < sp.GetCount() && !fDecodeAhead; i++)
+				fDecodeAhead = !FindFrame(i, iLang);
+		}
+
+		if(fDecodeAhead)
+		{
+			if(!m_pFrameDecoder)
+			{
+				m_pFrameDecoder.Attach(new CFrameDecoder(this));
+				m_pFrameDecoder->Create();
+			}
+
+			m_pFrameDecoder->DecodeAfter(idx, iLang);
+		}
 	}
 
 	return(m_fOnlyShowForcedSubs ? m_img.fForced : true);
 }
 
+bool CVobSubFile::DecodeFrame(CVobSubImage& img, int idx, int iLang)
+{
+	CAtlArray<SubPos>& sp = m_langs[iLang].subpos;
+
+	int packetsize = 0, datasize = 0;
+	CAutoVectorPtr<BYTE> buff;
+	buff.Attach(GetPacket(idx, packetsize, datasize, iLang));
+	if(!buff || packetsize <= 0 || datasize <= 0) return(false);
+
+	img.start = sp[idx].start;
+	img.delay = idx < (sp.GetCount()-1)
+		? sp[idx+1].start - sp[idx].start
+		: 3000;
+
+	bool ret = img.Decode(buff, packetsize, datasize, m_fCustomPal, m_tridx, m_orgpal, m_cuspal, true);
+	
+	if(idx < (sp.GetCount()-1))
+		img.delay = min(img.delay, sp[idx+1].start - img.start);
+
+	if(!ret) return(false);
+	
+	img.iIdx = idx;
+	img.iLang = iLang;
+
+	return(true);
+}
+
+// called on the decoder thread
+bool CVobSubFile::DecodeFrameAhead(int idx, int iLang)
+{
+	if(idx >= m_langs[iLang].subpos.GetCount())
+		return(false);
+
+	{
+		CAutoLock cAutoLock(&m_csFrames);
+		if(FindFrame(idx, iLang) || (m_img.iLang == iLang && m_img.iIdx == idx))
+			return(true);
+	}
+
+	CAutoPtr<CVobSubImage> img(new CVobSubImage());
+	if(!DecodeFrame(*img, idx, iLang))
+		return(false);
+
+	CAutoLock cAutoLock(&m_csFrames);
+	AddFrame(img);
+
+	return(true);
+}
+
+POSITION CVobSubFile::FindFrame(int idx, int iLang)
+{
+	for(POSITION pos = m_frames.GetHeadPosition(); pos; m_frames.GetNext(pos))
+	{
+		CVobSubImage* img = m_frames.GetAt(pos);
+		if(img->iIdx == idx && img->iLang == iLang)
+			return(pos);
+	}
+
+	return(NULL);
+}
+
+void CVobSubFile::AddFrame(CAutoPtr<CVobSubImage>& img)
+{
+	if(img->iIdx < 0)
+		return;
+
+	if(POSITION pos = FindFrame(img->iIdx, img->iLang))
+		m_frames.RemoveAt(pos);
+
+	m_frames.AddHead(img);
+
+	while(m_frames.GetCount() > FRAME_CACHE_SIZE)
+		m_frames.RemoveTailNoReturn();
+}
+
+void CVobSubFile::FlushFrames()
+{
+	if(m_pFrameDecoder)
+		m_pFrameDecoder->CallWorker(CFrameDecoder::CMD_STOP);
+
+	CAutoLock cAutoLock(&m_csFrames);
+	m_frames.RemoveAll();
+	m_img.Invalidate();
+}
+
+void CVobSubFile::SetCustomPal(RGBQUAD* cuspal, int tridx)
+{
+	FlushFrames();
+	__super::SetCustomPal(cuspal, tridx);
+}
+
+DWORD CVobSubFile::CFrameDecoder::ThreadProc()
+{
+	SetThreadPriority(m_hThread, THREAD_PRIORITY_BELOW_NORMAL);
+
+	while(1)
+	{
+		DWORD cmd = GetRequest();
+		int idx = m_idx, iLang = m_iLang;
+		Reply(S_OK);
+
+		switch(cmd)
+		{
+		case CMD_EXIT:
+			return 0;
+
+		case CMD_DECODE:
+			// a new request (another seek, a flush) makes us give up on the rest
+			for(int i = idx+1; i <= idx+DECODE_AHEAD && !CheckRequest(NULL); i++)
+			{
+				if(!m_pFile->DecodeFrameAhead(i, iLang))
+					break;
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	return 1;
+}
+
+DWORD CVobSubFile::CPolygonizer::ThreadProc()
+{
+	CVobSubImage img;
+
+	for(LONG idx; (idx = InterlockedIncrement(&m_next) - 1) < (LONG)m_frames.GetCount(); InterlockedIncrement(&m_done))
+	{
+		if(!m_pFile->DecodeFrame(img, idx, m_iLang)) continue;
+		if(m_pFile->m_fOnlyShowForcedSubs && !img.fForced) continue;
+
+		PolygonizedFrame& f = m_frames[idx];
+		f.start = img.start;
+		f.stop = img.start + img.delay;
+		if(!img.Polygonize(f.assstr, m_fSmooth, m_scale)) f.assstr.Empty();
+	}
+
+	return 0;
+}
+
+bool CVobSubFile::Polygonize(CSimpleTextSubtitle& sts, int iLang, bool fSmooth, int scale, int nThreads, IPolygonizeProgress* pProgress)
+{
+	if(iLang < 0 || iLang >= 32) iLang = m_iLang;
+	if(iLang < 0 || iLang >= 32) return(false);
+
+	int nTotal = m_langs[iLang].subpos.GetCount();
+
+	if(nThreads <= 0)
+	{
+		SYSTEM_INFO si;
+		GetSystemInfo(&si);
+		nThreads = si.dwNumberOfProcessors;
+	}
+	nThreads = max(1, min(min(nThreads, nTotal), MAXIMUM_WAIT_OBJECTS));
+
+	// every subpicture has its own slot, the threads only decide the order they are filled in
+	CAtlArray<PolygonizedFrame> frames;
+	if(!frames.SetCount(nTotal)) return(false);
+
+	volatile LONG next = 0, done = 0;
+
+	CAutoPtrArray<CPolygonizer> workers;
+	CAtlArray<HANDLE> handles;
+
+	for(int i = 0; i < nThreads; i++)
+	{
+		CAutoPtr<CPolygonizer> p(new CPolygonizer(this, iLang, fSmooth, scale, frames, next, done));
+		if(!p->Create()) break;
+		handles.Add(p->GetThreadHandle());
+		workers.Add(p);
+	}
+
+	if(workers.IsEmpty()) return(false);
+
+	bool fCanceled = false;
+
+	while(WaitForMultipleObjects(handles.GetCount(), handles.GetData(), TRUE, 100) == WAIT_TIMEOUT)
+	{
+		if(pProgress && !fCanceled && !pProgress->OnProgress(done, nTotal))
+		{
+			fCanceled = true;
+			InterlockedExchange(&next, nTotal);
+		}
+	}
+
+	workers.RemoveAll();
+
+	if(fCanceled) return(false);
+
+	if(pProgress) pProgress->OnProgress(nTotal, nTotal);
+
+	sts.Empty();
+	sts.m_mode = TIME;
+	sts.m_dstScreenSize = m_size;
+
+	// the drawings are the whole subpictures, outlines included
+	STSStyle* style = sts.CreateDefaultStyle(DEFAULT_CHARSET);
+	style->outlineWidthX = style->outlineWidthY = 0;
+	style->shadowDepthX = style->shadowDepthY = 0;
+
+	for(int i = 0; i < nTotal; i++)
+	{
+		if(!frames[i].assstr.IsEmpty())
+			sts.AddSTSEntryOnly(frames[i].assstr, true, (int)frames[i].start, (int)frames[i].stop);
+	}
+
+	sts.Sort();
+
+	return(true);
+}
+
 bool CVobSubFile::GetFrameByTimeStamp(__int64 time)
 {
 	return(GetFrame(GetFrameIdxByTimeStamp(time)));
@@ -1316,92 +1662,43 @@ STDMETHODIMP CVobSubFile::Reload()
 
 // StretchBlt
 
-static void PixelAtBiLinear(RGBQUAD& c, int x, int y, CVobSubImage& src)
-{
-	int w = src.rect.Width(),
-		h = src.rect.Height();
-
-	int x1 = (x >> 16), y1 = (y >> 16) * w,
-		x2 = min(x1 + 1, w-1), y2 = min(y1 + w, (h-1)*w);
-
-	RGBQUAD* ptr = src.lpPixels;
-
-	RGBQUAD c11 = ptr[y1 + x1],	c12 = ptr[y1 + x2],
-			c21 = ptr[y2 + x1],	c22 = ptr[y2 + x2];
-
-	__int64 u2 = x & 0xffff,
-			v2 = y & 0xffff,
-			u1 = 0x10000 - u2,
-			v1 = 0x10000 - v2;
+bool xy_resample_argb(DWORD *dst, int dst_width, int dst_height, int dst_stride,
+	int left, int top, int scaled_width, int scaled_height,
+	const DWORD *src, int width, int height, int stride, bool bicubic);
 
-	int v1u1 = int(v1*u1 >> 16) * c11.rgbReserved, 
-		v1u2 = int(v1*u2 >> 16) * c12.rgbReserved,
-		v2u1 = int(v2*u1 >> 16) * c21.rgbReserved, 
-		v2u2 = int(v2*u2 >> 16) * c22.rgbReserved;
-
-	c.rgbRed = (c11.rgbRed * v1u1 + c12.rgbRed * v1u2
-			  + c21.rgbRed * v2u1 + c22.rgbRed * v2u2) >> 24;
-	c.rgbGreen = (c11.rgbGreen * v1u1 + c12.rgbGreen * v1u2
-				+ c21.rgbGreen * v2u1 + c22.rgbGreen * v2u2) >> 24;
-	c.rgbBlue = (c11.rgbBlue * v1u1 + c12.rgbBlue * v1u2
-				+ c21.rgbBlue * v2u1 + c22.rgbBlue * v2u2) >> 24;
-	c.rgbReserved = (v1u1 + v1u2 
-					+ v2u1 + v2u2) >> 16;
-}
-
-static void StretchBlt(SubPicDesc& spd, CRect dstrect, CVobSubImage& src)
+// Scales m_img into dstrect as premultiplied RGB with an inverted alpha. The output is kept,
+// rendering the same image into the same rect again only copies it.
+void CVobSubSettings::StretchBlt(SubPicDesc& spd, CRect dstrect)
 {
-	if(dstrect.IsRectEmpty()) return;
-
-	if((dstrect & CRect(0, 0, spd.w, spd.h)).IsRectEmpty()) return;
+	CRect r = dstrect & CRect(0, 0, spd.w, spd.h);
+	if(dstrect.IsRectEmpty() || r.IsRectEmpty() || !m_img.lpPixels || m_img.rect.IsRectEmpty()) return;
 
-	int sw = src.rect.Width(),
-		sh = src.rect.Height(),
-		dw = dstrect.Width(),
-		dh = dstrect.Height();
+	bool fBicubic = m_fSmooth == 1;
 
-	int srcx = 0, 
-		srcy = 0,
-		srcdx = (sw << 16) / dw >> 1, 
-		srcdy = (sh << 16) / dh >> 1;
+	if(m_scaledSerial != m_img.nSerial || m_scaledDst != dstrect || m_scaledClip != r || m_fScaledBicubic != fBicubic)
+	{
+		m_scaledBits.resize(r.Width()*r.Height());
 
-	if(dstrect.left < 0) {srcx = -dstrect.left * (srcdx<<1); dstrect.left = 0;}
-	if(dstrect.top < 0) {srcy = -dstrect.top * (srcdy<<1); dstrect.top = 0;}
-	if(dstrect.right > spd.w) {dstrect.right = spd.w;}
-	if(dstrect.bottom > spd.h) {dstrect.bottom = spd.h;}
+		if(!xy_resample_argb(&m_scaledBits[0], r.Width(), r.Height(), r.Width()*sizeof(DWORD),
+			r.left - dstrect.left, r.top - dstrect.top, dstrect.Width(), dstrect.Height(),
+			(const DWORD*)m_img.lpPixels, m_img.rect.Width(), m_img.rect.Height(), m_img.rect.Width()*sizeof(DWORD),
+			fBicubic))
+		{
+			m_scaledSerial = 0; // m_scaledBits no longer holds any output
+			return;
+		}
 
-	if((dstrect & CRect(0, 0, spd.w, spd.h)).IsRectEmpty()) return;
+		for(size_t i = 0; i < m_scaledBits.size(); i++) m_scaledBits[i] ^= 0xff000000;
 
-	dw = dstrect.Width();
-	dh = dstrect.Height();
+		m_scaledSerial = m_img.nSerial;
+		m_scaledDst = dstrect;
+		m_scaledClip = r;
+		m_fScaledBicubic = fBicubic;
+	}
 
-	for(int y = dstrect.top; y < dstrect.bottom; y++, srcy += (srcdy<<1))
+	for(int y = r.top; y < r.bottom; y++)
 	{
-		RGBQUAD* ptr = (RGBQUAD*)&((BYTE*)spd.bits)[y*spd.pitch] + dstrect.left;
-		RGBQUAD* endptr = ptr + dw;
-		
-		for(int sx = srcx; ptr < endptr; sx += (srcdx<<1), ptr++)
-		{
-//			PixelAtBiLinear(*ptr,	sx,			srcy,		src);
-////
-			RGBQUAD cc[4];
-
-			PixelAtBiLinear(cc[0],	sx,			srcy,		src);
-			PixelAtBiLinear(cc[1],	sx+srcdx,	srcy,		src);
-			PixelAtBiLinear(cc[2],	sx,			srcy+srcdy,	src);
-			PixelAtBiLinear(cc[3],	sx+srcdx,	srcy+srcdy,	src);
-			
-			ptr->rgbRed = (cc[0].rgbRed + cc[1].rgbRed + cc[2].rgbRed + cc[3].rgbRed) >> 2;
-			ptr->rgbGreen = (cc[0].rgbGreen + cc[1].rgbGreen + cc[2].rgbGreen + cc[3].rgbGreen) >> 2;
-			ptr->rgbBlue = (cc[0].rgbBlue + cc[1].rgbBlue + cc[2].rgbBlue + cc[3].rgbBlue) >> 2;
-			ptr->rgbReserved = (cc[0].rgbReserved + cc[1].rgbReserved + cc[2].rgbReserved + cc[3].rgbReserved) >> 2;
-////
-			ptr->rgbRed = ptr->rgbRed * ptr->rgbReserved >> 8;
-			ptr->rgbGreen = ptr->rgbGreen * ptr->rgbReserved >> 8;
-			ptr->rgbBlue = ptr->rgbBlue * ptr->rgbReserved >> 8;
-			ptr->rgbReserved = ~ptr->rgbReserved;
-
-		}
+		memcpy((DWORD*)&((BYTE*)spd.bits)[y*spd.pitch] + r.left, &m_scaledBits[(y - r.top)*r.Width()], r.Width()*sizeof(DWORD));
 	}
 }
 
@@ -1424,6 +1721,10 @@ void CVobSubSettings::InitSettings()
 	m_tridx = 0;
 	ZeroMemory(m_orgpal, sizeof(m_orgpal));
 	ZeroMemory(m_cuspal, sizeof(m_cuspal));
+	m_scaledSerial = 0;
+	m_scaledDst.SetRectEmpty();
+	m_scaledClip.SetRectEmpty();
+	m_fScaledBicubic = false;
 }
 
 bool CVobSubSettings::GetCustomPal(RGBQUAD* cuspal, int& tridx)
@@ -1514,7 +1815,7 @@ HRESULT CVobSubSettings::Render(SubPicDesc& spd, RECT& bbox)
 {
 	CRect r;
 	GetDestrect(r, spd.w, spd.h);
-	StretchBlt(spd, r, m_img);
+	StretchBlt(spd, r);
 /*
 CRenderedTextSubtitle rts(NULL);
 rts.CreateDefaultStyle(DEFAULT_CHARSET);
@@ -22,6 +22,7 @@
 #pragma once
 
 #include <atlcoll.h>
+#include <vector>
 #include "VobSubImage.h"
 #include "..\SubPic\ISubPic.h"
 
@@ -29,8 +30,18 @@
 
 extern CString FindLangFromId(WORD id);
 
+class CSimpleTextSubtitle;
+
 class CVobSubSettings
 {
+	// the last output of StretchBlt: image m_scaledSerial scaled to m_scaledDst, clipped to m_scaledClip
+	LONG m_scaledSerial;
+	CRect m_scaledDst, m_scaledClip;
+	bool m_fScaledBicubic;
+	std::vector<DWORD> m_scaledBits;
+
+	void StretchBlt(SubPicDesc& spd, CRect dstrect);
+
 protected:
 	HRESULT Render(SubPicDesc& spd, RECT& bbox);
 
@@ -56,7 +67,7 @@ public:
 	void InitSettings();
 
 	bool GetCustomPal(RGBQUAD* cuspal, int& tridx);
-    void SetCustomPal(RGBQUAD* cuspal, int tridx);
+    virtual void SetCustomPal(RGBQUAD* cuspal, int tridx);
 
 	void GetDestrect(CRect& r); // destrect of m_img, considering the current alignment mode
 	void GetDestrect(CRect& r, int w, int h); // this will scale it to the frame size of (w, h)
@@ -76,8 +87,69 @@ protected:
 
 	CMemFile m_sub;
 
+	// The .sub is mapped read only on Open, m_sub only holds it when it is built in memory
+	// (rar, ripper, Copy).
+	HANDLE m_hSubFile, m_hSubMapping;
+	const BYTE* m_pSubView;
+	__int64 m_nSubViewSize;
+
+	const BYTE* GetSubData(__int64& len);
+	void UnmapSub();
+	void IndexPackets(int iLang);
+	bool IsIndexStale(int iLang); // subpos or the sub data changed since IndexPackets
+
 	BYTE* GetPacket(int idx, int& packetsize, int& datasize, int iLang = -1);
 	bool GetFrame(int idx, int iLang = -1);
+
+	// Decoded frames besides m_img, most recently used first. Seeking and GetNext/GetStart 
+	// going back and forth between neighbours no longer decode the same packets again and again.
+	// The decoder thread fills it ahead of the frame shown, m_csFrames guards it and m_sub.
+	enum {FRAME_CACHE_SIZE = 16, DECODE_AHEAD = 4};
+
+	CAutoPtrList<CVobSubImage> m_frames;
+	CCritSec m_csFrames;
+
+	class CFrameDecoder : public CAMThread
+	{
+		CVobSubFile* m_pFile;
+		int m_idx, m_iLang;
+	protected:
+		DWORD ThreadProc();
+	public:
+		enum {CMD_EXIT, CMD_STOP, CMD_DECODE};
+		CFrameDecoder(CVobSubFile* pFile) : m_pFile(pFile), m_idx(-1), m_iLang(-1) {}
+		void DecodeAfter(int idx, int iLang) {CAutoLock cAutoLock(&m_AccessLock); m_idx = idx; m_iLang = iLang; CallWorker(CMD_DECODE);}
+	};
+	CAutoPtr<CFrameDecoder> m_pFrameDecoder;
+
+	typedef struct
+	{
+		CStringW assstr;
+		__int64 start, stop;
+	} PolygonizedFrame;
+
+	// Takes the next subpicture of a Polygonize batch until there are none left
+	class CPolygonizer : public CAMThread
+	{
+		CVobSubFile* m_pFile;
+		int m_iLang, m_scale;
+		bool m_fSmooth;
+		CAtlArray<PolygonizedFrame>& m_frames;
+		volatile LONG& m_next;
+		volatile LONG& m_done;
+	protected:
+		DWORD ThreadProc();
+	public:
+		CPolygonizer(CVobSubFile* pFile, int iLang, bool fSmooth, int scale, CAtlArray<PolygonizedFrame>& frames, volatile LONG& next, volatile LONG& done)
+			: m_pFile(pFile), m_iLang(iLang), m_scale(scale), m_fSmooth(fSmooth), m_frames(frames), m_next(next), m_done(done) {}
+		HANDLE GetThreadHandle() {return m_hThread;}
+	};
+
+	bool DecodeFrame(CVobSubImage& img, int idx, int iLang);
+	bool DecodeFrameAhead(int idx, int iLang);
+	POSITION FindFrame(int idx, int iLang);
+	void AddFrame(CAutoPtr<CVobSubImage>& img);
+	void FlushFrames();
 	bool GetFrameByTimeStamp(__int64 time);
 	int GetFrameIdxByTimeStamp(__int64 time);
 
@@ -97,11 +169,26 @@ public:
 		bool fValid;
 	} SubPos;
 
+	typedef struct
+	{
+		__int64 filepos; // of the 0x800 bytes pack
+		int offset, size; // of the payload in the pack
+	} SubFrag;
+
+	typedef struct
+	{
+		size_t iFrag, nFrags; // in SubLang::frags, no fragments if the packet is broken
+		int packetsize, datasize;
+	} SubPacket;
+
 	typedef struct
 	{
 		int id;
 		CString name, alt;
 		CAtlArray<SubPos> subpos;
+		CAtlArray<SubPacket> packets; // one per subpos, see IndexPackets
+		CAtlArray<SubFrag> frags;
+		__int64 nIndexedLen; // of the sub data packets was built from, -1 if never
 	} SubLang;
 
 	int m_iLang;
@@ -119,6 +206,18 @@ public:
 	bool Save(CString fn, SubFormat sf = VobSub);
 	void Close();
 
+	void SetCustomPal(RGBQUAD* cuspal, int tridx);
+
+	class IPolygonizeProgress
+	{
+	public:
+		virtual bool OnProgress(int nDone, int nTotal) = 0; // called on the thread of Polygonize, return false to cancel
+	};
+
+	// Converts every subpicture of iLang into an ASS drawing of sts, on nThreads threads (0: one per cpu). 
+	// The output does not depend on the number of threads.
+	bool Polygonize(CSimpleTextSubtitle& sts, int iLang = -1, bool fSmooth = true, int scale = 3, int nThreads = 0, IPolygonizeProgress* pProgress = NULL);
+
 	CString GetTitle() {return(m_title);}
 
 	DECLARE_IUNKNOWN
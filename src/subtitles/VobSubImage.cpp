@@ -21,10 +21,12 @@
 
 #include "stdafx.h"
 #include "VobSubImage.h"
+#include <algorithm>
 
 CVobSubImage::CVobSubImage()
 {
 	iLang = iIdx = -1;
+	nSerial = 0;
 	fForced = false;
 	start = delay = 0;
 	rect = CRect(0,0,0,0);
@@ -37,6 +39,26 @@ CVobSubImage::~CVobSubImage()
 	Free();
 }
 
+void CVobSubImage::Swap(CVobSubImage& img)
+{
+	std::swap(org, img.org);
+	std::swap(lpTemp1, img.lpTemp1);
+	std::swap(lpTemp2, img.lpTemp2);
+	std::swap(fCustomPal, img.fCustomPal);
+	std::swap(tridx, img.tridx);
+	std::swap(orgpal, img.orgpal);
+	std::swap(cuspal, img.cuspal);
+	std::swap(iLang, img.iLang);
+	std::swap(iIdx, img.iIdx);
+	std::swap(nSerial, img.nSerial);
+	std::swap(fForced, img.fForced);
+	std::swap(start, img.start);
+	std::swap(delay, img.delay);
+	std::swap(rect, img.rect);
+	for(int i = 0; i < 4; i++) std::swap(pal[i], img.pal[i]);
+	std::swap(lpPixels, img.lpPixels);
+}
+
 bool CVobSubImage::Alloc(int w, int h)
 {
 	// if there is nothing to crop TrimSubImage might even add a 1 pixel
@@ -73,28 +95,43 @@ void CVobSubImage::Free()
 	lpPixels = NULL;
 }
 
+// Number of nibbles of the run length code starting with the given byte, the longer the code the
+// more leading zero nibbles: 4 bits codes are >= 0x4, 8 bits >= 0x10, 12 bits >= 0x40.
+static struct RleCodeLength
+{
+	BYTE len[256];
+
+	RleCodeLength()
+	{
+		for(int i = 0; i < 256; i++)
+			len[i] = i >= 0x40 ? 1 : i >= 0x10 ? 2 : i >= 0x04 ? 3 : 4;
+	}
+} s_rle_code_length;
+
 bool CVobSubImage::Decode(BYTE* lpData, int packetsize, int datasize,
 						  bool fCustomPal, 
 						  int tridx, 
 						  RGBQUAD* orgpal /*[16]*/, RGBQUAD* cuspal /*[4]*/,
 						  bool fTrim)
 {
-	GetPacketInfo(lpData, packetsize, datasize);
+	WORD nOffset[2] = {0, 0};
 
-	if(!Alloc(rect.Width(), rect.Height())) return(false);
+	GetPacketInfo(lpData, packetsize, datasize, nOffset);
+
+	int w = rect.Width(), h = rect.Height();
+
+	if(!Alloc(w, h)) return(false);
 
 	lpPixels = lpTemp1;
 
-	nPlane = 0;
-	fAligned = 1;
+	static LONG s_nSerial = 0;
+	nSerial = InterlockedIncrement(&s_nSerial);
 
 	this->fCustomPal = fCustomPal;
 	this->orgpal = orgpal;
 	this->tridx = tridx;
 	this->cuspal = cuspal;
 
-	CPoint p(rect.left, rect.top);
-
 	int end0 = nOffset[1];
 	int end1 = datasize;
 
@@ -104,36 +141,82 @@ bool CVobSubImage::Decode(BYTE* lpData, int packetsize, int datasize,
 		end0 = datasize;
 	}
 
-	while((nPlane == 0 && nOffset[0] < end0) || (nPlane == 1 && nOffset[1] < end1))
+	// The two fields are interlaced line by line, each one starting on a byte boundary. The runs 
+	// are decoded as color indices into the front of lpTemp1, expanded to RGBQUAD once trimmed.
+
+	BYTE* idx = (BYTE*)lpTemp1;
+
+	int pos[2] = {nOffset[0]*2, nOffset[1]*2}; // in nibbles
+	int end[2] = {end0*2, end1*2};
+
+	int y = 0;
+
+	for(bool fEnd = false; !fEnd; )
 	{
-		DWORD code;
+		int& p = pos[y&1];
+		BYTE* row = y < h ? &idx[w*y] : NULL;
+
+		int x = 0;
 
-		if((code = GetNibble(lpData)) >= 0x4
-		|| (code = (code << 4) | GetNibble(lpData)) >= 0x10
-		|| (code = (code << 4) | GetNibble(lpData)) >= 0x40
-		|| (code = (code << 4) | GetNibble(lpData)) >= 0x100)
+		do
 		{
-			DrawPixels(p, code >> 2, code & 3);
-			if((p.x += code >> 2) < rect.right) continue;
+			// out of data: the end is checked before every code, like the nibble at a time decoder
+			// did, and the line being decoded does not count, its rect ended at the last full line
+			if(p >= end[y&1]) {fEnd = true; break;}
+
+			// the next 16 bits from the nibble p on, the longest code there is
+			int i = p >> 1;
+			DWORD bits = i+2 < packetsize
+				? (lpData[i] << 16) | (lpData[i+1] << 8) | lpData[i+2]
+				: ((i < packetsize ? lpData[i] : 0) << 16) | ((i+1 < packetsize ? lpData[i+1] : 0) << 8);
+			bits = (bits >> ((p & 1) ? 4 : 8)) & 0xffff;
+
+			int len = s_rle_code_length.len[bits >> 8];
+			DWORD code = bits >> (16 - 4*len);
+			p += len;
+
+			// 16 bits codes with a run shorter than 64 fill the rest of the line
+			int run = len == 4 && code < 0x100 ? w - x : min((int)(code >> 2), w - x);
+			if(row) memset(&row[x], code & 3, run);
+			x += run;
 		}
+		while(x < w);
 
-		DrawPixels(p, rect.right - p.x, code & 3);
+		if(!fEnd)
+		{
+			p = (p + 1) & ~1; // align to byte
+			y++;
+		}
+	}
 
-		if(!fAligned) GetNibble(lpData); // align to byte
+	h = min(y, h);
+	rect.bottom = rect.top + h;
 
-		p.x = rect.left;
-		p.y++;
-		nPlane = 1 - nPlane;
-	}
+	RGBQUAD c[4];
 
-	rect.bottom = min(p.y, rect.bottom);
+	for(int i = 0; i < 4; i++)
+	{
+		if(!fCustomPal) 
+		{
+			c[i] = orgpal[pal[i].pal];
+			c[i].rgbReserved = (pal[i].tr<<4)|pal[i].tr;
+		}
+		else
+		{
+			c[i] = cuspal[i];
+		}
+	}
 
-	if(fTrim) TrimSubImage();
+	if(!fTrim || !TrimSubImage(c))
+	{
+		// backwards, the indices are read before their RGBQUADs are written over them
+		for(int i = w*h-1; i >= 0; i--) lpTemp1[i] = c[idx[i]];
+	}
 
 	return(true);
 }
 
-void CVobSubImage::GetPacketInfo(BYTE* lpData, int packetsize, int datasize)
+void CVobSubImage::GetPacketInfo(BYTE* lpData, int packetsize, int datasize, WORD* pOffsets)
 {
 //	delay = 0;
 
@@ -207,8 +290,12 @@ void CVobSubImage::GetPacketInfo(BYTE* lpData, int packetsize, int datasize)
 					i += 6;
 					break;
 				case 0x06:
-					nOffset[0] = (lpData[i] << 8) + lpData[i+1]; i += 2;
-					nOffset[1] = (lpData[i] << 8) + lpData[i+1]; i += 2;
+					if(pOffsets)
+					{
+						pOffsets[0] = (lpData[i] << 8) + lpData[i+1];
+						pOffsets[1] = (lpData[i+2] << 8) + lpData[i+3];
+					}
+					i += 4;
 					break;
 				case 0xff: // end of ctrlblk
 					fBreak = true;
@@ -228,71 +315,41 @@ void CVobSubImage::GetPacketInfo(BYTE* lpData, int packetsize, int datasize)
 	}
 }
 
-BYTE CVobSubImage::GetNibble(BYTE* lpData)
-{
-	WORD& off = nOffset[nPlane];
-	BYTE ret = (lpData[off] >> (fAligned << 2)) & 0x0f;
-	fAligned = !fAligned;
-	off += fAligned;
-	return(ret);
-}
+// Crops the indexed image of lpTemp1 to its visible pixels and expands it into lpTemp2, with 
+// a 1 pixel wide transparent border around.
+// @return: false if no pixel is visible, lpTemp1 is left as it is
 
-void CVobSubImage::DrawPixels(CPoint p, int length, int colorid)
+bool CVobSubImage::TrimSubImage(const RGBQUAD* c)
 {
-	if(length <= 0
-	|| p.x + length < rect.left
-	|| p.x >= rect.right
-	|| p.y < rect.top
-	|| p.y >= rect.bottom) 
-	{
-		return;
-	}
-
-	if(p.x < rect.left) p.x = rect.left;
-	if(p.x + length >= rect.right) length = rect.right - p.x;
+	const BYTE* idx = (const BYTE*)lpTemp1;
 
-	RGBQUAD* ptr = &lpPixels[rect.Width() * (p.y - rect.top) + (p.x - rect.left)];
+	bool fVisible[4];
+	for(int i = 0; i < 4; i++) fVisible[i] = c[i].rgbReserved != 0;
 
-	RGBQUAD c;
-
-	if(!fCustomPal) 
-	{
-		c = orgpal[pal[colorid].pal];
-		c.rgbReserved = (pal[colorid].tr<<4)|pal[colorid].tr;
-	}
-	else
-	{
-		c = cuspal[colorid];
-	}
-
-	while(length-- > 0) *ptr++ = c;
-}
-
-void CVobSubImage::TrimSubImage()
-{
 	CRect r;
 	r.left = rect.Width();
 	r.top = rect.Height();
 	r.right = 0;
 	r.bottom = 0;
 
-	RGBQUAD* ptr = lpTemp1;
-
-	for(int j = 0, y = rect.Height(); j < y; j++)
+	for(int j = 0, y = rect.Height(), x = rect.Width(); j < y; j++)
 	{
-		for(int i = 0, x = rect.Width(); i < x; i++, ptr++)
-		{
-			if(ptr->rgbReserved)
-			{
-				if(r.top > j) r.top = j;
-				if(r.bottom < j) r.bottom = j;
-				if(r.left > i) r.left = i; 
-				if(r.right < i) r.right = i; 
-			}
-		}
+		const BYTE* row = &idx[x*j];
+
+		int i = 0;
+		while(i < x && !fVisible[row[i]]) i++;
+		if(i == x) continue;
+
+		int k = x-1;
+		while(!fVisible[row[k]]) k--;
+
+		if(r.top > j) r.top = j;
+		r.bottom = j;
+		if(r.left > i) r.left = i; 
+		if(r.right < k) r.right = k; 
 	}
 
-	if(r.left > r.right || r.top > r.bottom) return;
+	if(r.left > r.right || r.top > r.bottom) return(false);
 
 	r += CRect(0, 0, 1, 1);
 
@@ -304,16 +361,16 @@ void CVobSubImage::TrimSubImage()
 
 	r += CRect(1, 1, 1, 1);
 
-	DWORD* src = (DWORD*)&lpTemp1[offset];
-	DWORD* dst = (DWORD*)&lpTemp2[1 + w + 1];
+	const BYTE* src = &idx[offset];
+	RGBQUAD* dst = &lpTemp2[1 + w + 1];
 
 	memset(lpTemp2, 0, (1 + w + 1)*sizeof(RGBQUAD));
 
 	for(int height = h; height; height--, src += rect.Width())
 	{
-		*dst++ = 0;
-		memcpy(dst, src, w*sizeof(RGBQUAD)); dst += w; 
-		*dst++ = 0;
+		*(DWORD*)dst++ = 0;
+		for(int i = 0; i < w; i++) *dst++ = c[src[i]];
+		*(DWORD*)dst++ = 0;
 	}
 
 	memset(dst, 0, (1 + w + 1)*sizeof(RGBQUAD));
@@ -321,6 +378,8 @@ void CVobSubImage::TrimSubImage()
 	lpPixels = lpTemp2;
 
 	rect = r + rect.TopLeft();
+
+	return(true);
 }
 
 ////////////////////////////////
@@ -40,21 +40,18 @@ private:
 	RGBQUAD* lpTemp1;
 	RGBQUAD* lpTemp2;
 
-	WORD nOffset[2], nPlane;
 	bool fCustomPal;
-	char fAligned; // we are also using this for calculations, that's why it is char instead of bool...
 	int tridx;
 	RGBQUAD* orgpal /*[16]*/,* cuspal /*[4]*/;
 
 	bool Alloc(int w, int h);
 	void Free();
 
-	BYTE GetNibble(BYTE* lpData);
-	void DrawPixels(CPoint p, int length, int colorid);
-	void TrimSubImage();
+	bool TrimSubImage(const RGBQUAD* c /*[4]*/);
 
 public:
 	int iLang, iIdx;
+	LONG nSerial; // a new one for every decoded image, so that its renderings can be kept
 	bool fForced;
 	__int64 start, delay;
 	CRect rect;
@@ -66,8 +63,10 @@ public:
 	virtual ~CVobSubImage();
 
 	void Invalidate() {iLang = iIdx = -1;}
+	void Swap(CVobSubImage& img); // exchanges the decoded images, including their buffers
 
-	void GetPacketInfo(BYTE* lpData, int packetsize, int datasize);
+	// pOffsets: if not NULL, receives the offsets of the two fields of the rle data
+	void GetPacketInfo(BYTE* lpData, int packetsize, int datasize, WORD* pOffsets = NULL /*[2]*/);
 	bool Decode(BYTE* lpData, int packetsize, int datasize,
 				bool fCustomPal, 
 				int tridx, 
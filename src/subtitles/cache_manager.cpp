@@ -7,6 +7,8 @@
 #include "draw_item.h"
 #include "xy_overlay_paint_machine.h"
 #include "xy_clipper_paint_machine.h"
+#include "xy_bitmap.h"
+#include "xy_rle.h"
 
 enum { TextInfoCacheKey_EQUAL, ScanLineData2CacheKey_EQUAL, 
     OverlayNoBlurKey_EQUAL, OverlayKey_EQUAL, 
@@ -411,6 +413,158 @@ bool GroupedDrawItemsHashKey::operator==( const GroupedDrawItemsHashKey& key ) c
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 
+// OverlayCompressor
+
+bool OverlayCompressor::Compress( const SharedPtrOverlay& overlay, Compressed *output )
+{
+    ASSERT(output);
+    if (!overlay || !overlay->mBody)
+    {
+        return false;
+    }
+    int plan_size = overlay->mOverlayPitch * overlay->mOverlayHeight;
+    int raw_size = overlay->mBorder ? 2*plan_size : plan_size;
+    if (raw_size < CacheManager::COLD_CACHE_MIN_ITEM_SIZE)
+    {
+        return false;
+    }
+    Compressed compressed(new CompressedOverlay());
+    compressed->header = *overlay;
+    compressed->header.mBody.reset((BYTE*)NULL);
+    compressed->header.mBorder.reset((BYTE*)NULL);
+    compressed->data.reserve(raw_size/4);
+    //code the whole pitch, so that the paddings are restored as they were
+    XyRle::Encode<BYTE>(&compressed->data, overlay->mBody.get(), 
+        overlay->mOverlayPitch, overlay->mOverlayHeight, overlay->mOverlayPitch);
+    if (overlay->mBorder)
+    {
+        XyRle::Encode<BYTE>(&compressed->data, overlay->mBorder.get(), 
+            overlay->mOverlayPitch, overlay->mOverlayHeight, overlay->mOverlayPitch);
+    }
+    if (compressed->data.size() > static_cast<std::size_t>(raw_size/2))
+    {
+        return false;//not worth it
+    }
+    std::vector<BYTE>(compressed->data).swap(compressed->data);//shrink to fit
+    *output = compressed;
+    return true;
+}
+
+bool OverlayCompressor::Decompress( const Compressed& input, SharedPtrOverlay *output )
+{
+    ASSERT(output && input);
+    const Overlay& header = input->header;
+    int plan_size = header.mOverlayPitch * header.mOverlayHeight;
+    const BYTE *src = &input->data[0];
+    const BYTE *end = src + input->data.size();
+
+    SharedPtrOverlay overlay(new Overlay());
+    *overlay = header;
+    BYTE* body = reinterpret_cast<BYTE*>(xy_malloc(plan_size));
+    if (!body)
+    {
+        return false;
+    }
+    overlay->mBody.reset(body, xy_free);
+    src = XyRle::Decode<BYTE>(body, header.mOverlayPitch, header.mOverlayHeight, header.mOverlayPitch, 
+        src, end-src);
+    if (src && src!=end)
+    {
+        BYTE* border = reinterpret_cast<BYTE*>(xy_malloc(plan_size));
+        if (!border)
+        {
+            return false;
+        }
+        overlay->mBorder.reset(border, xy_free);
+        src = XyRle::Decode<BYTE>(border, header.mOverlayPitch, header.mOverlayHeight, header.mOverlayPitch, 
+            src, end-src);
+    }
+    if (src!=end)
+    {
+        ASSERT(0);
+        return false;
+    }
+    *output = overlay;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+// BitmapCompressor
+
+bool BitmapCompressor::Compress( const SharedPtrXyBitmap& bitmap, Compressed *output )
+{
+    ASSERT(output);
+    if (!bitmap || !bitmap->bits || bitmap->w*bitmap->h*4 < CacheManager::COLD_CACHE_MIN_ITEM_SIZE)
+    {
+        return false;
+    }
+    Compressed compressed(new CompressedBitmap());
+    compressed->type = bitmap->type;
+    compressed->x = bitmap->x;
+    compressed->y = bitmap->y;
+    compressed->w = bitmap->w;
+    compressed->h = bitmap->h;
+    int raw_size = bitmap->w*bitmap->h*4;
+    compressed->data.reserve(raw_size/4);
+    switch (bitmap->type)
+    {
+    case XyBitmap::PACK:
+        XyRle::Encode<DWORD>(&compressed->data, bitmap->plans[0], bitmap->w, bitmap->h, bitmap->pitch);
+        break;
+    case XyBitmap::PLANNA:
+        for (int i=0;i<4;i++)
+        {
+            XyRle::Encode<BYTE>(&compressed->data, bitmap->plans[i], bitmap->w, bitmap->h, bitmap->pitch);
+        }
+        break;
+    default:
+        ASSERT(0);
+        return false;
+    }
+    if (compressed->data.size() > static_cast<std::size_t>(raw_size/2))
+    {
+        return false;//not worth it
+    }
+    std::vector<BYTE>(compressed->data).swap(compressed->data);//shrink to fit
+    *output = compressed;
+    return true;
+}
+
+bool BitmapCompressor::Decompress( const Compressed& input, SharedPtrXyBitmap *output )
+{
+    ASSERT(output && input);
+    CRect rect(input->x, input->y, input->x + input->w, input->y + input->h);
+    SharedPtrXyBitmap bitmap(XyBitmap::CreateBitmap(rect, static_cast<XyBitmap::MemLayout>(input->type)));
+    if (!bitmap || !bitmap->bits)
+    {
+        return false;
+    }
+    const BYTE *src = &input->data[0];
+    const BYTE *end = src + input->data.size();
+    switch (bitmap->type)
+    {
+    case XyBitmap::PACK:
+        src = XyRle::Decode<DWORD>(bitmap->plans[0], bitmap->w, bitmap->h, bitmap->pitch, src, end-src);
+        break;
+    case XyBitmap::PLANNA:
+        for (int i=0;i<4 && src;i++)
+        {
+            src = XyRle::Decode<BYTE>(bitmap->plans[i], bitmap->w, bitmap->h, bitmap->pitch, src, end-src);
+        }
+        break;
+    }
+    if (src!=end)
+    {
+        ASSERT(0);
+        return false;
+    }
+    *output = bitmap;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+
 // CacheManager
 
 struct Caches
@@ -431,7 +585,10 @@ public:
         s_overlay_no_offset_mru_cache = NULL;
 		
         s_subpixel_variance_cache = NULL;
+        s_shadow_overlay_cache = NULL;
         s_ass_tag_list_cache = NULL;
+
+        s_cold_cache_max_size = CacheManager::COLD_CACHE_MAX_SIZE;
     }
     ~Caches()
     {
@@ -448,6 +605,7 @@ public:
         delete s_overlay_no_offset_mru_cache;
 
         delete s_subpixel_variance_cache;
+        delete s_shadow_overlay_cache;
         delete s_ass_tag_list_cache;
     }
 public:
@@ -461,10 +619,13 @@ public:
     OverlayNoOffsetMruCache* s_overlay_no_offset_mru_cache;
 
     OverlayMruCache* s_subpixel_variance_cache;
+    OverlayMruCache* s_shadow_overlay_cache;
     OverlayMruCache* s_overlay_mru_cache;
     OverlayNoBlurMruCache* s_overlay_no_blur_mru_cache;
     PathDataMruCache* s_path_data_mru_cache;
     ScanLineData2MruCache* s_scan_line_data_2_mru_cache;
+
+    std::size_t s_cold_cache_max_size;
 };
 
 static Caches s_caches;
@@ -473,7 +634,8 @@ OverlayMruCache* CacheManager::GetOverlayMruCache()
 {
     if(s_caches.s_overlay_mru_cache==NULL)
     {
-        s_caches.s_overlay_mru_cache = new OverlayMruCache(OVERLAY_CACHE_ITEM_NUM);
+        s_caches.s_overlay_mru_cache = new OverlayMruCache(OVERLAY_CACHE_ITEM_NUM, 
+            OVERLAY_COLD_CACHE_ITEM_NUM, s_caches.s_cold_cache_max_size);
     }
     return s_caches.s_overlay_mru_cache;
 }
@@ -514,6 +676,15 @@ OverlayMruCache* CacheManager::GetSubpixelVarianceCache()
     return s_caches.s_subpixel_variance_cache;    
 }
 
+OverlayMruCache* CacheManager::GetShadowOverlayCache()
+{
+    if(s_caches.s_shadow_overlay_cache==NULL)
+    {
+        s_caches.s_shadow_overlay_cache = new OverlayMruCache(SHADOW_OVERLAY_CACHE_ITEM_NUM);
+    }
+    return s_caches.s_shadow_overlay_cache;
+}
+
 ScanLineDataMruCache* CacheManager::GetScanLineDataMruCache()
 {
     if(s_caches.s_scan_line_data_mru_cache==NULL)
@@ -563,7 +734,21 @@ BitmapMruCache* CacheManager::GetBitmapMruCache()
 {
     if (s_caches.s_bitmap_cache==NULL)
     {
-        s_caches.s_bitmap_cache = new BitmapMruCache(BITMAP_MRU_CACHE_ITEM_NUM);
+        s_caches.s_bitmap_cache = new BitmapMruCache(BITMAP_MRU_CACHE_ITEM_NUM, 
+            BITMAP_COLD_CACHE_ITEM_NUM, s_caches.s_cold_cache_max_size);
     }
     return s_caches.s_bitmap_cache;
 }
+
+void CacheManager::SetColdCacheMaxSize( std::size_t max_size )
+{
+    s_caches.s_cold_cache_max_size = max_size;
+    if (s_caches.s_overlay_mru_cache)
+    {
+        s_caches.s_overlay_mru_cache->SetColdLimits(OVERLAY_COLD_CACHE_ITEM_NUM, max_size);
+    }
+    if (s_caches.s_bitmap_cache)
+    {
+        s_caches.s_bitmap_cache->SetColdLimits(BITMAP_COLD_CACHE_ITEM_NUM, max_size);
+    }
+}
@@ -5,6 +5,7 @@
 #ifndef __CACHE_MANAGER_H_310C134F_844C_4590_A4D2_AD30165AF10A__
 #define __CACHE_MANAGER_H_310C134F_844C_4590_A4D2_AD30165AF10A__
 
+#include <vector>
 #include "RTS.h"
 #include "mru_cache.h"
 #include "flyweight_base_types.h"
@@ -282,7 +283,26 @@ typedef EnhancedXyMru<ScanLineData2CacheKey, SharedPtrConstScanLineData2, XyCach
 
 typedef EnhancedXyMru<OverlayNoBlurKey, SharedPtrOverlay, XyCacheKeyTraits<OverlayNoBlurKey>> OverlayNoBlurMruCache;
 
-typedef EnhancedXyMru<OverlayKey, SharedPtrOverlay, XyCacheKeyTraits<OverlayKey>> OverlayMruCache;
+// Keeps cold overlays run length coded (see XyRle)
+class OverlayCompressor
+{
+public:
+    struct CompressedOverlay
+    {
+        Overlay header;//every member but the plans
+        std::vector<BYTE> data;//body plan, then border plan if any
+    };
+    typedef ::boost::shared_ptr<CompressedOverlay> Compressed;
+
+    static bool Compress(const SharedPtrOverlay& overlay, Compressed *output);
+    static bool Decompress(const Compressed& input, SharedPtrOverlay *output);
+    static inline std::size_t GetSize(const Compressed& input)
+    {
+        return sizeof(CompressedOverlay) + input->data.capacity();
+    }
+};
+
+typedef XyCompressedMru<OverlayKey, SharedPtrOverlay, OverlayCompressor, XyCacheKeyTraits<OverlayKey>> OverlayMruCache;
 
 typedef EnhancedXyMru<ScanLineDataCacheKey, SharedPtrConstScanLineData, XyCacheKeyTraits<ScanLineDataCacheKey>> ScanLineDataMruCache;
 
@@ -292,7 +312,27 @@ typedef EnhancedXyMru<ClipperAlphaMaskCacheKey, SharedPtrGrayImage2, XyCacheKeyT
 
 class XyBitmap;
 typedef ::boost::shared_ptr<XyBitmap> SharedPtrXyBitmap;
-typedef EnhancedXyMru<std::size_t, SharedPtrXyBitmap> BitmapMruCache;
+// Keeps cold bitmaps run length coded (see XyRle)
+class BitmapCompressor
+{
+public:
+    struct CompressedBitmap
+    {
+        int type;
+        int x, y, w, h;
+        std::vector<BYTE> data;//the pixels, or the 4 plans one after another
+    };
+    typedef ::boost::shared_ptr<CompressedBitmap> Compressed;
+
+    static bool Compress(const SharedPtrXyBitmap& bitmap, Compressed *output);
+    static bool Decompress(const Compressed& input, SharedPtrXyBitmap *output);
+    static inline std::size_t GetSize(const Compressed& input)
+    {
+        return sizeof(CompressedBitmap) + input->data.capacity();
+    }
+};
+
+typedef XyCompressedMru<std::size_t, SharedPtrXyBitmap, BitmapCompressor> BitmapMruCache;
 
 class CacheManager
 {
@@ -303,6 +343,7 @@ public:
     static const int TEXT_INFO_CACHE_ITEM_NUM = 2048;
     static const int ASS_TAG_LIST_CACHE_ITEM_NUM = 2048;
     static const int SUBPIXEL_VARIANCE_CACHE_ITEM_NUM = 2048;
+    static const int SHADOW_OVERLAY_CACHE_ITEM_NUM = 512;
     static const int OVERLAY_CACHE_ITEM_NUM = 2048;
 
     static const int OVERLAY_NO_BLUR_CACHE_ITEM_NUM = 256;
@@ -310,6 +351,15 @@ public:
     static const int PATH_CACHE_ITEM_NUM = 768;
     static const int WORD_CACHE_ITEM_NUM = 512;
 
+    // Compressed (cold) tier of the overlay and bitmap caches, see XyCompressedMru
+    static const int OVERLAY_COLD_CACHE_ITEM_NUM = 8192;
+    static const int BITMAP_COLD_CACHE_ITEM_NUM = 256;
+    static const int COLD_CACHE_MAX_SIZE = 16*1024*1024;//in bytes, shared by each of the caches
+    static const int COLD_CACHE_MIN_ITEM_SIZE = 4*1024;//smaller items are not worth compressing
+
+    // @max_size: in bytes, 0 to disable the compressed tiers
+    static void SetColdCacheMaxSize(std::size_t max_size);
+
     static BitmapMruCache* GetBitmapMruCache();
 
     static ClipperAlphaMaskMruCache* GetClipperAlphaMaskMruCache();
@@ -320,6 +370,7 @@ public:
     static OverlayNoOffsetMruCache* GetOverlayNoOffsetMruCache();
 
     static OverlayMruCache* GetSubpixelVarianceCache();
+    static OverlayMruCache* GetShadowOverlayCache();//shadows shifted from outline overlays
     static OverlayMruCache* GetOverlayMruCache();
     static OverlayNoBlurMruCache* GetOverlayNoBlurMruCache();
     static ScanLineData2MruCache* GetScanLineData2MruCache();
@@ -327,7 +378,10 @@ public:
 };
 
 
-typedef XyFlyWeight<GroupedDrawItemsHashKey, CacheManager::BITMAP_MRU_CACHE_ITEM_NUM, XyCacheKeyTraits<GroupedDrawItemsHashKey>> XyFwGroupedDrawItemsHashKey;
+// BitmapMruCache is keyed on the ids of this cacher, it holds as many keys as both tiers of the cache
+typedef XyFlyWeight<GroupedDrawItemsHashKey, 
+    CacheManager::BITMAP_MRU_CACHE_ITEM_NUM+CacheManager::BITMAP_COLD_CACHE_ITEM_NUM, 
+    XyCacheKeyTraits<GroupedDrawItemsHashKey>> XyFwGroupedDrawItemsHashKey;
 
 #endif // end of __CACHE_MANAGER_H_310C134F_844C_4590_A4D2_AD30165AF10A__
 
@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <boost/shared_ptr.hpp>
 #include "xy_overlay_paint_machine.h"
+#include "xy_render_timing.h"
 #include "xy_clipper_paint_machine.h"
 #include "../SubPic/ISubPic.h"
 #include "xy_bitmap.h"
@@ -155,6 +156,7 @@ void CreateDrawItemExTree( CompositeDrawItemListList& input,
 
 void CompositeDrawItem::Draw( XySubRenderFrame**output, CompositeDrawItemListList& compDrawItemListList )
 {
+    XyRenderTiming::Scope timing(XyRenderTiming::COMPOSITE);
     if (!output)
     {
         return;
@@ -1063,6 +1063,7 @@ class XyMru
 {
 public:
     XyMru(std::size_t max_item_num):_max_item_num(max_item_num){}
+    virtual ~XyMru(){}
 
     inline POSITION UpdateCache(POSITION pos)
     {
@@ -1092,11 +1093,7 @@ public:
             _list.GetAt(pos_hash_value).second = value;
             _list.MoveToHead(pos_hash_value);
         }
-        if(_list.GetCount()>_max_item_num)
-        {
-            _hash.RemoveAtPos(_list.GetTail().first);
-            _list.RemoveTail();
-        }
+        _Shrink();
         return pos_hash_value;
     }
     inline POSITION AddHeadIfNotExists(const K& key, const V& value, bool *new_item_added)
@@ -1122,11 +1119,7 @@ public:
                 *new_item_added = false;
             }
         }
-        if(_list.GetCount()>_max_item_num)
-        {
-            _hash.RemoveAtPos(_list.GetTail().first);
-            _list.RemoveTail();
-        }
+        _Shrink();
         return pos_hash_value;
     }
     inline void RemoveAll() 
@@ -1134,6 +1127,11 @@ public:
         _hash.RemoveAll();
         _list.RemoveAll();
     }
+    inline void RemoveAt(POSITION pos)
+    {
+        _hash.RemoveAtPos(_list.GetAt(pos).first);
+        _list.RemoveAt(pos);
+    }
     
     inline POSITION Lookup(const K& key) const
     {
@@ -1162,15 +1160,26 @@ public:
     inline std::size_t SetMaxItemNum( std::size_t max_item_num )
     {
         _max_item_num = max_item_num;
+        _Shrink();
+        return _max_item_num;
+    }
+    inline std::size_t GetMaxItemNum() const { return _max_item_num; }
+    inline std::size_t GetCurItemNum() const { return _list.GetCount(); }
+    inline POSITION GetTailPosition() const { return _list.GetTailPosition(); }
+protected:
+    // Called right before the least recently used item is dropped because the cache is full
+    virtual void OnEvict(const K& key, const V& value) {}
+
+    inline void _Shrink()
+    {
         while(_list.GetCount()>_max_item_num)
         {
-            _hash.RemoveAtPos(_list.GetTail().first);
+            const ListItem& tail = _list.GetTail();
+            OnEvict(_hash.GetKeyAt(tail.first), tail.second);
+            _hash.RemoveAtPos(tail.first);
             _list.RemoveTail();
         }
-        return _max_item_num;
     }
-    inline std::size_t GetMaxItemNum() const { return _max_item_num; }
-    inline std::size_t GetCurItemNum() const { return _list.GetCount(); }
 protected:
     typedef std::pair<POSITION,V> ListItem;
     CAtlList<ListItem> _list;
@@ -1233,4 +1242,129 @@ protected:
     std::size_t _query_count;
 };
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/****
+ * An EnhancedXyMru with a second, compressed tier for cold items.
+ * Items evicted from the hot (uncompressed) list are handed to @Compressor and the compressed 
+ * copies are kept in a cold list, limited by item number and by total compressed size.
+ * A Lookup miss in the hot list falls back to the cold list, and a cold hit is decompressed and 
+ * moved back to the head of the hot list.
+ * The cold tier is disabled while its limits are 0.
+ *
+ * Compressor MUST provide:
+ *   typedef ... Compressed; //copyable
+ *   static bool Compress(const V& value, Compressed *output); //false if value is not worth keeping
+ *   static bool Decompress(const Compressed& input, V *output);
+ *   static std::size_t GetSize(const Compressed& input);
+ **/
+template<
+    typename K,
+    typename V,
+    class Compressor,
+    class KTraits = CElementTraits< K >
+>
+class XyCompressedMru:public EnhancedXyMru<K,V,KTraits>
+{
+public:
+    typedef typename Compressor::Compressed Compressed;
+
+    XyCompressedMru(std::size_t max_item_num, std::size_t max_cold_item_num=0, std::size_t max_cold_size=0)
+        :EnhancedXyMru(max_item_num)
+        ,_cold(max_cold_item_num, &_cold_size)
+        ,_max_cold_size(max_cold_size)
+        ,_cold_size(0)
+        ,_cold_hit(0){}
+
+    void SetColdLimits(std::size_t max_cold_item_num, std::size_t max_cold_size)
+    {
+        _cold.SetMaxItemNum(max_cold_item_num);
+        _max_cold_size = max_cold_size;
+        _ShrinkCold();
+    }
+    void RemoveAll(bool clear_statistic_info=false) 
+    { 
+        if(clear_statistic_info) 
+        { 
+            _cold_hit=0; 
+        } 
+        _cold.RemoveAll();
+        _cold_size = 0;
+        __super::RemoveAll(clear_statistic_info);
+    }
+
+    inline POSITION Lookup(const K& key)
+    {
+        POSITION pos = __super::Lookup(key);
+        if (pos==NULL && _cold.GetCurItemNum()>0)
+        {
+            POSITION cold_pos = _cold.Lookup(key);
+            V value;
+            if (cold_pos!=NULL && Compressor::Decompress(_cold.GetAt(cold_pos), &value))
+            {
+                _cold_size -= Compressor::GetSize(_cold.GetAt(cold_pos));
+                _cold.RemoveAt(cold_pos);
+                pos = UpdateCache(key, value);
+                _cache_hit++;
+                _cold_hit++;
+            }
+        }
+        return pos;
+    }
+
+    inline std::size_t GetColdItemNum() const { return _cold.GetCurItemNum(); }
+    inline std::size_t GetColdSize() const { return _cold_size; }
+    inline std::size_t GetColdHitCount() const { return _cold_hit; }
+protected:
+    virtual void OnEvict(const K& key, const V& value)
+    {
+        if (_cold.GetMaxItemNum()==0 || _max_cold_size==0)
+        {
+            return;
+        }
+        Compressed compressed;
+        if (!Compressor::Compress(value, &compressed) || Compressor::GetSize(compressed)>_max_cold_size)
+        {
+            return;
+        }
+        POSITION cold_pos = _cold.Lookup(key);
+        if (cold_pos!=NULL)
+        {
+            _cold_size -= Compressor::GetSize(_cold.GetAt(cold_pos));
+            _cold.RemoveAt(cold_pos);
+        }
+        _cold_size += Compressor::GetSize(compressed);
+        _cold.UpdateCache(key, compressed);
+        _ShrinkCold();
+    }
+private:
+    class ColdMru:public XyMru<K,Compressed,KTraits>
+    {
+    public:
+        ColdMru(std::size_t max_item_num, std::size_t *size):XyMru(max_item_num),_size(size){}
+    protected:
+        virtual void OnEvict(const K& key, const Compressed& value)
+        {
+            *_size -= Compressor::GetSize(value);
+        }
+    private:
+        std::size_t *_size;
+    };
+
+    void _ShrinkCold()
+    {
+        while (_cold_size>_max_cold_size && _cold.GetCurItemNum()>0)
+        {
+            POSITION tail = _cold.GetTailPosition();
+            _cold_size -= Compressor::GetSize(_cold.GetAt(tail));
+            _cold.RemoveAt(tail);
+        }
+    }
+
+    ColdMru _cold;
+    std::size_t _max_cold_size;
+    std::size_t _cold_size;
+    std::size_t _cold_hit;
+};
+
 #endif // end of __MRU_CACHE_H_256FCF72_8663_41DC_B98A_B822F6007912__
@@ -1,5 +1,7 @@
 #include "stdafx.h"
 #include "../dsutil/vd.h"
+#include <vector>
+#include <math.h>
 
 typedef const UINT8 CUINT8, *PCUINT8;
 typedef const UINT CUINT, *PCUINT;
@@ -1385,3 +1387,464 @@ void xy_be_blur(PUINT8 src, int width, int height, int stride, float pass_x, flo
     xy_free(tmp);
     return;
 }
+
+/****
+ * Shift @src right by @xshift/8 pixel and down by @yshift/8 pixel with a bilinear filter, 
+ * and write the result to @dst in a single pass.
+ * Pixels outside @width*@height of @src are treated as 0. 
+ * Columns of @dst in [@dst_width, @dst_stride) are filled with 0.
+ * Equivalent: 
+ *   Copy @src into a zero filled @dst, then apply the in place bilinear filter on it.
+ * Constrain:
+ *   @dst_width>=@width && @dst_height>=@height && 0<=@xshift,@yshift<8
+ **/
+void xy_bilinear_shift_c(PUINT8 dst, int dst_width, int dst_height, int dst_stride, 
+    PCUINT8 src, int width, int height, int stride, int xshift, int yshift)
+{
+    ASSERT( dst_width>=width && dst_height>=height );
+    ASSERT( xshift>=0 && xshift<8 && yshift>=0 && yshift<8 );
+    for (int y=0;y<dst_height;y++)
+    {
+        PCUINT8 src_cur = y<height ? src + y*stride : NULL;
+        PCUINT8 src_last = (y>0 && y-1<height) ? src + (y-1)*stride : NULL;
+        PUINT8 dst2 = dst + y*dst_stride;
+        for (int x=0;x<dst_width;x++)
+        {
+            int h_cur = 0, h_last = 0;
+            if (src_cur)
+            {
+                h_cur = (x<width ? src_cur[x] : 0)*(8-xshift) + ((x>0 && x-1<width) ? src_cur[x-1] : 0)*xshift;
+            }
+            if (src_last)
+            {
+                h_last = (x<width ? src_last[x] : 0)*(8-xshift) + ((x>0 && x-1<width) ? src_last[x-1] : 0)*xshift;
+            }
+            dst2[x] = (h_cur*(8-yshift) + h_last*yshift + 32)>>6;
+        }
+        memset(dst2+dst_width, 0, dst_stride-dst_width);
+    }
+}
+
+/****
+ * See @xy_bilinear_shift_c
+ * Constrain:
+ *   @dst and @dst_stride MUST be 16 bytes aligned
+ **/
+void xy_bilinear_shift_sse2(PUINT8 dst, int dst_width, int dst_height, int dst_stride, 
+    PCUINT8 src, int width, int height, int stride, int xshift, int yshift)
+{
+    ASSERT( dst_width>=width && dst_height>=height );
+    ASSERT( xshift>=0 && xshift<8 && yshift>=0 && yshift<8 );
+    ASSERT( ((reinterpret_cast<UINT_PTR>(dst)|dst_stride)&15)==0 );
+
+    //s_mask+16-n: n bytes of 0xff followed by 0
+    static const UINT8 s_mask[32] = {
+        0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+        0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+    };
+
+    int buff_width = (dst_width+15)&~15;
+    UINT16 *h_buff = reinterpret_cast<UINT16*>(xy_malloc(2*buff_width*sizeof(UINT16)));
+    if (!h_buff)
+    {
+        //the C version needs no buffer
+        xy_bilinear_shift_c(dst, dst_width, dst_height, dst_stride, src, width, height, stride, xshift, yshift);
+        return;
+    }
+    UINT16 *h_cur = h_buff;
+    UINT16 *h_last = h_buff + buff_width;
+    memset(h_last, 0, buff_width*sizeof(UINT16));
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i fx0 = _mm_set1_epi16(8-xshift);
+    const __m128i fx1 = _mm_set1_epi16(xshift);
+    const __m128i fy0 = _mm_set1_epi16(8-yshift);
+    const __m128i fy1 = _mm_set1_epi16(yshift);
+    const __m128i round = _mm_set1_epi16(32);
+
+    for (int y=0;y<dst_height;y++)
+    {
+        // horizontal pass
+        if (y<height)
+        {
+            PCUINT8 src2 = src + y*stride;
+            __m128i last = zero;
+            for (int x=0;x<buff_width;x+=16)
+            {
+                __m128i cur = zero;
+                if (x<width)
+                {
+                    cur = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src2+x));
+                    if (x+16>width)
+                    {
+                        cur = _mm_and_si128(cur, _mm_loadu_si128(reinterpret_cast<const __m128i*>(s_mask+16-(width-x))));
+                    }
+                }
+                __m128i prev = _mm_or_si128(_mm_slli_si128(cur, 1), _mm_srli_si128(last, 15));
+                last = cur;
+
+                __m128i h_lo = _mm_add_epi16( _mm_mullo_epi16(_mm_unpacklo_epi8(cur, zero), fx0),
+                    _mm_mullo_epi16(_mm_unpacklo_epi8(prev, zero), fx1) );
+                __m128i h_hi = _mm_add_epi16( _mm_mullo_epi16(_mm_unpackhi_epi8(cur, zero), fx0),
+                    _mm_mullo_epi16(_mm_unpackhi_epi8(prev, zero), fx1) );
+                _mm_store_si128(reinterpret_cast<__m128i*>(h_cur+x), h_lo);
+                _mm_store_si128(reinterpret_cast<__m128i*>(h_cur+x+8), h_hi);
+            }
+        }
+        else
+        {
+            memset(h_cur, 0, buff_width*sizeof(UINT16));
+        }
+
+        // vertical pass
+        PUINT8 dst2 = dst + y*dst_stride;
+        for (int x=0;x<buff_width;x+=16)
+        {
+            __m128i c_lo = _mm_load_si128(reinterpret_cast<const __m128i*>(h_cur+x));
+            __m128i c_hi = _mm_load_si128(reinterpret_cast<const __m128i*>(h_cur+x+8));
+            __m128i l_lo = _mm_load_si128(reinterpret_cast<const __m128i*>(h_last+x));
+            __m128i l_hi = _mm_load_si128(reinterpret_cast<const __m128i*>(h_last+x+8));
+            __m128i v_lo = _mm_add_epi16( _mm_mullo_epi16(c_lo, fy0), _mm_mullo_epi16(l_lo, fy1) );
+            __m128i v_hi = _mm_add_epi16( _mm_mullo_epi16(c_hi, fy0), _mm_mullo_epi16(l_hi, fy1) );
+            v_lo = _mm_srli_epi16(_mm_add_epi16(v_lo, round), 6);
+            v_hi = _mm_srli_epi16(_mm_add_epi16(v_hi, round), 6);
+            __m128i out = _mm_packus_epi16(v_lo, v_hi);
+            if (x+16>dst_width)
+            {
+                out = _mm_and_si128(out, _mm_loadu_si128(reinterpret_cast<const __m128i*>(s_mask+16-(dst_width-x))));
+            }
+            _mm_store_si128(reinterpret_cast<__m128i*>(dst2+x), out);
+        }
+        memset(dst2+buff_width, 0, dst_stride-buff_width);
+
+        UINT16 *tmp = h_cur;
+        h_cur = h_last;
+        h_last = tmp;
+    }
+    xy_free(h_buff);
+}
+
+/****
+ * See @xy_bilinear_shift_c
+ **/
+void xy_bilinear_shift(PUINT8 dst, int dst_width, int dst_height, int dst_stride, 
+    PCUINT8 src, int width, int height, int stride, int xshift, int yshift)
+{
+    if ( (g_cpuid.m_flags & CCpuID::sse2) && ((reinterpret_cast<UINT_PTR>(dst)|dst_stride)&15)==0 )
+    {
+        xy_bilinear_shift_sse2(dst, dst_width, dst_height, dst_stride, src, width, height, stride, xshift, yshift);
+    }
+    else
+    {
+        xy_bilinear_shift_c(dst, dst_width, dst_height, dst_stride, src, width, height, stride, xshift, yshift);
+    }
+}
+
+/****
+ * Weights are 14 bits fixed point. The horizontal pass keeps 6 bits of fraction in its 16 bits
+ * output, the vertical pass drops them.
+ **/
+enum
+{
+    RESAMPLE_WEIGHT_BITS = 14,
+    RESAMPLE_FRAC_BITS = 6
+};
+
+static double xy_resample_kernel(double x, bool bicubic)
+{
+    x = fabs(x);
+    if (bicubic)
+    {
+        //Catmull-Rom: sharp, and its ringing hardly shows on the flat colors of bitmap subtitles
+        if (x<1)
+            return (1.5*x - 2.5)*x*x + 1;
+        if (x<2)
+            return ((-0.5*x + 2.5)*x - 4)*x + 2;
+        return 0;
+    }
+    return x<1 ? 1-x : 0;
+}
+
+/****
+ * Filter taps of output pixels [@from, @from+@count) of an axis of @size pixels scaled to @scaled.
+ *   output[i] = sum( weights[i*taps+k]*src[start[i]+k], k=0..taps-1 )>>RESAMPLE_WEIGHT_BITS
+ * Taps out of the source are folded onto its border pixels. When shrinking, the filter is
+ * stretched so that every source pixel counts.
+ * @return: taps, which is even so that the sse2 version can take them in pairs. The source MUST
+ *   hold max(@size, taps) pixels, the ones past @size get zero weights.
+ **/
+static int xy_resample_taps(std::vector<int> *start, std::vector<short> *weights,
+    int from, int count, int scaled, int size, bool bicubic)
+{
+    double scale = double(size)/scaled;
+    double stretch = scale>1 ? scale : 1;
+    double radius = (bicubic ? 2 : 1)*stretch;
+    int taps = (static_cast<int>(ceil(2*radius)) + 2) & ~1;
+    if (taps > ((size+1)&~1))
+    {
+        taps = (size+1)&~1;
+    }
+    int padded_size = size>taps ? size : taps;
+
+    start->resize(count);
+    weights->assign(count*taps, 0);
+    for (int i=0;i<count;i++)
+    {
+        double center = (from+i+0.5)*scale - 0.5;
+        int left = static_cast<int>(floor(center-radius)) + 1;
+        int right = static_cast<int>(floor(center+radius));
+        int lo = left<0 ? 0 : (left>size-1 ? size-1 : left);
+        int s = lo<padded_size-taps ? lo : padded_size-taps;
+        (*start)[i] = s;
+
+        double sum = 0;
+        for (int j=left;j<=right;j++)
+        {
+            sum += xy_resample_kernel((j-center)/stretch, bicubic);
+        }
+        //quantize the running sum, so that the weights always add up to exactly 1<<RESAMPLE_WEIGHT_BITS
+        short *w = &(*weights)[i*taps];
+        double acc = 0;
+        int last = 0;
+        for (int j=left;j<=right;j++)
+        {
+            acc += xy_resample_kernel((j-center)/stretch, bicubic)/sum;
+            int cur = static_cast<int>(floor(acc*(1<<RESAMPLE_WEIGHT_BITS) + 0.5));
+            int k = (j<0 ? 0 : (j>size-1 ? size-1 : j)) - s;
+            ASSERT(k>=0 && k<taps);
+            w[k] += static_cast<short>(cur-last);
+            last = cur;
+        }
+    }
+    return taps;
+}
+
+/****
+ * Horizontal pass: 4 shorts per output pixel, in the order of the source bytes.
+ **/
+static void xy_resample_row_c(short *dst, int dst_width, const DWORD *src,
+    const int *start, const short *weights, int taps)
+{
+    for (int i=0;i<dst_width;i++, weights+=taps, dst+=4)
+    {
+        const BYTE *p = reinterpret_cast<const BYTE*>(src + start[i]);
+        int sum[4] = {0,0,0,0};
+        for (int k=0;k<taps;k++, p+=4)
+        {
+            for (int c=0;c<4;c++)
+            {
+                sum[c] += weights[k]*p[c];
+            }
+        }
+        for (int c=0;c<4;c++)
+        {
+            dst[c] = static_cast<short>((sum[c] + (1<<(RESAMPLE_WEIGHT_BITS-RESAMPLE_FRAC_BITS-1)))
+                >> (RESAMPLE_WEIGHT_BITS-RESAMPLE_FRAC_BITS));
+        }
+    }
+}
+
+/****
+ * Vertical pass: @rows are the @taps horizontally filtered rows under the output row. Colors are
+ * clamped to the alpha, so that the overshoot of the bicubic filter still gives valid
+ * premultiplied pixels.
+ **/
+static void xy_resample_column_c(DWORD *dst, int dst_width, const short * const *rows,
+    const short *weights, int taps)
+{
+    const int SHIFT = RESAMPLE_WEIGHT_BITS+RESAMPLE_FRAC_BITS;
+    for (int i=0;i<dst_width;i++)
+    {
+        int v[4];
+        for (int c=0;c<4;c++)
+        {
+            int sum = 0;
+            for (int k=0;k<taps;k++)
+            {
+                sum += weights[k]*rows[k][4*i+c];
+            }
+            v[c] = (sum + (1<<(SHIFT-1))) >> SHIFT;
+        }
+        DWORD pixel = 0;
+        for (int c=3;c>=0;c--)
+        {
+            int x = v[c]<v[3] ? v[c] : v[3];
+            x = x<0 ? 0 : (x>255 ? 255 : x);
+            pixel = (pixel<<8) | x;
+        }
+        dst[i] = pixel;
+    }
+}
+
+/****
+ * See @xy_resample_row_c
+ **/
+static void xy_resample_row_sse2(short *dst, int dst_width, const DWORD *src,
+    const int *start, const short *weights, int taps)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32(1<<(RESAMPLE_WEIGHT_BITS-RESAMPLE_FRAC_BITS-1));
+    for (int i=0;i<dst_width;i++, weights+=taps, dst+=4)
+    {
+        const DWORD *p = src + start[i];
+        __m128i sum = zero;
+        for (int k=0;k<taps;k+=2)
+        {
+            //two neighbour pixels, interleaved as b0 b1 g0 g1 r0 r1 a0 a1
+            __m128i pix = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p+k)), zero);
+            pix = _mm_unpacklo_epi16(pix, _mm_srli_si128(pix, 8));
+            __m128i w = _mm_set1_epi32(*reinterpret_cast<const int*>(weights+k));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(pix, w));
+        }
+        sum = _mm_srai_epi32(_mm_add_epi32(sum, round), RESAMPLE_WEIGHT_BITS-RESAMPLE_FRAC_BITS);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm_packs_epi32(sum, sum));
+    }
+}
+
+/****
+ * See @xy_resample_column_c
+ * Constrain:
+ *   @rows MUST hold an even number of pixels, i.e. one more when @dst_width is odd
+ **/
+static void xy_resample_column_sse2(DWORD *dst, int dst_width, const short * const *rows,
+    const short *weights, int taps)
+{
+    const int SHIFT = RESAMPLE_WEIGHT_BITS+RESAMPLE_FRAC_BITS;
+    const __m128i round = _mm_set1_epi32(1<<(SHIFT-1));
+    for (int i=0;i<dst_width;i+=2)
+    {
+        __m128i sum_lo = _mm_setzero_si128();
+        __m128i sum_hi = _mm_setzero_si128();
+        for (int k=0;k<taps;k+=2)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k] + 4*i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k+1] + 4*i));
+            __m128i w = _mm_set1_epi32(*reinterpret_cast<const int*>(weights+k));
+            sum_lo = _mm_add_epi32(sum_lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), w));
+            sum_hi = _mm_add_epi32(sum_hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), w));
+        }
+        sum_lo = _mm_srai_epi32(_mm_add_epi32(sum_lo, round), SHIFT);
+        sum_hi = _mm_srai_epi32(_mm_add_epi32(sum_hi, round), SHIFT);
+        __m128i v = _mm_packs_epi32(sum_lo, sum_hi);
+        __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xff), 0xff);
+        v = _mm_min_epi16(v, alpha);
+        v = _mm_packus_epi16(v, v);
+        if (i+1<dst_width)
+        {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst+i), v);
+        }
+        else
+        {
+            dst[i] = _mm_cvtsi128_si32(v);
+        }
+    }
+}
+
+typedef void (*XyResampleRow)(short *dst, int dst_width, const DWORD *src,
+    const int *start, const short *weights, int taps);
+typedef void (*XyResampleColumn)(DWORD *dst, int dst_width, const short * const *rows,
+    const short *weights, int taps);
+
+/****
+ * See @xy_resample_argb
+ **/
+static bool xy_resample_argb_impl(DWORD *dst, int dst_width, int dst_height, int dst_stride,
+    int left, int top, int scaled_width, int scaled_height,
+    const DWORD *src, int width, int height, int stride, bool bicubic,
+    XyResampleRow resample_row, XyResampleColumn resample_column)
+{
+    if (dst_width<=0 || dst_height<=0 || width<=0 || height<=0)
+    {
+        return true;
+    }
+
+    std::vector<int> x_start, y_start;
+    std::vector<short> x_weights, y_weights;
+    int x_taps = xy_resample_taps(&x_start, &x_weights, left, dst_width, scaled_width, width, bicubic);
+    int y_taps = xy_resample_taps(&y_start, &y_weights, top, dst_height, scaled_height, height, bicubic);
+
+    //only the source rows under the output, filtered horizontally
+    int y0 = y_start[0];
+    int y1 = y_start[dst_height-1] + y_taps;
+    int h_stride = ((dst_width+1)&~1)*4;
+    short *h_buff = reinterpret_cast<short*>(xy_malloc((y1-y0)*h_stride*sizeof(short)));
+    int row_width = width>x_taps ? width : x_taps;
+    DWORD *row = reinterpret_cast<DWORD*>(xy_malloc(row_width*sizeof(DWORD)));
+    if (!h_buff || !row)
+    {
+        //both versions need the buffers, nothing to fall back to
+        xy_free(h_buff);
+        xy_free(row);
+        return false;
+    }
+    memset(h_buff, 0, (y1-y0)*h_stride*sizeof(short));
+    memset(row, 0, row_width*sizeof(DWORD));
+    for (int y=y0;y<y1 && y<height;y++)
+    {
+        const DWORD *s = reinterpret_cast<const DWORD*>(reinterpret_cast<const BYTE*>(src) + y*stride);
+        for (int x=0;x<width;x++)
+        {
+            DWORD a = s[x]>>24;
+            DWORD b = ((s[x]&0xff)*a + 127)/255;
+            DWORD g = (((s[x]>>8)&0xff)*a + 127)/255;
+            DWORD r = (((s[x]>>16)&0xff)*a + 127)/255;
+            row[x] = (a<<24) | (r<<16) | (g<<8) | b;
+        }
+        resample_row(h_buff + (y-y0)*h_stride, dst_width, row, &x_start[0], &x_weights[0], x_taps);
+    }
+    xy_free(row);
+
+    std::vector<const short*> rows(y_taps);
+    for (int i=0;i<dst_height;i++)
+    {
+        for (int k=0;k<y_taps;k++)
+        {
+            rows[k] = h_buff + (y_start[i]-y0+k)*h_stride;
+        }
+        resample_column(reinterpret_cast<DWORD*>(reinterpret_cast<BYTE*>(dst) + i*dst_stride), dst_width,
+            &rows[0], &y_weights[i*y_taps], y_taps);
+    }
+    xy_free(h_buff);
+    return true;
+}
+
+bool xy_resample_argb_c(DWORD *dst, int dst_width, int dst_height, int dst_stride,
+    int left, int top, int scaled_width, int scaled_height,
+    const DWORD *src, int width, int height, int stride, bool bicubic)
+{
+    return xy_resample_argb_impl(dst, dst_width, dst_height, dst_stride, left, top, scaled_width, scaled_height,
+        src, width, height, stride, bicubic, xy_resample_row_c, xy_resample_column_c);
+}
+
+bool xy_resample_argb_sse2(DWORD *dst, int dst_width, int dst_height, int dst_stride,
+    int left, int top, int scaled_width, int scaled_height,
+    const DWORD *src, int width, int height, int stride, bool bicubic)
+{
+    return xy_resample_argb_impl(dst, dst_width, dst_height, dst_stride, left, top, scaled_width, scaled_height,
+        src, width, height, stride, bicubic, xy_resample_row_sse2, xy_resample_column_sse2);
+}
+
+/****
+ * Separable resampling of 32 bits ARGB (alpha in the high byte, not premultiplied) into
+ * premultiplied ARGB. The filtering itself runs on premultiplied pixels, so transparent pixels
+ * do not bleed their color into their neighbours.
+ *   @src (@width x @height) is scaled to @scaled_width x @scaled_height, and the part
+ *   [@left, @left+@dst_width) x [@top, @top+@dst_height) of the scaled image is written to @dst.
+ *   @bicubic: Catmull-Rom instead of bilinear
+ * @return: false if the buffers of the filter can't be allocated, @dst is left as it is then
+ **/
+bool xy_resample_argb(DWORD *dst, int dst_width, int dst_height, int dst_stride,
+    int left, int top, int scaled_width, int scaled_height,
+    const DWORD *src, int width, int height, int stride, bool bicubic)
+{
+    if (g_cpuid.m_flags & CCpuID::sse2)
+    {
+        return xy_resample_argb_sse2(dst, dst_width, dst_height, dst_stride, left, top, scaled_width, scaled_height,
+            src, width, height, stride, bicubic);
+    }
+    else
+    {
+        return xy_resample_argb_c(dst, dst_width, dst_height, dst_stride, left, top, scaled_width, scaled_height,
+            src, width, height, stride, bicubic);
+    }
+}
@@ -130,7 +130,61 @@ void CWordPaintMachine::PaintOutline( const SharedPtrCWord& word, const CPointCo
 
 void CWordPaintMachine::PaintShadow( const SharedPtrCWord& word, const CPointCoor2& p, SharedPtrOverlay* overlay )
 {
-    PaintOutline(word, p, overlay);
+    CPoint outline_psub, shift;
+    if(overlay==NULL || !m_shadow_key || !GetShadowShift(word, p, &outline_psub, &shift))
+    {
+        PaintOutline(word, p, overlay);
+        return;
+    }
+    OverlayMruCache* overlay_cache = CacheManager::GetShadowOverlayCache();
+    POSITION pos = overlay_cache->Lookup(*m_shadow_key);
+    if(pos!=NULL)
+    {
+        *overlay = overlay_cache->GetAt(pos);
+        overlay_cache->UpdateCache( pos );
+        return;
+    }
+    //the outline overlay is very likely in the overlay cache already, or will be painted next anyway
+    SharedPtrOverlay outline;
+    PaintOutline(word, m_outline_pos, &outline);
+    Overlay *shifted = outline ? outline->GetSubpixelVariance(shift.x, shift.y) : NULL;
+    if(shifted==NULL)
+    {
+        PaintOutline(word, p, overlay);
+        return;
+    }
+    overlay->reset(shifted);
+    overlay_cache->UpdateCache(*m_shadow_key, *overlay);
+}
+
+/***
+ * The shadow is nothing but the outline put somewhere else. When it lands on another subpixel phase 
+ * than the outline, instead of rasterizing, widening and blurring it all over again, it is derived 
+ * from the outline overlay by a bilinear shift of @shift (in 1/8 pixel, 0~7). 
+ * The shift is only exact up to the interpolation, which does not show on blurred words. So it 
+ * is limited to them, where it saves most, and left to the bilinear mode which already does so.
+ *
+ * Note: With @shift masked to 0~7, the shifted overlay also moves its offset by -@shift, which puts 
+ *   it exactly where a shadow rasterized at its own phase would be, whatever the sign of the 
+ *   difference of the two phases.
+ **/
+bool CWordPaintMachine::GetShadowShift( const SharedPtrCWord& word, const CPointCoor2& p, CPoint *outline_psub, CPoint *shift )
+{
+    SubpixelPositionControler& controler = SubpixelPositionControler::GetGlobalControler();
+    if( controler.UseBilinearShift() || 
+        !Rasterizer::IsItReallyBlur(word->m_style.get().fBlur, word->m_style.get().fGaussianBlur) )
+    {
+        return false;
+    }
+    *outline_psub = controler.GetSubpixel(m_outline_pos);
+    CPoint shadow_psub = controler.GetSubpixel(p);
+    if (shadow_psub==*outline_psub)
+    {
+        return false;//same overlay, shared by the overlay cache
+    }
+    shift->x = (shadow_psub.x - outline_psub->x) & SubpixelPositionControler::EIGHT_X_EIGHT_MASK;
+    shift->y = (shadow_psub.y - outline_psub->y) & SubpixelPositionControler::EIGHT_X_EIGHT_MASK;
+    return true;
 }
 
 void CWordPaintMachine::CreatePaintMachines( const SharedPtrCWord& word
@@ -237,5 +291,15 @@ OverlayKey* CWordPaintMachine::CreateOutlineOverlayHashKey( const SharedPtrCWord
 
 OverlayKey* CWordPaintMachine::CreateShadowOverlayHashKey( const SharedPtrCWord& word, const CPointCoor2& p )
 {
-    return CreateOutlineOverlayHashKey(word, p);
+    OverlayKey *key = CreateOutlineOverlayHashKey(word, p);
+    CPoint outline_psub, shift;
+    if (key && GetShadowShift(word, p, &outline_psub, &shift))
+    {
+        //a shifted outline differs from a rasterized one: pack the phase of the outline and the 
+        //shift above the 3 bits of the subpixel position to keep them apart
+        key->m_p.x |= SHIFTED_SHADOW_KEY_FLAG | (outline_psub.x<<3) | (shift.x<<6);
+        key->m_p.y |= SHIFTED_SHADOW_KEY_FLAG | (outline_psub.y<<3) | (shift.y<<6);
+        key->UpdateHashValue();
+    }
+    return key;
 }
@@ -34,6 +34,8 @@ public:
     void Paint(LAYER layer, SharedPtrOverlay* overlay);
     const SharedPtrOverlayKey& GetHashKey(LAYER layer);
 private:
+    static const int SHIFTED_SHADOW_KEY_FLAG = 1<<9;
+
     CWordPaintMachine(){}
 
     void PaintBody(const SharedPtrCWord& word, const CPointCoor2& p, SharedPtrOverlay* overlay);
@@ -44,6 +46,8 @@ private:
     OverlayKey* CreateOutlineOverlayHashKey(const SharedPtrCWord& word, const CPointCoor2& p);
     OverlayKey* CreateShadowOverlayHashKey(const SharedPtrCWord& word, const CPointCoor2& p);
 
+    bool GetShadowShift(const SharedPtrCWord& word, const CPointCoor2& p, CPoint *outline_psub, CPoint *shift);
+
     SharedPtrCWord m_word;
     CPointCoor2 m_shadow_pos, m_outline_pos, m_body_pos;
     CPointCoor2 m_trans_org;
@@ -0,0 +1,92 @@
+#include "stdafx.h"
+#include "xy_render_timing.h"
+
+XyRenderTiming::Counters XyRenderTiming::s_counters[XyRenderTiming::STAGE_COUNT] = {0};
+__declspec(thread) int XyRenderTiming::s_cur_stage = -1;
+__declspec(thread) __int64 XyRenderTiming::s_cur_start = 0;
+
+static double GetUsPerTick()
+{
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    return 1000000.0/freq.QuadPart;
+}
+
+static const double s_us_per_tick = GetUsPerTick();
+
+__int64 XyRenderTiming::Now()
+{
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return now.QuadPart;
+}
+
+XyRenderTiming::Scope::Scope( int stage )
+{
+    ASSERT(stage>=0 && stage<RENDER_STAGE_END);
+    __int64 now = Now();
+    if (s_cur_stage>=0)
+    {
+        Charge(s_cur_stage, now - s_cur_start);
+    }
+    m_outer_stage = s_cur_stage;
+    s_cur_stage = stage;
+    s_cur_start = now;
+    s_counters[stage].calls++;
+}
+
+XyRenderTiming::Scope::~Scope()
+{
+    ASSERT(s_cur_stage>=0);
+    __int64 now = Now();
+    if (s_cur_stage>=0)
+    {
+        Charge(s_cur_stage, now - s_cur_start);
+    }
+    s_cur_stage = m_outer_stage;
+    s_cur_start = now;
+}
+
+XyRenderTiming::FlatScope::FlatScope( int stage ):m_stage(stage)
+{
+    ASSERT(stage>=0 && stage<STAGE_COUNT);
+    m_start = Now();
+    s_counters[stage].calls++;
+}
+
+XyRenderTiming::FlatScope::~FlatScope()
+{
+    Charge(m_stage, Now() - m_start);
+    EndFrame(m_stage, m_stage+1);
+}
+
+void XyRenderTiming::EndFrame( int first_stage, int end_stage )
+{
+    for (int i=first_stage;i<end_stage;i++)
+    {
+        Counters& c = s_counters[i];
+        c.last_frame = c.frame;
+        if (c.max_frame<c.frame)
+        {
+            c.max_frame = c.frame;
+        }
+        c.frame = 0;
+        c.frames++;
+    }
+}
+
+void XyRenderTiming::GetStageInfo( int stage, StageInfo *info )
+{
+    ASSERT(stage>=0 && stage<STAGE_COUNT && info);
+    const Counters& c = s_counters[stage];
+    info->total_us      = c.total*s_us_per_tick;
+    info->last_frame_us = c.last_frame*s_us_per_tick;
+    info->max_frame_us  = c.max_frame*s_us_per_tick;
+    info->calls         = c.calls;
+    info->frames        = c.frames;
+}
+
+void XyRenderTiming::Reset()
+{
+    memset(s_counters, 0, sizeof(s_counters));
+}
@@ -0,0 +1,91 @@
+#ifndef __XY_RENDER_TIMING_H_4E2B7A19_C65D_4F03_9A8E_1D5B3C70F2A6__
+#define __XY_RENDER_TIMING_H_4E2B7A19_C65D_4F03_9A8E_1D5B3C70F2A6__
+
+#include <WTypes.h>
+#include <cstddef>
+
+/****
+ * Always on, high resolution timing of the stages of the render pipeline.
+ *
+ * A Scope charges the time spent in it to its stage, minus the time spent in the Scopes nested 
+ * in it, so that the stages add up to the whole render time. Scopes are nested and are normally
+ * only used on the thread holding the renderer lock, the open stage is kept per thread anyway 
+ * so that a Scope opened elsewhere can't charge or close the stage of another thread. The alpha 
+ * blend runs outside of that lock, in the streaming thread of the host, and is timed with a 
+ * FlatScope instead, which makes up a whole frame of its stage.
+ *
+ * The counters are not locked: a reader may see a frame half updated, which is fine for stats.
+ **/
+class XyRenderTiming
+{
+public:
+    enum Stage//same order as DirectVobSubXyOptions::RenderStage
+    {
+        PARSE = 0,
+        PATH,
+        SCAN_CONVERT,
+        WIDEN,
+        RASTERIZE,
+        BLUR,
+        CLIP,
+        COMPOSITE,
+        RENDER_STAGE_END,
+        ALPHA_BLEND = RENDER_STAGE_END,
+        STAGE_COUNT
+    };
+
+    struct StageInfo
+    {
+        double total_us, last_frame_us, max_frame_us;
+        std::size_t calls, frames;
+    };
+
+    class Scope
+    {
+    public:
+        explicit Scope(int stage);
+        ~Scope();
+    private:
+        Scope(const Scope&);
+        void operator=(const Scope&);
+
+        int m_outer_stage;
+    };
+
+    class FlatScope
+    {
+    public:
+        explicit FlatScope(int stage);
+        ~FlatScope();
+    private:
+        FlatScope(const FlatScope&);
+        void operator=(const FlatScope&);
+
+        int m_stage;
+        __int64 m_start;
+    };
+
+    // Ends the current frame of the stages [@first_stage, @end_stage)
+    static void EndFrame(int first_stage, int end_stage);
+    static void GetStageInfo(int stage, StageInfo *info);
+    static void Reset();
+private:
+    struct Counters
+    {
+        __int64 total, frame, last_frame, max_frame;
+        std::size_t calls, frames;
+    };
+
+    static __int64 Now();
+    static void Charge(int stage, __int64 ticks)
+    {
+        s_counters[stage].total += ticks;
+        s_counters[stage].frame += ticks;
+    }
+
+    static Counters s_counters[STAGE_COUNT];
+    static __declspec(thread) int s_cur_stage;//innermost open Scope of this thread, -1 if none
+    static __declspec(thread) __int64 s_cur_start;
+};
+
+#endif // end of __XY_RENDER_TIMING_H_4E2B7A19_C65D_4F03_9A8E_1D5B3C70F2A6__
@@ -0,0 +1,133 @@
+#ifndef __XY_RLE_H_6F0A3C52_1D7E_4B8A_9E2C_8C41A7D3B590__
+#define __XY_RLE_H_6F0A3C52_1D7E_4B8A_9E2C_8C41A7D3B590__
+
+#include <vector>
+
+/****
+ * Simple run length coding of 2D images of T (BYTE or DWORD) used for the cold entries of the
+ * overlay and bitmap caches. Subtitle masks and bitmaps are mostly made of long runs of
+ * transparent (or fully covered) pixels, so this is cheap and compresses well.
+ *
+ * Every row is coded independently as a sequence of runs, each led by a 16 bits header:
+ *   header&REPEAT_FLAG: (header&MAX_RUN) copies of the single T that follows
+ *   else              : header literal Ts follow
+ **/
+class XyRle
+{
+public:
+    enum
+    {
+        REPEAT_FLAG = 0x8000,
+        MAX_RUN = 0x7FFF,
+        MIN_REPEAT = 3
+    };
+
+    template<typename T>
+    static void Encode(std::vector<BYTE> *output, const BYTE *src, int width, int height, int stride)
+    {
+        for (int i=0;i<height;i++, src+=stride)
+        {
+            const T *row = reinterpret_cast<const T*>(src);
+            int x = 0;
+            int literal_start = 0;
+            while (x<width)
+            {
+                int run_end = x+1;
+                while (run_end<width && row[run_end]==row[x] && run_end-x<MAX_RUN)
+                {
+                    run_end++;
+                }
+                if (run_end-x>=MIN_REPEAT)
+                {
+                    PutLiterals(output, row+literal_start, x-literal_start);
+                    PutHeader(output, REPEAT_FLAG|(run_end-x));
+                    Put(output, row+x, sizeof(T));
+                    x = run_end;
+                    literal_start = x;
+                }
+                else
+                {
+                    x = run_end;
+                }
+            }
+            PutLiterals(output, row+literal_start, width-literal_start);
+        }
+    }
+
+    // @return: the end of the decoded data, so that several images coded back to back can be 
+    //   decoded in turn, or NULL if @input is corrupted or does not match the given dimension
+    template<typename T>
+    static const BYTE* Decode(BYTE *dst, int width, int height, int stride, const BYTE *input, size_t size)
+    {
+        const BYTE *end = input + size;
+        for (int i=0;i<height;i++, dst+=stride)
+        {
+            T *row = reinterpret_cast<T*>(dst);
+            int x = 0;
+            while (x<width)
+            {
+                if (end-input<2)
+                {
+                    return NULL;
+                }
+                int header = input[0] | (input[1]<<8);
+                input += 2;
+                int count = header & MAX_RUN;
+                if (count==0 || count>width-x)
+                {
+                    return NULL;
+                }
+                if (header & REPEAT_FLAG)
+                {
+                    if (end-input<(int)sizeof(T))
+                    {
+                        return NULL;
+                    }
+                    T value;
+                    memcpy(&value, input, sizeof(T));
+                    input += sizeof(T);
+                    for (int j=0;j<count;j++)
+                    {
+                        row[x+j] = value;
+                    }
+                }
+                else
+                {
+                    if (end-input<(int)(count*sizeof(T)))
+                    {
+                        return NULL;
+                    }
+                    memcpy(row+x, input, count*sizeof(T));
+                    input += count*sizeof(T);
+                }
+                x += count;
+            }
+        }
+        return input;
+    }
+private:
+    static void PutHeader(std::vector<BYTE> *output, int header)
+    {
+        output->push_back(header&0xFF);
+        output->push_back(header>>8);
+    }
+    static void Put(std::vector<BYTE> *output, const void *data, size_t size)
+    {
+        const BYTE *p = reinterpret_cast<const BYTE*>(data);
+        output->insert(output->end(), p, p+size);
+    }
+    template<typename T>
+    static void PutLiterals(std::vector<BYTE> *output, const T *data, int count)
+    {
+        while (count>0)
+        {
+            int n = count<MAX_RUN ? count : MAX_RUN;
+            PutHeader(output, n);
+            Put(output, data, n*sizeof(T));
+            data += n;
+            count -= n;
+        }
+    }
+};
+
+#endif // end of __XY_RLE_H_6F0A3C52_1D7E_4B8A_9E2C_8C41A7D3B590__
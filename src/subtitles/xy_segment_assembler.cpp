@@ -0,0 +1,96 @@
+#include "stdafx.h"
+#include "xy_segment_assembler.h"
+
+XySegmentAssembler::XySegmentAssembler()
+    : m_input(NULL)
+    , m_input_size(0)
+    , m_buffer(NULL)
+    , m_buffer_size(0)
+    , m_pending_size(0)
+    , m_copied_bytes(0)
+{
+}
+
+XySegmentAssembler::~XySegmentAssembler()
+{
+    delete [] m_buffer;
+}
+
+void XySegmentAssembler::SetInput( BYTE *data, int size )
+{
+    ASSERT(m_input_size==0);//EndInput not called
+    m_input = data;
+    m_input_size = size>0 ? size : 0;
+}
+
+BYTE* XySegmentAssembler::Peek( int size )
+{
+    if (m_pending_size==0)
+    {
+        return m_input_size>=size ? m_input : NULL;
+    }
+    if (m_pending_size<size)
+    {
+        int copy_size = size-m_pending_size < m_input_size ? size-m_pending_size : m_input_size;
+        Reserve(m_pending_size + copy_size);
+        memcpy(m_buffer+m_pending_size, m_input, copy_size);
+        m_pending_size += copy_size;
+        m_input += copy_size;
+        m_input_size -= copy_size;
+        m_copied_bytes += copy_size;
+    }
+    return m_pending_size>=size ? m_buffer : NULL;
+}
+
+void XySegmentAssembler::Consume( int size )
+{
+    if (m_pending_size>0)
+    {
+        int from_buffer = size < m_pending_size ? size : m_pending_size;
+        memmove(m_buffer, m_buffer+from_buffer, m_pending_size-from_buffer);
+        m_pending_size -= from_buffer;
+        size -= from_buffer;
+    }
+    if (size>m_input_size)
+    {
+        size = m_input_size;
+    }
+    m_input += size;
+    m_input_size -= size;
+}
+
+void XySegmentAssembler::EndInput()
+{
+    if (m_input_size>0)
+    {
+        Reserve(m_pending_size + m_input_size);
+        memcpy(m_buffer+m_pending_size, m_input, m_input_size);
+        m_pending_size += m_input_size;
+        m_copied_bytes += m_input_size;
+    }
+    m_input = NULL;
+    m_input_size = 0;
+}
+
+void XySegmentAssembler::Reset()
+{
+    m_input = NULL;
+    m_input_size = 0;
+    m_pending_size = 0;
+}
+
+void XySegmentAssembler::Reserve( int size )
+{
+    if (size>m_buffer_size)
+    {
+        int new_size = 2*m_buffer_size > size ? 2*m_buffer_size : size;
+        BYTE *new_buffer = new BYTE[new_size];
+        if (m_pending_size>0)
+        {
+            memcpy(new_buffer, m_buffer, m_pending_size);
+        }
+        delete [] m_buffer;
+        m_buffer = new_buffer;
+        m_buffer_size = new_size;
+    }
+}
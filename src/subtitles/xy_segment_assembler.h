@@ -0,0 +1,44 @@
+#ifndef __XY_SEGMENT_ASSEMBLER_H_3B1E7C90_5A2D_4F86_8D4B_0E9C26A1F753__
+#define __XY_SEGMENT_ASSEMBLER_H_3B1E7C90_5A2D_4F86_8D4B_0E9C26A1F753__
+
+/****
+ * Gathers the segments of a bitmap subtitle stream (HDMV, DVB) out of the media samples.
+ *
+ * A segment lying entirely in one sample is handed out in place. Only the ones split over 
+ * several samples are copied, into a buffer reused from one segment to the next.
+ *
+ * Usage, for every sample:
+ *   SetInput(sample data);
+ *   while (p = Peek(header size)) { ...; if (!(p = Peek(segment size))) break; parse p; Consume(segment size); }
+ *   EndInput();//keeps what is left for the next sample
+ **/
+class XySegmentAssembler
+{
+public:
+    XySegmentAssembler();
+    ~XySegmentAssembler();
+
+    void SetInput(BYTE *data, int size);
+    // @return: the next @size bytes, or NULL if the input runs out before. 
+    //   Valid until the next call to any other member.
+    BYTE* Peek(int size);
+    void Consume(int size);
+    void EndInput();
+    void Reset();
+
+    int GetPendingSize() const { return m_pending_size; }
+    __int64 GetCopiedBytes() const { return m_copied_bytes; }
+private:
+    void Reserve(int size);
+
+    BYTE *m_input;
+    int m_input_size;
+
+    BYTE *m_buffer;
+    int m_buffer_size;
+    int m_pending_size;//bytes waiting in m_buffer, in front of m_input
+
+    __int64 m_copied_bytes;
+};
+
+#endif // __XY_SEGMENT_ASSEMBLER_H_3B1E7C90_5A2D_4F86_8D4B_0E9C26A1F753__
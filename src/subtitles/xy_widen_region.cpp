@@ -23,6 +23,13 @@ static const int MIN_CROSS_LINE = (-2147483647 - 1);
 static const int MAX_CROSS_LINE = 0x7fffffff;
 static const int MAX_X = 0x7fffffff;
 
+//auto selection of the dilation, see WidenRegionCreaterImpl::xy_overlap_region
+static const int DILATION_MIN_RADIUS = 4*8;
+static const int DILATION_MAX_RADIUS = 0xffff-2;//the distances of the dilation are WORDs saturated at radius+1
+static const int DILATION_COST_RATIO = 2;//measured: a cell of the dilation costs about 2 entries of the crossing table
+static const int DILATION_MAX_CELLS = 4*1024*1024;
+static const int DILATION_KEPT_CELLS = 256*1024;//larger distance buffers are freed after use
+
 typedef unsigned __int64 XY_POINT;
 #define  XY_POINT_X(point)               ((point)&0xffffffff)
 #define  XY_POINT_Y(point)               ((point)>>32)
@@ -86,6 +93,8 @@ private:
     void operator=(const XyEllipse&);
 };
 
+int gen_left_arc(int left_arc[], int rx, int ry);
+
 class WidenRegionCreaterImpl
 {
 public:
@@ -93,6 +102,9 @@ public:
     ~WidenRegionCreaterImpl();
 
     void xy_overlap_region(SpanBuffer* dst, const SpanBuffer& src, int rx, int ry);
+
+    void overlap_region_by_arc_sweep(SpanBuffer* dst, const SpanBuffer& src, int rx, int ry);
+    void overlap_region_by_dilation(SpanBuffer* dst, const SpanBuffer& src, int rx, int ry);
 private:
     int cross_left(const LinkArc& arc, XY_POINT center);//return <0 if arc(o)<inner_pl, MAX if arc(0)>inner_pl, else return cross_line
 
@@ -101,8 +113,15 @@ private:
     void add_span(LinkSpan* spans, const Span& span);
     void add_line(SpanBuffer* dst, LinkSpanList& spans, int cur_line, int dead_line);//add all line<dead_line to dst
 
+    int init_half_width(int rx, int ry);
 private:
     XyEllipse *m_ellipse;
+
+    //for dilation
+    std::vector<int> m_half_width;//m_half_width[d]: half width of the ellipse on line d from its center
+    int m_half_width_rx, m_half_width_ry;
+    std::vector<WORD> m_distance;
+    std::vector< std::pair<int,int> > m_runs;
 };
 
 //
@@ -132,11 +151,30 @@ void WidenRegionCreater::xy_overlap_region( SpanBuffer* dst, const SpanBuffer& s
     m_impl->xy_overlap_region(dst, src, rx, ry);
 }
 
+void WidenRegionCreater::xy_overlap_region( SpanBuffer* dst, const SpanBuffer& src, int rx, int ry, Method method )
+{
+    switch (method)
+    {
+    case ARC_SWEEP:
+        m_impl->overlap_region_by_arc_sweep(dst, src, rx, ry);
+        break;
+    case DILATION:
+        m_impl->overlap_region_by_dilation(dst, src, rx, ry);
+        break;
+    default:
+        m_impl->xy_overlap_region(dst, src, rx, ry);
+        break;
+    }
+}
+
 //
 // WidenRegionCreaterImpl
 // 
 
-WidenRegionCreaterImpl::WidenRegionCreaterImpl(): m_ellipse(NULL)
+WidenRegionCreaterImpl::WidenRegionCreaterImpl()
+    : m_ellipse(NULL)
+    , m_half_width_rx(-1)
+    , m_half_width_ry(-1)
 {
 }
 
@@ -146,6 +184,40 @@ WidenRegionCreaterImpl::~WidenRegionCreaterImpl()
 }
 
 void WidenRegionCreaterImpl::xy_overlap_region(SpanBuffer* dst, const SpanBuffer& src, int rx, int ry)
+{
+    if (src.empty())
+    {
+        return;
+    }
+    // Before sweeping, the crossing table of the ellipse, (2*rx+1)*(2*ry+1) entries, has to be built 
+    // for every new radius, e.g. on every frame of an animated \bord, while the dilation costs O(1) 
+    // per cell of the bounding box of the widened region, whatever the radius. 
+    // Large regions, e.g. full screen drawings, are left to the sweep, the dilation would need a 
+    // distance buffer of their whole bounding box.
+    // The sweep approximates the crossings of arcs, so the choice MUST only depend on @src and the 
+    // radius, not on whether the table is already built: an outline is then always widened the same 
+    // way, whatever was rendered before it.
+    if (ry >= DILATION_MIN_RADIUS && ry <= DILATION_MAX_RADIUS)
+    {
+        int min_x = MAX_X, max_x = 0;
+        for (SpanBuffer::const_iterator it=src.begin();it!=src.end();it++)
+        {
+            min_x = min(min_x, (int)XY_POINT_X(it->first));
+            max_x = max(max_x, (int)XY_POINT_X(it->second));
+        }
+        int height = XY_POINT_Y(src.back().first) - XY_POINT_Y(src.front().first) + 1 + 2*ry;
+        __int64 dilation_cost = (__int64)(max_x - min_x) * height;
+        __int64 ellipse_cost = (__int64)(2*rx+1) * (2*ry+1);
+        if (dilation_cost*DILATION_COST_RATIO < ellipse_cost && dilation_cost <= DILATION_MAX_CELLS)
+        {
+            overlap_region_by_dilation(dst, src, rx, ry);
+            return;
+        }
+    }
+    overlap_region_by_arc_sweep(dst, src, rx, ry);
+}
+
+void WidenRegionCreaterImpl::overlap_region_by_arc_sweep(SpanBuffer* dst, const SpanBuffer& src, int rx, int ry)
 {
     if (m_ellipse!=NULL && (m_ellipse->m_rx!=rx || m_ellipse->m_ry!=ry))
     {
@@ -232,6 +304,159 @@ void WidenRegionCreaterImpl::xy_overlap_region(SpanBuffer* dst, const SpanBuffer
     add_line(dst, link_span_list, dst_line, MAX_CROSS_LINE);
 }
 
+/***
+ * Dilation of the region by the same discrete ellipse as used by the arc sweep, in 2 separable passes:
+ *   1. for every column, the distance (in lines, saturated at ry+1) from every output line to the 
+ *      nearest line of the region in that column;
+ *   2. for every output line, each run of columns at distance d is widened by m_half_width[d].
+ * Since the half width of the ellipse never grows with d, the nearest line of a column is the only one
+ * that matters, which is what makes the dilation separable. 
+ * The output is the exact union of the ellipses centered on the cells of @src, in sorted and maximal 
+ * spans like the arc sweep, which may differ from it by a few cells where arcs cross.
+ **/
+void WidenRegionCreaterImpl::overlap_region_by_dilation(SpanBuffer* dst, const SpanBuffer& src, int rx, int ry)
+{
+    ASSERT(dst);
+    if (src.empty() || ry<0 || rx<0)
+    {
+        return;
+    }
+    if (ry>DILATION_MAX_RADIUS || init_half_width(rx, ry)<0)
+    {
+        overlap_region_by_arc_sweep(dst, src, rx, ry);
+        return;
+    }
+
+    int top = XY_POINT_Y(src.front().first) - ry;
+    int min_x = MAX_X, max_x = 0;
+    for (SpanBuffer::const_iterator it=src.begin();it!=src.end();it++)
+    {
+        min_x = min(min_x, (int)XY_POINT_X(it->first));
+        max_x = max(max_x, (int)XY_POINT_X(it->second));
+    }
+    const int width = max_x - min_x;
+    const int height = XY_POINT_Y(src.back().first) + ry + 1 - top;
+    if (width<=0)
+    {
+        return;
+    }
+    const WORD far_away = ry + 1;
+    m_distance.assign((std::size_t)width*height, far_away);
+    WORD *distance = &m_distance[0];
+
+    for (SpanBuffer::const_iterator it=src.begin();it!=src.end();it++)
+    {
+        int line = XY_POINT_Y(it->first) - top;
+        ASSERT(line>=ry && line<height-ry);
+        int left = XY_POINT_X(it->first) - min_x;
+        int right = XY_POINT_X(it->second) - min_x;
+        WORD *d = distance + line*width;
+        for (int x=left;x<right;x++)
+        {
+            d[x] = 0;
+        }
+    }
+    //the distance never exceeds @far_away: far_away+1 from the line before never wins
+    for (int y=1;y<height;y++)
+    {
+        WORD *d = distance + y*width;
+        const WORD *d_prev = d - width;
+        for (int x=0;x<width;x++)
+        {
+            WORD tmp = d_prev[x] + 1;
+            d[x] = tmp < d[x] ? tmp : d[x];
+        }
+    }
+    for (int y=height-2;y>=0;y--)
+    {
+        WORD *d = distance + y*width;
+        const WORD *d_next = d + width;
+        for (int x=0;x<width;x++)
+        {
+            WORD tmp = d_next[x] + 1;
+            d[x] = tmp < d[x] ? tmp : d[x];
+        }
+    }
+
+    const int *half_width = &m_half_width[0];
+    for (int y=0;y<height;y++)
+    {
+        const WORD *d = distance + y*width;
+        m_runs.clear();
+        int x = 0;
+        while (x<width)
+        {
+            WORD cur = d[x];
+            int run_start = x;
+            while (++x<width && d[x]==cur)
+                ;
+            if (cur<=ry)
+            {
+                m_runs.push_back( std::pair<int,int>(run_start - half_width[cur], x + half_width[cur]) );
+            }
+        }
+        if (m_runs.empty())
+        {
+            continue;
+        }
+        std::sort(m_runs.begin(), m_runs.end());
+
+        int line = top + y;
+        Span dst_span;
+        int left = m_runs[0].first, right = m_runs[0].second;
+        for (std::size_t i=1;i<m_runs.size();i++)
+        {
+            if (m_runs[i].first > right)
+            {
+                XY_POINT_SET(SPAN_LEFT(dst_span), left + min_x, line);
+                XY_POINT_SET(SPAN_RIGHT(dst_span), right + min_x, line);
+                dst->push_back(dst_span);
+                left = m_runs[i].first;
+                right = m_runs[i].second;
+            }
+            else if (m_runs[i].second > right)
+            {
+                right = m_runs[i].second;
+            }
+        }
+        XY_POINT_SET(SPAN_LEFT(dst_span), left + min_x, line);
+        XY_POINT_SET(SPAN_RIGHT(dst_span), right + min_x, line);
+        dst->push_back(dst_span);
+    }
+    if (m_distance.size()>DILATION_KEPT_CELLS)
+    {
+        std::vector<WORD>().swap(m_distance);
+    }
+}
+
+/***
+ * @return: <0 if the dilation can not reproduce the ellipse, i.e. its half width grows somewhere with 
+ *   the distance to the center (gen_left_arc has glitches on very narrow ellipses).
+ **/
+int WidenRegionCreaterImpl::init_half_width( int rx, int ry )
+{
+    if (rx!=m_half_width_rx || ry!=m_half_width_ry)
+    {
+        std::vector<int> left_arc(2*ry+2);
+        gen_left_arc(&left_arc[0], rx, ry);
+        m_half_width.resize(ry+1);
+        for (int d=0;d<=ry;d++)
+        {
+            m_half_width[d] = -left_arc[ry+d];
+        }
+        m_half_width_rx = rx;
+        m_half_width_ry = ry;
+    }
+    for (int d=1;d<=ry;d++)
+    {
+        if (m_half_width[d]>m_half_width[d-1])
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
 int WidenRegionCreaterImpl::cross_left(const LinkArc& arc, XY_POINT center)
 {
     ASSERT(!arc.empty());
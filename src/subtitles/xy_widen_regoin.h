@@ -7,10 +7,19 @@ class WidenRegionCreater
 public:
     typedef tSpanBuffer SpanBuffer;
 
+    enum Method
+    {
+        AUTO,
+        ARC_SWEEP,//sweeps the ellipse arcs along the spans, fast for small radii
+        DILATION  //separable dilation of the region, cost independent of the radius
+    };
 public:
     static WidenRegionCreater* GetDefaultWidenRegionCreater();
 
+    // Widen the region @src by an ellipse of radii @rx, @ry.
+    // The dilation is exact, the arc sweep may be off by a few cells where arcs cross.
     void xy_overlap_region(SpanBuffer* dst, const SpanBuffer& src, int rx, int ry);
+    void xy_overlap_region(SpanBuffer* dst, const SpanBuffer& src, int rx, int ry, Method method);
 private:
     WidenRegionCreater();
     ~WidenRegionCreater();
@@ -0,0 +1,456 @@
+/************************************************************************/
+/* Renders a subtitle script without any DirectShow graph or plugin     */
+/* host, and reports the per frame latency and the per stage timings.  */
+/************************************************************************/
+#include <afx.h>
+#include <afxwin.h>
+#include <streams.h>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+#include "RTS.h"
+#include "draw_item.h"
+#include "SimpleSubpicImpl.h"
+#include "xy_render_timing.h"
+
+using namespace std;
+
+enum Stage
+{
+    STAGE_PARSE = 0,
+    STAGE_RASTERIZE,
+    STAGE_COMPOSITE,
+    STAGE_BLEND,
+    STAGE_OUTPUT,
+    STAGE_COUNT
+};
+
+static const wchar_t *STAGE_NAMES[STAGE_COUNT] = {
+    L"parse", L"rasterize", L"composite", L"blend", L"output"
+};
+
+struct Options
+{
+    CString script;
+    CString output;//raw frames are written to this file, or dropped if empty
+    int spd_type;
+    int width, height;
+    double fps, start, end;
+    int loops;
+    int batch;//timestamps per RenderBatch call, 0 to render frame by frame with per stage timings
+
+    Options():spd_type(MSP_RGB32), width(1280), height(720), fps(25), start(0), end(60), loops(1), batch(0){}
+};
+
+class Timer
+{
+public:
+    Timer()
+    {
+        LARGE_INTEGER freq;
+        QueryPerformanceFrequency(&freq);
+        m_ms_per_tick = 1000.0/freq.QuadPart;
+        Restart();
+    }
+    void Restart()
+    {
+        QueryPerformanceCounter(&m_start);
+    }
+    // @return: the ms elapsed since the last restart, and restart
+    double Lap()
+    {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        double ms = (now.QuadPart - m_start.QuadPart)*m_ms_per_tick;
+        m_start = now;
+        return ms;
+    }
+private:
+    LARGE_INTEGER m_start;
+    double m_ms_per_tick;
+};
+
+/****
+ * The video frame the subtitles are blended into. It is cleared to black before every frame so
+ * that the output file is reproducible.
+ **/
+class Frame
+{
+public:
+    Frame(int spd_type, int width, int height):m_buffer(width*height*4)
+    {
+        spd.type = spd_type;
+        spd.w = width;
+        spd.h = height;
+        spd.vidrect = CRect(0, 0, width, height);
+        spd.bits = &m_buffer[0];
+        switch (spd_type)
+        {
+        case MSP_YUY2:
+            spd.bpp = 16;
+            spd.pitch = width*2;
+            m_size = spd.pitch*height;
+            break;
+        case MSP_YV12:
+            spd.bpp = 8;
+            spd.pitch = width;
+            spd.pitchUV = width/2;
+            spd.bitsV = &m_buffer[0] + width*height;
+            spd.bitsU = spd.bitsV + spd.pitchUV*(height/2);
+            m_size = width*height + 2*spd.pitchUV*(height/2);
+            break;
+        default:
+            spd.bpp = 32;
+            spd.pitch = width*4;
+            m_size = spd.pitch*height;
+            break;
+        }
+    }
+    void Clear()
+    {
+        switch (spd.type)
+        {
+        case MSP_YUY2:
+            for (int i=0;i<m_size;i+=2)
+            {
+                m_buffer[i] = 0x10;
+                m_buffer[i+1] = 0x80;
+            }
+            break;
+        case MSP_YV12:
+            memset(&m_buffer[0], 0x10, spd.w*spd.h);
+            memset(spd.bitsV, 0x80, m_size - spd.w*spd.h);
+            break;
+        default:
+            memset(&m_buffer[0], 0, m_size);
+            break;
+        }
+    }
+    bool Write(FILE *file)
+    {
+        return fwrite(&m_buffer[0], 1, m_size, file)==(size_t)m_size;
+    }
+public:
+    SubPicDesc spd;
+private:
+    vector<BYTE> m_buffer;
+    int m_size;
+};
+
+// The color space CRenderedTextSubtitle renders in for a target, the same as the AviSynth filters
+static int GetRenderType(int spd_type)
+{
+    switch (spd_type)
+    {
+    case MSP_YUY2:
+        return MSP_XY_AUYV;
+    case MSP_YV12:
+        return MSP_AYUV_PLANAR;
+    default:
+        return MSP_RGBA;
+    }
+}
+
+static bool ParseOptions(int argc, wchar_t **argv, Options *options)
+{
+    if (argc<2)
+    {
+        return false;
+    }
+    options->script = argv[1];
+    for (int i=2;i<argc;i++)
+    {
+        CString name = argv[i];
+        if (i+1>=argc)
+        {
+            return false;
+        }
+        const wchar_t *value = argv[++i];
+        if (name==L"-o")
+        {
+            options->output = value;
+        }
+        else if (name==L"-size")
+        {
+            if (swscanf_s(value, L"%dx%d", &options->width, &options->height)!=2
+                || options->width<=0 || options->height<=0)
+            {
+                return false;
+            }
+        }
+        else if (name==L"-format")
+        {
+            CString format = value;
+            format.MakeLower();
+            if (format==L"rgb32")
+            {
+                options->spd_type = MSP_RGB32;
+            }
+            else if (format==L"yuy2")
+            {
+                options->spd_type = MSP_YUY2;
+            }
+            else if (format==L"yv12")
+            {
+                options->spd_type = MSP_YV12;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        else if (name==L"-fps")
+        {
+            options->fps = _wtof(value);
+        }
+        else if (name==L"-start")
+        {
+            options->start = _wtof(value);
+        }
+        else if (name==L"-end")
+        {
+            options->end = _wtof(value);
+        }
+        else if (name==L"-loops")
+        {
+            options->loops = _wtoi(value);
+        }
+        else if (name==L"-batch")
+        {
+            options->batch = _wtoi(value);
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return options->fps>0 && options->loops>0 && options->batch>=0 && options->end>options->start
+        && (options->spd_type!=MSP_YV12 || (options->width%2==0 && options->height%2==0));
+}
+
+static void Usage(const wchar_t *name)
+{
+    wcout<<name<<L" script [-size 1280x720] [-format rgb32|yuy2|yv12] [-fps 25] [-start 0] [-end 60]"
+        L" [-loops 1] [-batch 0] [-o raw_output]"<<endl;
+}
+
+// @return: the ms spent in rendering and blending @sub_render_frame
+static double Blend(IXySubRenderFrame *sub_render_frame, Frame *frame, double stage_ms[STAGE_COUNT])
+{
+    Timer timer;
+    frame->Clear();
+    timer.Restart();
+    if (sub_render_frame)
+    {
+        CComPtr<ISimpleSubPic> subpic = new SimpleSubpic(sub_render_frame, frame->spd.type);
+        subpic->AlphaBlt(&frame->spd);
+    }
+    double ms = timer.Lap();
+    stage_ms[STAGE_BLEND] += ms;
+    return ms;
+}
+
+static bool Output(Frame *frame, FILE *file, double *frame_ms, double stage_ms[STAGE_COUNT])
+{
+    if (!file)
+    {
+        return true;
+    }
+    Timer timer;
+    bool ok = frame->Write(file);
+    double ms = timer.Lap();
+    stage_ms[STAGE_OUTPUT] += ms;
+    *frame_ms += ms;
+    return ok;
+}
+
+// Renders @rts one by one, every stage of CRenderedTextSubtitle::RenderEx timed on its own
+static bool RenderFrames(CRenderedTextSubtitle *rts, const Options& options, const vector<REFERENCE_TIME>& rts_list,
+    Frame *frame, FILE *file, vector<double> *frame_ms, double stage_ms[STAGE_COUNT])
+{
+    CSize size(options.width, options.height);
+    int render_type = GetRenderType(options.spd_type);
+    Timer timer;
+    for (size_t i=0;i<rts_list.size();i++)
+    {
+        double ms[STAGE_COUNT] = {0};
+        CComPtr<IXySubRenderFrame> sub_render_frame;
+        timer.Restart();
+        rts->SetupRender(render_type, size, size, frame->spd.vidrect);
+        CSubtitle2List sub2List;
+        HRESULT hr = rts->ParseScript(rts_list[i], options.fps, &sub2List);
+        ms[STAGE_PARSE] = timer.Lap();
+        if (hr==S_OK)
+        {
+            CompositeDrawItemListList compDrawItemListList;
+            CRenderedTextSubtitle::DoRender(size, sub2List, &compDrawItemListList);
+            ms[STAGE_RASTERIZE] = timer.Lap();
+
+            XySubRenderFrame *output;
+            CompositeDrawItem::Draw(&output, compDrawItemListList);
+            sub_render_frame = output;
+            ms[STAGE_COMPOSITE] = timer.Lap();
+        }
+        //as RenderEx does, so that the per frame max of the pipeline counters is kept
+        XyRenderTiming::EndFrame(0, XyRenderTiming::RENDER_STAGE_END);
+        double total = ms[STAGE_PARSE] + ms[STAGE_RASTERIZE] + ms[STAGE_COMPOSITE];
+        for (int j=0;j<STAGE_COUNT;j++)
+        {
+            stage_ms[j] += ms[j];
+        }
+        total += Blend(sub_render_frame, frame, stage_ms);
+        if (!Output(frame, file, &total, stage_ms))
+        {
+            return false;
+        }
+        frame_ms->push_back(total);
+    }
+    return true;
+}
+
+// Renders @rts through CRenderedTextSubtitle::RenderBatch, @options.batch timestamps at a time.
+// The render time of a batch is shared out evenly among its frames.
+static bool RenderBatches(CRenderedTextSubtitle *rts, const Options& options, const vector<REFERENCE_TIME>& rts_list,
+    Frame *frame, FILE *file, vector<double> *frame_ms, double stage_ms[STAGE_COUNT])
+{
+    CSize size(options.width, options.height);
+    int render_type = GetRenderType(options.spd_type);
+    vector<IXySubRenderFrame*> sub_render_frames(options.batch);
+    Timer timer;
+    for (size_t i=0;i<rts_list.size();i+=options.batch)
+    {
+        int count = (int)min((size_t)options.batch, rts_list.size()-i);
+        timer.Restart();
+        rts->RenderBatch(&sub_render_frames[0], &rts_list[i], count, render_type, size, size,
+            frame->spd.vidrect, options.fps);
+        double ms = timer.Lap();
+        stage_ms[STAGE_PARSE] += ms;
+
+        bool ok = true;
+        for (int j=0;j<count;j++)
+        {
+            double total = ms/count + Blend(sub_render_frames[j], frame, stage_ms);
+            ok = ok && Output(frame, file, &total, stage_ms);
+            frame_ms->push_back(total);
+            if (sub_render_frames[j])
+            {
+                sub_render_frames[j]->Release();
+            }
+        }
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static double Percentile(const vector<double>& sorted, double p)
+{
+    size_t i = (size_t)(p*sorted.size());
+    return sorted[min(i, sorted.size()-1)];
+}
+
+static void Report(const Options& options, double open_ms, vector<double>& frame_ms, double stage_ms[STAGE_COUNT])
+{
+    sort(frame_ms.begin(), frame_ms.end());
+    double total = 0;
+    for (size_t i=0;i<frame_ms.size();i++)
+    {
+        total += frame_ms[i];
+    }
+    wcout<<fixed<<setprecision(3);
+    wcout<<L"open: "<<open_ms<<L" ms"<<endl;
+    wcout<<L"frames: "<<frame_ms.size()<<L" total: "<<total<<L" ms"<<endl;
+    if (frame_ms.empty())
+    {
+        return;
+    }
+    wcout<<L"frame ms: mean "<<total/frame_ms.size()
+        <<L" p50 "<<Percentile(frame_ms, 0.5)
+        <<L" p90 "<<Percentile(frame_ms, 0.9)
+        <<L" p99 "<<Percentile(frame_ms, 0.99)
+        <<L" max "<<frame_ms.back()<<endl;
+    for (int i=0;i<STAGE_COUNT;i++)
+    {
+        if (options.batch>0 && (i==STAGE_RASTERIZE || i==STAGE_COMPOSITE))
+        {
+            continue;//included in the render of the batches
+        }
+        wcout<<(options.batch>0 && i==STAGE_PARSE ? L"render" : STAGE_NAMES[i])
+            <<L": "<<stage_ms[i]<<L" ms, "<<stage_ms[i]/frame_ms.size()<<L" ms/frame"<<endl;
+    }
+
+    static const wchar_t *pipeline_stage_names[XyRenderTiming::STAGE_COUNT] = {
+        L"parse", L"path", L"scan convert", L"widen", L"rasterize", L"blur", L"clip", L"composite", L"alpha blend"
+    };
+    wcout<<L"pipeline, self time:"<<endl;
+    for (int i=0;i<XyRenderTiming::STAGE_COUNT;i++)
+    {
+        XyRenderTiming::StageInfo info;
+        XyRenderTiming::GetStageInfo(i, &info);
+        wcout<<L"  "<<pipeline_stage_names[i]<<L": "<<info.total_us/1000<<L" ms, "<<info.calls<<L" calls, max "
+            <<info.max_frame_us/1000<<L" ms/frame"<<endl;
+    }
+}
+
+int wmain(int argc, wchar_t **argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, &options))
+    {
+        Usage(argv[0]);
+        return -1;
+    }
+
+    Timer timer;
+    CCritSec lock;
+    CRenderedTextSubtitle *rts = new CRenderedTextSubtitle(&lock);
+    if (!rts->Open(options.script, DEFAULT_CHARSET))
+    {
+        wcerr<<L"failed to open "<<(LPCWSTR)options.script<<endl;
+        delete rts;
+        return -1;
+    }
+    double open_ms = timer.Lap();
+
+    FILE *file = NULL;
+    if (!options.output.IsEmpty() && _wfopen_s(&file, options.output, L"wb")!=0)
+    {
+        wcerr<<L"failed to create "<<(LPCWSTR)options.output<<endl;
+        delete rts;
+        return -1;
+    }
+
+    vector<REFERENCE_TIME> rts_list;
+    for (int i=0;options.start+i/options.fps<options.end;i++)
+    {
+        rts_list.push_back((REFERENCE_TIME)((options.start+i/options.fps)*10000000));
+    }
+
+    Frame frame(options.spd_type, options.width, options.height);
+    vector<double> frame_ms;
+    double stage_ms[STAGE_COUNT] = {0};
+    bool ok = true;
+    for (int i=0;i<options.loops && ok;i++)
+    {
+        ok = options.batch>0 ?
+            RenderBatches(rts, options, rts_list, &frame, file, &frame_ms, stage_ms) :
+            RenderFrames(rts, options, rts_list, &frame, file, &frame_ms, stage_ms);
+    }
+    if (file)
+    {
+        fclose(file);
+    }
+    delete rts;
+    if (!ok)
+    {
+        wcerr<<L"failed to write "<<(LPCWSTR)options.output<<endl;
+        return -1;
+    }
+
+    Report(options, open_ms, frame_ms, stage_ms);
+    return 0;
+}
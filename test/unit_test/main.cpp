@@ -10,6 +10,14 @@
 
 //#include "test_xy_filter.h"
 //#include "xy_filter_benchmark.h"
+//#include "test_bilinear_shift.h"
+//#include "test_widen_region.h"
+//#include "test_segment_assembler.h"
+//#include "test_vobsub_decode.h"
+//#include "test_resample.h"
+//#include "test_script_reload.h"
+//#include "test_add_batch.h"
+//#include "test_animation_rate.h"
 #include "test_overall.h"
 
 
@@ -0,0 +1,87 @@
+#ifndef __TEST_ADD_BATCH_9D4A61C3_2E7B_4F08_B5A1_C86F3D27E904_H__
+#define __TEST_ADD_BATCH_9D4A61C3_2E7B_4F08_B5A1_C86F3D27E904_H__
+
+#include <gtest/gtest.h>
+#include <set>
+#include "STS.h"
+
+class BatchSubs : public CSimpleTextSubtitle
+{
+public:
+    int GetEntryCount() { return (int)m_entries.GetCount(); }
+    const STSEntry& GetEntry(int i) { return m_entries[i]; }
+    int GetSegmentCount() { return (int)m_segments.GetCount(); }
+};
+
+static STSEntry RandEntry(int max_time)
+{
+    STSEntry stse;
+    stse.str.Format(L"line %d", rand());
+    stse.fUnicode = true;
+    stse.style = _T("Default");
+    stse.marginRect = CRect(0,0,0,0);
+    stse.layer = rand()%3;
+    stse.start = rand()%max_time;
+    stse.end = stse.start + 1 + rand()%(max_time/4);
+    stse.readorder = -1;
+    return stse;
+}
+
+#define LOG_VAR(x) " "#x" "<<x<<" "
+
+TEST(AddBatchTest, segments_hold_every_overlapping_entry)
+{
+    for (int k=0;k<50;k++)
+    {
+        BatchSubs sts;
+        //the demuxer sends the first lines in order, one by one
+        for (int i=0;i<10;i++)
+        {
+            sts.Add(L"in order", true, 1000*i, 1000*i+500);
+        }
+        CAtlArray<STSEntry> batch;
+        int count = 8 + rand()%200;
+        for (int i=0;i<count;i++)
+        {
+            batch.Add(RandEntry(20000));
+        }
+        sts.AddBatch(batch);
+        ASSERT_EQ(10+count, sts.GetEntryCount())<<LOG_VAR(k);
+
+        std::set<int> boundaries;
+        for (int i=0;i<sts.GetEntryCount();i++)
+        {
+            boundaries.insert(sts.GetEntry(i).start);
+            boundaries.insert(sts.GetEntry(i).end);
+        }
+        int last_end = INT_MIN;
+        for (int i=0;i<sts.GetSegmentCount();i++)
+        {
+            const STSSegment *stss = sts.GetSegment(i);
+            ASSERT_LT(stss->start, stss->end)<<LOG_VAR(k)<<LOG_VAR(i);
+            ASSERT_LE(last_end, stss->start)<<LOG_VAR(k)<<LOG_VAR(i);
+            last_end = stss->end;
+            std::set<int> expected, subs;
+            for (int j=0;j<sts.GetEntryCount();j++)
+            {
+                if (sts.GetEntry(j).start<=stss->start && stss->end<=sts.GetEntry(j).end)
+                {
+                    expected.insert(j);
+                }
+                else
+                {
+                    ASSERT_TRUE(sts.GetEntry(j).end<=stss->start || stss->end<=sts.GetEntry(j).start)
+                        <<"segments MUST be split at every boundary"<<LOG_VAR(k)<<LOG_VAR(i)<<LOG_VAR(j);
+                }
+            }
+            for (size_t j=0;j<stss->subs.GetCount();j++)
+            {
+                subs.insert(stss->subs[j]);
+            }
+            ASSERT_FALSE(expected.empty())<<LOG_VAR(k)<<LOG_VAR(i);
+            ASSERT_TRUE(expected==subs)<<LOG_VAR(k)<<LOG_VAR(i);
+        }
+    }
+}
+
+#endif // __TEST_ADD_BATCH_9D4A61C3_2E7B_4F08_B5A1_C86F3D27E904_H__
@@ -1,8 +1,10 @@
 #ifndef __TEST_P010_ALPHABLEND_CBC6E4D7_E58B_4843_885D_80CEDB8C1709_H__
 #define __TEST_P010_ALPHABLEND_CBC6E4D7_E58B_4843_885D_80CEDB8C1709_H__
 
+#include <vector>
 #include "subpic_alphablend_test_data.h"
 #include "xy_intrinsics.h"
+#include "MemSubPic.h"
 
 TEST_F(AlphaBlendTest, CheckP010LumaSSE2)
 {
@@ -298,4 +300,80 @@ TEST_F(AlphaBlendTest, Check_hleft_vmid_mix_uv_p010)
     }    
 }
 
+// VobSub subpics come as RGBA from the legacy providers: blending one into a 10 bits YUV420P16
+// frame must match the YV12 blend of the same subpic, up to the rounding of the 8 bits values
+TEST_F(AlphaBlendTest, CheckRgbaYuv420P10VsYv12)
+{
+    const int w = 64, h = 32;
+    for (int k=0;k<100;k++)
+    {
+        std::vector<BYTE> rgba(w*h*4);
+        for (int i=0;i<w*h;i++)
+        {
+            //premultiplied, a quarter of the pixels left transparent
+            BYTE a = rand()%4==0 ? 0xff : rand()%256;
+            rgba[i*4+3] = a;
+            for (int c=0;c<3;c++)
+            {
+                rgba[i*4+c] = rand()%(256-a);
+            }
+        }
+        std::vector<BYTE> y8(w*h), u8(w*h/4), v8(w*h/4);
+        std::vector<WORD> y10(w*h), u10(w*h/4), v10(w*h/4);
+        for (int i=0;i<w*h;i++)
+        {
+            y8[i] = rand()%256;
+            y10[i] = y8[i]<<2;
+        }
+        for (int i=0;i<w*h/4;i++)
+        {
+            u8[i] = rand()%256;
+            v8[i] = rand()%256;
+            u10[i] = u8[i]<<2;
+            v10[i] = v8[i]<<2;
+        }
+        const std::vector<WORD> y10_org(y10);
+
+        SubPicDesc targets[2];
+        targets[0].type = MSP_YV12;
+        targets[0].w = w; targets[0].h = h; targets[0].bpp = 8;
+        targets[0].pitch = w; targets[0].pitchUV = w/2;
+        targets[0].bits = &y8[0]; targets[0].bitsU = &u8[0]; targets[0].bitsV = &v8[0];
+        targets[1].type = MSP_YUV420P16;
+        targets[1].w = w; targets[1].h = h; targets[1].bpp = 10;
+        targets[1].pitch = w*2; targets[1].pitchUV = w;
+        targets[1].bits = &y10[0];
+        targets[1].bitsU = reinterpret_cast<BYTE*>(&u10[0]); targets[1].bitsV = reinterpret_cast<BYTE*>(&v10[0]);
+
+        for (int t=0;t<2;t++)
+        {
+            SubPicDesc spd;
+            spd.type = MSP_RGBA;
+            spd.w = w; spd.h = h; spd.bpp = 32; spd.pitch = w*4;
+            spd.bits = new BYTE[w*h*4];//freed by CMemSubPic
+            memcpy(spd.bits, &rgba[0], w*h*4);
+            CComPtr<ISubPicEx> subpic = new CMemSubPic(spd, targets[t].type);
+            CAtlList<CRect> dirty;
+            dirty.AddTail(CRect(0,0,w,h));
+            ASSERT_EQ(S_OK, subpic->Unlock(&dirty))<<" t "<<t;
+            CRect rect(0,0,w,h);
+            ASSERT_EQ(S_OK, subpic->AlphaBlt(rect, rect, &targets[t]))<<" t "<<t;
+        }
+
+        for (int i=0;i<w*h;i++)
+        {
+            if (rgba[i*4+3]==0xff)
+            {
+                ASSERT_EQ(y10_org[i], y10[i])<<" k "<<k<<" i "<<i;
+            }
+            ASSERT_LE(abs(y10[i]-(y8[i]<<2)), 3)<<" k "<<k<<" i "<<i;
+        }
+        for (int i=0;i<w*h/4;i++)
+        {
+            ASSERT_LE(abs(u10[i]-(u8[i]<<2)), 5)<<" k "<<k<<" i "<<i;
+            ASSERT_LE(abs(v10[i]-(v8[i]<<2)), 5)<<" k "<<k<<" i "<<i;
+        }
+    }
+}
+
 #endif // __TEST_P010_ALPHABLEND_CBC6E4D7_E58B_4843_885D_80CEDB8C1709_H__
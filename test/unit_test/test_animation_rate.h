@@ -0,0 +1,101 @@
+#ifndef __TEST_ANIMATION_RATE_9D4B7E21_3F6A_4C08_B2E5_A81C05D6F937_H__
+#define __TEST_ANIMATION_RATE_9D4B7E21_3F6A_4C08_B2E5_A81C05D6F937_H__
+
+#include "test_script_reload.h"
+
+class AnimationRateTest : public ScriptReloadTest
+{
+public:
+    // a single animated line from 0 to 5 seconds
+    // @animation_rate: the "Animation Rate" of [Script Info], NULL to leave it out
+    void WriteScript(const char *animation_rate)
+    {
+        const char *lines[] = {"{\\move(0,0,100,100)}moving"};
+        CStringA script_info;
+        if (animation_rate)
+        {
+            script_info.Format("Animation Rate: %s", animation_rate);
+        }
+        ScriptReloadTest::WriteScript(lines, 1, 384, animation_rate ? (LPCSTR)script_info : NULL);
+    }
+};
+
+TEST_F(AnimationRateTest, script_info)
+{
+    CSimpleTextSubtitle sts;
+    WriteScript(NULL);
+    ASSERT_TRUE(sts.Open(path, DEFAULT_CHARSET));
+    ASSERT_EQ(-1, sts.m_animationRate)<<"not set: the user's option applies";
+
+    WriteScript("Exact");
+    ASSERT_TRUE(sts.Open(path, DEFAULT_CHARSET));
+    ASSERT_EQ(0, sts.m_animationRate);
+
+    WriteScript("24");
+    ASSERT_TRUE(sts.Open(path, DEFAULT_CHARSET));
+    ASSERT_EQ(24, sts.m_animationRate);
+
+    WriteScript(NULL);
+    ASSERT_TRUE(sts.Open(path, DEFAULT_CHARSET));
+    ASSERT_EQ(-1, sts.m_animationRate)<<"a removed rate MUST not outlive the reopen";
+}
+
+TEST_F(AnimationRateTest, rate_change_needs_full_open)
+{
+    WriteScript(NULL);
+    CRenderedTextSubtitle rts(&lock);
+    ASSERT_TRUE(rts.Open(path, DEFAULT_CHARSET));
+
+    WriteScript("exact");
+    REFERENCE_TIME rt = 0;
+    ASSERT_FALSE(rts.ReloadChanges(&rt));
+
+    ASSERT_EQ(S_OK, rts.Reload());
+    ASSERT_EQ(0, rts.m_animationRate);
+
+    //once reopened without the rate, the following edits reload incrementally again
+    WriteScript(NULL);
+    ASSERT_FALSE(rts.ReloadChanges(&rt));
+    ASSERT_EQ(S_OK, rts.Reload());
+    ASSERT_EQ(-1, rts.m_animationRate);
+    ASSERT_TRUE(rts.ReloadChanges(&rt));
+}
+
+TEST_F(AnimationRateTest, frames_shared_within_a_step)
+{
+    WriteScript(NULL);
+    CRenderedTextSubtitle rts(&lock);
+    ASSERT_TRUE(rts.Open(path, DEFAULT_CHARSET));
+    CSize size(384, 288);
+    CRect video_rect(CPoint(0,0), size);
+    const double fps = 100;
+    //the first two frames are in the step [1000,1100) of the cap, the last one in the next step
+    const REFERENCE_TIME times[] = {1050*10000i64, 1090*10000i64, 1100*10000i64};
+    IXySubRenderFrame* frames[3];
+
+    rts.m_maxAnimationRate = 10;
+    ASSERT_EQ(S_OK, rts.RenderBatch(frames, times, 3, MSP_RGBA, size, size, video_rect, fps));
+    ASSERT_TRUE(frames[0]!=NULL && frames[0]==frames[1]);
+    ASSERT_TRUE(frames[2]!=NULL && frames[2]!=frames[1]);
+    for (int i=0;i<3;i++)
+    {
+        frames[i]->Release();
+    }
+    POSITION pos = rts.GetStartPosition(times[0], fps);
+    ASSERT_EQ(1000*10000i64, rts.GetStart(pos, fps));
+    ASSERT_EQ(1100*10000i64, rts.GetStop(pos, fps));
+
+    //not capped: a frame per video frame
+    rts.m_maxAnimationRate = 0;
+    ASSERT_EQ(S_OK, rts.RenderBatch(frames, times, 3, MSP_RGBA, size, size, video_rect, fps));
+    ASSERT_TRUE(frames[0]!=frames[1] && frames[1]!=frames[2]);
+    for (int i=0;i<3;i++)
+    {
+        frames[i]->Release();
+    }
+    pos = rts.GetStartPosition(times[0], fps);
+    ASSERT_EQ(1050*10000i64, rts.GetStart(pos, fps));
+    ASSERT_EQ(1060*10000i64, rts.GetStop(pos, fps));
+}
+
+#endif // __TEST_ANIMATION_RATE_9D4B7E21_3F6A_4C08_B2E5_A81C05D6F937_H__
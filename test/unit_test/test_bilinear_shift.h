@@ -0,0 +1,114 @@
+#ifndef __TEST_BILINEAR_SHIFT_5C1E0A7B_3D0F_4B8C_9A6E_21F7C4D8B913_H__
+#define __TEST_BILINEAR_SHIFT_5C1E0A7B_3D0F_4B8C_9A6E_21F7C4D8B913_H__
+
+#include <gtest/gtest.h>
+#include <wtypes.h>
+#include "xy_malloc.h"
+
+typedef const UINT8 CUINT8, *PCUINT8;
+
+void xy_bilinear_shift_c(PUINT8 dst, int dst_width, int dst_height, int dst_stride, 
+    PCUINT8 src, int width, int height, int stride, int xshift, int yshift);
+void xy_bilinear_shift_sse2(PUINT8 dst, int dst_width, int dst_height, int dst_stride, 
+    PCUINT8 src, int width, int height, int stride, int xshift, int yshift);
+
+/****
+ * The old in place implementation of Overlay::GetSubpixelVariance, used as reference
+ **/
+static void BilinearShiftInPlace(unsigned char *buf, int w, int h, int stride, int x_factor, int y_factor)
+{
+    WORD *col_pix_buf = reinterpret_cast<WORD*>(xy_malloc(w*sizeof(WORD)));
+    memset(col_pix_buf, 0, w*sizeof(WORD));
+    for (int y = 0; y < h; y++)
+    {
+        unsigned char *src=buf+y*stride;
+        int last=0;
+        for(int x = 0; x < w; x++)
+        {
+            int temp1 = src[x];
+            int temp2 = temp1*x_factor;
+            temp1 <<= 3;
+            temp1 -= temp2;
+            temp1 += last;
+            last = temp2;
+
+            temp2 = temp1*y_factor;
+            temp1 <<= 3;
+            temp1 -= temp2;
+            temp1 += col_pix_buf[x];
+            src[x] = ((temp1+32)>>6);
+            col_pix_buf[x] = temp2;
+        }
+    }
+    xy_free(col_pix_buf);
+}
+
+class BilinearShiftTest : public ::testing::Test 
+{
+public:
+    PUINT8 src, ref, dst_c, dst_sse2;
+    int w, h, pitch;
+    int dst_w, dst_h, dst_pitch;
+protected:
+    virtual void SetUp() 
+    {
+        src = ref = dst_c = dst_sse2 = NULL;
+    }
+    virtual void TearDown()
+    {
+        xy_free(src);
+        xy_free(ref);
+        xy_free(dst_c);
+        xy_free(dst_sse2);
+        SetUp();
+    }
+    void FillRandData(int w, int h, int extra_w, int extra_h)
+    {
+        TearDown();
+        this->w = w;
+        this->h = h;
+        pitch = (w+15)&~15;
+        dst_w = w + extra_w;
+        dst_h = h + extra_h;
+        dst_pitch = (dst_w+15)&~15;
+
+        src = reinterpret_cast<PUINT8>(xy_malloc(pitch*h));
+        for (int i=0;i<pitch*h;i++)
+        {
+            src[i] = rand()&0xFF;
+        }
+        ref = reinterpret_cast<PUINT8>(xy_malloc(dst_pitch*dst_h));
+        dst_c = reinterpret_cast<PUINT8>(xy_malloc(dst_pitch*dst_h));
+        dst_sse2 = reinterpret_cast<PUINT8>(xy_malloc(dst_pitch*dst_h));
+        memset(ref, 0, dst_pitch*dst_h);
+        memset(dst_c, 0xcc, dst_pitch*dst_h);
+        memset(dst_sse2, 0xcc, dst_pitch*dst_h);
+        for (int i=0;i<h;i++)
+        {
+            memcpy(ref+i*dst_pitch, src+i*pitch, w);
+        }
+    }
+};
+
+#define LOG_VAR(x) " "#x" "<<x<<" "
+
+TEST_F(BilinearShiftTest, ref_vs_c_vs_sse2)
+{
+    for (int WIDTH=1;WIDTH<80;WIDTH++)
+    {
+        for (int i=0;i<8;i++)
+        {
+            int xshift = rand()&7, yshift = rand()&7;
+            FillRandData(WIDTH, 1+(rand()&15), rand()%3, rand()%3);
+            BilinearShiftInPlace(ref, dst_w, dst_h, dst_pitch, xshift, yshift);
+            xy_bilinear_shift_c(dst_c, dst_w, dst_h, dst_pitch, src, w, h, pitch, xshift, yshift);
+            xy_bilinear_shift_sse2(dst_sse2, dst_w, dst_h, dst_pitch, src, w, h, pitch, xshift, yshift);
+            ASSERT_EQ(0, memcmp(ref, dst_c, dst_pitch*dst_h))
+                <<LOG_VAR(WIDTH)<<LOG_VAR(h)<<LOG_VAR(dst_w)<<LOG_VAR(dst_h)<<LOG_VAR(xshift)<<LOG_VAR(yshift);
+            ASSERT_EQ(0, memcmp(ref, dst_sse2, dst_pitch*dst_h))
+                <<LOG_VAR(WIDTH)<<LOG_VAR(h)<<LOG_VAR(dst_w)<<LOG_VAR(dst_h)<<LOG_VAR(xshift)<<LOG_VAR(yshift);
+        }
+    }
+}
+
+#endif // __TEST_BILINEAR_SHIFT_5C1E0A7B_3D0F_4B8C_9A6E_21F7C4D8B913_H__
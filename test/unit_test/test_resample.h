@@ -0,0 +1,114 @@
+#ifndef __TEST_RESAMPLE_7E2B9D40_5A13_4C6F_8B07_E1D94A3C6F25_H__
+#define __TEST_RESAMPLE_7E2B9D40_5A13_4C6F_8B07_E1D94A3C6F25_H__
+
+#include <gtest/gtest.h>
+#include <wtypes.h>
+#include <vector>
+
+bool xy_resample_argb_c(DWORD *dst, int dst_width, int dst_height, int dst_stride,
+    int left, int top, int scaled_width, int scaled_height,
+    const DWORD *src, int width, int height, int stride, bool bicubic);
+bool xy_resample_argb_sse2(DWORD *dst, int dst_width, int dst_height, int dst_stride,
+    int left, int top, int scaled_width, int scaled_height,
+    const DWORD *src, int width, int height, int stride, bool bicubic);
+
+class ResampleTest : public ::testing::Test
+{
+public:
+    std::vector<DWORD> src;
+    int w, h;
+protected:
+    // Transparent holes and opaque strokes, like the pixels of a decoded VobSub
+    void FillRandData(int w, int h)
+    {
+        this->w = w;
+        this->h = h;
+        src.resize(w*h);
+        for (int i=0;i<w*h;i++)
+        {
+            DWORD alpha = rand()%3==0 ? 0 : (rand()%2 ? 0xff : rand()&0xff);
+            src[i] = (alpha<<24) | ((rand()&0xff)<<16) | ((rand()&0xff)<<8) | (rand()&0xff);
+        }
+    }
+    static DWORD Premultiply(DWORD c)
+    {
+        DWORD a = c>>24;
+        return (a<<24) | ((((c>>16)&0xff)*a+127)/255<<16) | ((((c>>8)&0xff)*a+127)/255<<8) | (((c&0xff)*a+127)/255);
+    }
+};
+
+#define LOG_VAR(x) " "#x" "<<x<<" "
+
+TEST_F(ResampleTest, c_vs_sse2)
+{
+    for (int i=0;i<2000;i++)
+    {
+        FillRandData(1+rand()%40, 1+rand()%40);
+        int scaled_w = 1+rand()%120, scaled_h = 1+rand()%120;
+        int left = rand()%scaled_w, top = rand()%scaled_h;
+        int dst_w = 1+rand()%(scaled_w-left), dst_h = 1+rand()%(scaled_h-top);
+        bool bicubic = (rand()&1)!=0;
+        std::vector<DWORD> dst_c(dst_w*dst_h, 0xcccccccc), dst_sse2(dst_w*dst_h, 0xcccccccc);
+        xy_resample_argb_c(&dst_c[0], dst_w, dst_h, dst_w*4, left, top, scaled_w, scaled_h, &src[0], w, h, w*4, bicubic);
+        xy_resample_argb_sse2(&dst_sse2[0], dst_w, dst_h, dst_w*4, left, top, scaled_w, scaled_h, &src[0], w, h, w*4, bicubic);
+        ASSERT_TRUE(dst_c==dst_sse2)<<LOG_VAR(i)<<LOG_VAR(w)<<LOG_VAR(h)<<LOG_VAR(scaled_w)<<LOG_VAR(scaled_h)<<LOG_VAR(bicubic);
+        for (int j=0;j<dst_w*dst_h;j++)
+        {
+            DWORD c = dst_c[j], a = c>>24;
+            ASSERT_TRUE(((c>>16)&0xff)<=a && ((c>>8)&0xff)<=a && (c&0xff)<=a)<<"MUST be premultiplied"<<LOG_VAR(i)<<LOG_VAR(j);
+        }
+    }
+}
+
+TEST_F(ResampleTest, same_size_is_a_copy)
+{
+    for (int i=0;i<100;i++)
+    {
+        FillRandData(1+rand()%60, 1+rand()%60);
+        for (int bicubic=0;bicubic<2;bicubic++)
+        {
+            std::vector<DWORD> dst(w*h);
+            xy_resample_argb_sse2(&dst[0], w, h, w*4, 0, 0, w, h, &src[0], w, h, w*4, bicubic!=0);
+            for (int j=0;j<w*h;j++)
+            {
+                ASSERT_EQ(Premultiply(src[j]), dst[j])<<LOG_VAR(i)<<LOG_VAR(j)<<LOG_VAR(bicubic);
+            }
+        }
+    }
+}
+
+TEST_F(ResampleTest, flat_color_stays_flat)
+{
+    FillRandData(30, 20);
+    for (int j=0;j<w*h;j++)
+    {
+        src[j] = 0xff4080c0;
+    }
+    int sizes[][2] = { {720, 480}, {3840, 2160}, {7, 5}, {31, 33} };
+    for (int i=0;i<(int)(sizeof(sizes)/sizeof(sizes[0]));i++)
+    {
+        for (int bicubic=0;bicubic<2;bicubic++)
+        {
+            int dst_w = sizes[i][0], dst_h = sizes[i][1];
+            std::vector<DWORD> dst(dst_w*dst_h);
+            xy_resample_argb_sse2(&dst[0], dst_w, dst_h, dst_w*4, 0, 0, dst_w, dst_h, &src[0], w, h, w*4, bicubic!=0);
+            for (int j=0;j<dst_w*dst_h;j++)
+            {
+                ASSERT_EQ(0xff4080c0, dst[j])<<LOG_VAR(dst_w)<<LOG_VAR(dst_h)<<LOG_VAR(j)<<LOG_VAR(bicubic);
+            }
+        }
+    }
+}
+
+TEST_F(ResampleTest, upscale_benchmark)
+{
+    FillRandData(720, 120);
+    std::vector<DWORD> dst(3840*640);
+    for (int i=0;i<20;i++)
+    {
+        xy_resample_argb_sse2(&dst[0], 3840, 640, 3840*4, 0, 0, 3840, 640, &src[0], w, h, w*4, (i&1)!=0);
+    }
+    ASSERT_EQ(0,0);
+}
+
+#endif // __TEST_RESAMPLE_7E2B9D40_5A13_4C6F_8B07_E1D94A3C6F25_H__
@@ -0,0 +1,91 @@
+#ifndef __TEST_SCRIPT_RELOAD_5C2E8A17_D4B3_4F69_8E0A_71B6C93F2D48_H__
+#define __TEST_SCRIPT_RELOAD_5C2E8A17_D4B3_4F69_8E0A_71B6C93F2D48_H__
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include "RTS.h"
+
+class ScriptReloadTest : public ::testing::Test
+{
+public:
+    CCritSec lock;
+    CString path;
+
+    // @script_info: an extra line of [Script Info], NULL for none
+    static const char* Header(int playres_x, const char *script_info = NULL)
+    {
+        static char header[1024];
+        sprintf_s(header, "[Script Info]\nScriptType: v4.00+\nPlayResX: %d\nPlayResY: 288\n%s%s\n"
+            "[V4+ Styles]\nFormat: Name, Fontname, Fontsize, PrimaryColour, SecondaryColour, OutlineColour, "
+            "BackColour, Bold, Italic, Underline, StrikeOut, ScaleX, ScaleY, Spacing, Angle, BorderStyle, "
+            "Outline, Shadow, Alignment, MarginL, MarginR, MarginV, Encoding\n"
+            "Style: Default,Arial,20,&H00FFFFFF,&H000000FF,&H00000000,&H00000000,0,0,0,0,100,100,0,0,1,2,2,2,10,10,10,1\n\n"
+            "[Events]\nFormat: Layer, Start, End, Style, Name, MarginL, MarginR, MarginV, Effect, Text\n", 
+            playres_x, script_info ? script_info : "", script_info ? "\n" : "");
+        return header;
+    }
+
+    // @lines: the text of the lines, line i is shown from 10*i to 10*i+5 seconds
+    void WriteScript(const char *lines[], int count, int playres_x = 384, const char *script_info = NULL)
+    {
+        FILE *f = NULL;
+        ASSERT_EQ(0, _tfopen_s(&f, path, _T("w")));
+        fputs(Header(playres_x, script_info), f);
+        for (int i=0;i<count;i++)
+        {
+            fprintf(f, "Dialogue: 0,0:00:%02d.00,0:00:%02d.00,Default,,0,0,0,,%s\n", 10*i, 10*i+5, lines[i]);
+        }
+        fclose(f);
+    }
+protected:
+    virtual void SetUp()
+    {
+        TCHAR dir[MAX_PATH], fn[MAX_PATH];
+        GetTempPath(MAX_PATH, dir);
+        GetTempFileName(dir, _T("rld"), 0, fn);
+        path = fn;
+    }
+    virtual void TearDown()
+    {
+        DeleteFile(path);
+    }
+};
+
+TEST_F(ScriptReloadTest, invalidate_from_first_edited_line)
+{
+    const char *lines[] = {"zero", "one", "two", "three", "four"};
+    WriteScript(lines, 5);
+    CRenderedTextSubtitle rts(&lock);
+    ASSERT_TRUE(rts.Open(path, DEFAULT_CHARSET));
+
+    REFERENCE_TIME rt = 0;
+    ASSERT_TRUE(rts.ReloadChanges(&rt));
+    ASSERT_EQ(_I64_MAX, rt)<<"nothing changed, nothing to invalidate";
+
+    lines[3] = "three, edited";
+    WriteScript(lines, 5);
+    ASSERT_TRUE(rts.ReloadChanges(&rt));
+    ASSERT_EQ(30*10000000i64, rt);
+
+    //the lines after a removed one are kept as long as their timing did not change
+    lines[1] = "";
+    WriteScript(lines, 5);
+    ASSERT_TRUE(rts.ReloadChanges(&rt));
+    ASSERT_EQ(10*10000000i64, rt);
+}
+
+TEST_F(ScriptReloadTest, header_change_needs_full_open)
+{
+    const char *lines[] = {"zero", "one"};
+    WriteScript(lines, 2);
+    CRenderedTextSubtitle rts(&lock);
+    ASSERT_TRUE(rts.Open(path, DEFAULT_CHARSET));
+
+    WriteScript(lines, 2, 640);
+    REFERENCE_TIME rt = 0;
+    ASSERT_FALSE(rts.ReloadChanges(&rt));
+    ASSERT_EQ(S_OK, rts.Reload());
+    ASSERT_EQ(640, rts.m_dstScreenSize.cx);
+}
+
+#endif // __TEST_SCRIPT_RELOAD_5C2E8A17_D4B3_4F69_8E0A_71B6C93F2D48_H__
@@ -0,0 +1,113 @@
+#ifndef __TEST_SEGMENT_ASSEMBLER_5C08E2A7_93D4_4B61_A0F2_7E3B1C6D9A84_H__
+#define __TEST_SEGMENT_ASSEMBLER_5C08E2A7_93D4_4B61_A0F2_7E3B1C6D9A84_H__
+
+#include <gtest/gtest.h>
+#include <vector>
+#include "xy_segment_assembler.h"
+
+class SegmentAssemblerTest : public ::testing::Test
+{
+public:
+    typedef std::vector<BYTE> Segment;
+
+    std::vector<Segment> segments;
+    std::vector<BYTE> stream;
+protected:
+    // HDMV like segments: type, 16 bits big endian size, payload
+    void FillRandSegments(int count, int max_size)
+    {
+        segments.clear();
+        stream.clear();
+        for (int i=0;i<count;i++)
+        {
+            int size = rand()%(max_size+1);
+            Segment segment(3+size);
+            segment[0] = (BYTE)(0x14 + rand()%4);
+            segment[1] = (BYTE)(size>>8);
+            segment[2] = (BYTE)(size&0xff);
+            for (int j=0;j<size;j++)
+            {
+                segment[3+j] = (BYTE)rand();
+            }
+            segments.push_back(segment);
+            stream.insert(stream.end(), segment.begin(), segment.end());
+        }
+    }
+
+    // Stand-in for the samples of a demuxer: feeds @stream cut at @cuts
+    void Parse(XySegmentAssembler *assembler, const std::vector<int>& cuts, std::vector<Segment> *output)
+    {
+        output->clear();
+        int start = 0;
+        for (std::size_t i=0;i<=cuts.size();i++)
+        {
+            int end = i<cuts.size() ? cuts[i] : (int)stream.size();
+            assembler->SetInput(stream.empty() ? NULL : &stream[0] + start, end-start);
+            BYTE *header = NULL;
+            while ((header = assembler->Peek(3)) != NULL)
+            {
+                int size = 3 + ((header[1]<<8)|header[2]);
+                BYTE *segment = assembler->Peek(size);
+                if (!segment)
+                {
+                    break;
+                }
+                output->push_back(Segment(segment, segment+size));
+                assembler->Consume(size);
+            }
+            assembler->EndInput();
+            start = end;
+        }
+    }
+};
+
+#define LOG_VAR(x) " "#x" "<<x<<" "
+
+TEST_F(SegmentAssemblerTest, split_segments)
+{
+    for (int i=0;i<200;i++)
+    {
+        FillRandSegments(1+rand()%20, rand()%2 ? 64 : 3000);
+        std::vector<int> cuts;
+        int pos = 0;
+        while (true)
+        {
+            pos += 1 + rand()%(rand()%2 ? 8 : 2000);
+            if (pos>=(int)stream.size())
+            {
+                break;
+            }
+            cuts.push_back(pos);
+        }
+        XySegmentAssembler assembler;
+        std::vector<Segment> output;
+        Parse(&assembler, cuts, &output);
+        ASSERT_TRUE(output==segments)<<LOG_VAR(i)<<LOG_VAR(output.size())<<LOG_VAR(segments.size());
+        ASSERT_TRUE(assembler.GetPendingSize()==0)<<LOG_VAR(i);
+    }
+}
+
+TEST_F(SegmentAssemblerTest, whole_segments_are_not_copied)
+{
+    for (int i=0;i<50;i++)
+    {
+        FillRandSegments(1+rand()%20, 3000);
+        std::vector<int> cuts;
+        int pos = 0;
+        for (std::size_t j=0;j+1<segments.size();j++)
+        {
+            pos += (int)segments[j].size();
+            if (rand()%2)
+            {
+                cuts.push_back(pos);
+            }
+        }
+        XySegmentAssembler assembler;
+        std::vector<Segment> output;
+        Parse(&assembler, cuts, &output);
+        ASSERT_TRUE(output==segments)<<LOG_VAR(i);
+        ASSERT_TRUE(assembler.GetCopiedBytes()==0)<<LOG_VAR(i)<<LOG_VAR(assembler.GetCopiedBytes());
+    }
+}
+
+#endif // __TEST_SEGMENT_ASSEMBLER_5C08E2A7_93D4_4B61_A0F2_7E3B1C6D9A84_H__
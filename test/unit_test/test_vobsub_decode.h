@@ -0,0 +1,215 @@
+#ifndef __TEST_VOBSUB_DECODE_3B9E1F07_6A2C_4D85_B0E4_9C7D52A1F638_H__
+#define __TEST_VOBSUB_DECODE_3B9E1F07_6A2C_4D85_B0E4_9C7D52A1F638_H__
+
+#include <gtest/gtest.h>
+#include <vector>
+#include "VobSubFile.h"
+#include "STS.h"
+
+/****
+ * Gives access to the packets of a VobSub, 31.idx/31.sub of the test scripts
+ **/
+class VobSubPackets : public CVobSubFile
+{
+public:
+    typedef std::vector<BYTE> Packet;
+
+    VobSubPackets():CVobSubFile(NULL){}
+
+    bool Load(LPCTSTR fn, std::vector<Packet> *packets)
+    {
+        if (!Open(fn) || m_iLang<0)
+        {
+            return false;
+        }
+        packets->clear();
+        for (int i=0;i<(int)m_langs[m_iLang].subpos.GetCount();i++)
+        {
+            int packetsize = 0, datasize = 0;
+            CAutoVectorPtr<BYTE> buff;
+            buff.Attach(GetPacket(i, packetsize, datasize));
+            if (buff)
+            {
+                packets->push_back(Packet(buff.m_p, buff.m_p+packetsize));
+            }
+        }
+        return !packets->empty();
+    }
+};
+
+class VobSubDecodeTest : public ::testing::Test
+{
+public:
+    std::vector<VobSubPackets::Packet> packets;
+    RGBQUAD orgpal[16], cuspal[4];
+
+    // The old nibble at a time decoder, used as reference: 2 bits color indices of the whole
+    // rect, @return the number of lines decoded
+    static int RefDecode(std::vector<BYTE> *idx, const BYTE *data, int datasize,
+        int w, int h, int offset0, int offset1)
+    {
+        idx->assign(w*h, 0);
+        int end[2] = {offset1, datasize};
+        if (offset0>offset1)
+        {
+            end[0] = datasize;
+            end[1] = offset0;
+        }
+        int offset[2] = {offset0, offset1};
+        int plane = 0, aligned = 1, x = 0, y = 0;
+        while (offset[plane]<end[plane])
+        {
+            int code = 0, n = 0;
+            for (;n<4;n++)
+            {
+                code = (code<<4) | ((data[offset[plane]]>>(aligned<<2))&0xf);
+                aligned = !aligned;
+                offset[plane] += aligned;
+                if (code>=(0x4<<(2*n)))
+                {
+                    break;
+                }
+            }
+            int run = n==4 ? w-x : min(code>>2, w-x);//16 bits codes with a run < 64 fill the line
+            for (int i=0;i<run && y<h;i++)
+            {
+                (*idx)[y*w+x+i] = code&3;
+            }
+            x += run;
+            if (x>=w)
+            {
+                if (!aligned)
+                {
+                    aligned = 1;
+                    offset[plane]++;
+                }
+                x = 0;
+                y++;
+                plane = 1-plane;
+            }
+        }
+        return y;
+    }
+protected:
+    virtual void SetUp()
+    {
+        VobSubPackets vobsub;
+        ASSERT_TRUE(vobsub.Load(_T("31.idx"), &packets));
+        for (int i=0;i<16;i++)
+        {
+            orgpal[i].rgbRed = (BYTE)(i*16);
+            orgpal[i].rgbGreen = (BYTE)(255-i*16);
+            orgpal[i].rgbBlue = (BYTE)(i*7);
+            orgpal[i].rgbReserved = 0;
+        }
+        memset(cuspal, 0, sizeof(cuspal));
+    }
+};
+
+#define LOG_VAR(x) " "#x" "<<x<<" "
+
+TEST_F(VobSubDecodeTest, decode_vs_reference)
+{
+    for (std::size_t k=0;k<packets.size();k++)
+    {
+        BYTE *data = &packets[k][0];
+        int packetsize = (int)packets[k].size(), datasize = (data[2]<<8)|data[3];
+
+        CVobSubImage img;
+        WORD offsets[2] = {0, 0};
+        img.GetPacketInfo(data, packetsize, datasize, offsets);
+        CRect full = img.rect;
+        ASSERT_TRUE(img.Decode(data, packetsize, datasize, false, 0, orgpal, cuspal, true))<<LOG_VAR(k);
+
+        std::vector<BYTE> idx;
+        int lines = min(RefDecode(&idx, data, datasize, full.Width(), full.Height(), offsets[0], offsets[1]),
+            full.Height());
+
+        // trimmed to the visible pixels of the decoded lines, plus a 1 pixel border
+        CRect expected(full.left, full.top, full.right, full.top+lines);
+        CRect visible(INT_MAX, INT_MAX, INT_MIN, INT_MIN);
+        for (int y=0;y<expected.Height();y++)
+        {
+            for (int x=0;x<full.Width();x++)
+            {
+                if (img.pal[idx[y*full.Width()+x]].tr!=0)
+                {
+                    visible.left = min((int)visible.left, x);
+                    visible.top = min((int)visible.top, y);
+                    visible.right = max((int)visible.right, x+1);
+                    visible.bottom = max((int)visible.bottom, y+1);
+                }
+            }
+        }
+        if (visible.left<visible.right)
+        {
+            expected = visible + full.TopLeft();
+            expected.InflateRect(1, 1);
+        }
+        ASSERT_TRUE(img.rect==expected)<<LOG_VAR(k)<<LOG_VAR(img.rect.top)<<LOG_VAR(img.rect.bottom)
+            <<LOG_VAR(expected.top)<<LOG_VAR(expected.bottom);
+
+        for (int y=img.rect.top;y<img.rect.bottom;y++)
+        {
+            for (int x=img.rect.left;x<img.rect.right;x++)
+            {
+                RGBQUAD c = {0,0,0,0};
+                if (y>=full.top && y<full.top+lines && x>=full.left && x<full.right)
+                {
+                    int i = idx[(y-full.top)*full.Width()+x-full.left];
+                    c = orgpal[img.pal[i].pal];
+                    c.rgbReserved = (img.pal[i].tr<<4)|img.pal[i].tr;
+                }
+                const RGBQUAD &p = img.lpPixels[(y-img.rect.top)*img.rect.Width()+x-img.rect.left];
+                if (c.rgbReserved==0)
+                {
+                    ASSERT_EQ(0, p.rgbReserved)<<LOG_VAR(k)<<LOG_VAR(x)<<LOG_VAR(y);
+                }
+                else
+                {
+                    ASSERT_EQ(*(DWORD*)&c, *(DWORD*)&p)<<LOG_VAR(k)<<LOG_VAR(x)<<LOG_VAR(y);
+                }
+            }
+        }
+    }
+}
+
+TEST_F(VobSubDecodeTest, decode_benchmark)
+{
+    CVobSubImage img;
+    for (int i=0;i<2000;i++)
+    {
+        for (std::size_t k=0;k<packets.size();k++)
+        {
+            BYTE *data = &packets[k][0];
+            img.Decode(data, (int)packets[k].size(), (data[2]<<8)|data[3], false, 0, orgpal, cuspal, true);
+        }
+    }
+    ASSERT_EQ(0,0);
+}
+
+class PolygonizedSubs : public CSimpleTextSubtitle
+{
+public:
+    int GetEntryCount() { return (int)m_entries.GetCount(); }
+    const STSEntry& GetEntry(int i) { return m_entries[i]; }
+};
+
+TEST(VobSubPolygonizeTest, same_output_on_any_thread_count)
+{
+    VobSubPackets vobsub;
+    ASSERT_TRUE(vobsub.Open(_T("31.idx")));
+    PolygonizedSubs one, many;
+    ASSERT_TRUE(vobsub.Polygonize(one, -1, true, 3, 1));
+    ASSERT_TRUE(vobsub.Polygonize(many, -1, true, 3, 8));
+    ASSERT_GT(one.GetEntryCount(), 0);
+    ASSERT_EQ(one.GetEntryCount(), many.GetEntryCount());
+    for (int i=0;i<one.GetEntryCount();i++)
+    {
+        ASSERT_EQ(one.GetEntry(i).start, many.GetEntry(i).start)<<LOG_VAR(i);
+        ASSERT_EQ(one.GetEntry(i).end, many.GetEntry(i).end)<<LOG_VAR(i);
+        ASSERT_TRUE(one.GetEntry(i).str==many.GetEntry(i).str)<<LOG_VAR(i);
+    }
+}
+
+#endif // __TEST_VOBSUB_DECODE_3B9E1F07_6A2C_4D85_B0E4_9C7D52A1F638_H__
@@ -0,0 +1,174 @@
+#ifndef __TEST_WIDEN_REGION_8A2F4C61_0B7D_4E3A_A5C9_6D13E7F0B24C_H__
+#define __TEST_WIDEN_REGION_8A2F4C61_0B7D_4E3A_A5C9_6D13E7F0B24C_H__
+
+#include <gtest/gtest.h>
+#include <vector>
+#include <set>
+#include "Rasterizer.h"
+#include "xy_widen_regoin.h"
+
+int gen_left_arc(int left_arc[], int rx, int ry);
+
+class WidenRegionTest : public ::testing::Test
+{
+public:
+    typedef std::set< std::pair<int,int> > Cells;//(line, x)
+
+    static const unsigned __int64 SPAN_BIAS = 0x4000000040000000i64;
+
+    tSpanBuffer src;
+protected:
+    // Random discs, bars and rings, scan converted into sorted spans like ScanLineData::mOutline
+    void FillRandShapes(int w, int h)
+    {
+        std::vector<char> mask(w*h, 0);
+        int shape_count = 1 + rand()%8;
+        for (int k=0;k<shape_count;k++)
+        {
+            int cx = rand()%w, cy = rand()%h, r = 1 + rand()%(w/3+1), type = rand()%3;
+            for (int y=max(0,cy-r);y<min(h,cy+r);y++)
+            {
+                for (int x=max(0,cx-r);x<min(w,cx+r);x++)
+                {
+                    int d2 = (x-cx)*(x-cx) + (y-cy)*(y-cy);
+                    if ( (type==0 && d2<r*r) || (type==1 && abs(x-cx)<=r/4) || (type==2 && d2<r*r && 2*d2>r*r) )
+                    {
+                        mask[y*w+x] = 1;
+                    }
+                }
+            }
+        }
+        src.clear();
+        for (int y=0;y<h;y++)
+        {
+            int x = 0;
+            while (x<w)
+            {
+                if (!mask[y*w+x])
+                {
+                    x++;
+                    continue;
+                }
+                int left = x;
+                while (x<w && mask[y*w+x])
+                {
+                    x++;
+                }
+                src.push_back(tSpan( SPAN_BIAS + ((unsigned __int64)y<<32) + left, SPAN_BIAS + ((unsigned __int64)y<<32) + x ));
+            }
+        }
+    }
+
+    // @return: false if some cell is covered twice
+    static bool ToCells(const tSpanBuffer& spans, Cells *cells)
+    {
+        cells->clear();
+        for (tSpanBuffer::const_iterator it=spans.begin();it!=spans.end();it++)
+        {
+            int line = (int)(it->first>>32);
+            for (int x=(int)(it->first&0xffffffff);x<(int)(it->second&0xffffffff);x++)
+            {
+                if (!cells->insert(std::pair<int,int>(line, x)).second)
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Union of the ellipses centered on every cell of @src
+    void BruteForceWiden(Cells *cells, int rx, int ry)
+    {
+        std::vector<int> left_arc(2*ry+2);
+        gen_left_arc(&left_arc[0], rx, ry);
+        cells->clear();
+        for (tSpanBuffer::const_iterator it=src.begin();it!=src.end();it++)
+        {
+            int line = (int)(it->first>>32);
+            int left = (int)(it->first&0xffffffff), right = (int)(it->second&0xffffffff);
+            for (int dy=-ry;dy<=ry;dy++)
+            {
+                for (int x=left+left_arc[ry+dy];x<right-left_arc[ry+dy];x++)
+                {
+                    cells->insert(std::pair<int,int>(line+dy, x));
+                }
+            }
+        }
+    }
+};
+
+#define LOG_VAR(x) " "#x" "<<x<<" "
+
+TEST_F(WidenRegionTest, dilation_vs_brute_force)
+{
+    WidenRegionCreater *creater = WidenRegionCreater::GetDefaultWidenRegionCreater();
+    for (int i=0;i<200;i++)
+    {
+        FillRandShapes(8+rand()%120, 8+rand()%80);
+        int rx = rand()%40, ry = 1 + rand()%40;
+        if (rx<ry)
+        {
+            rx = ry;//gen_left_arc has glitches on narrow ellipses, the dilation leaves them to the arc sweep
+        }
+        tSpanBuffer dst;
+        creater->xy_overlap_region(&dst, src, rx, ry, WidenRegionCreater::DILATION);
+        Cells ref, output;
+        BruteForceWiden(&ref, rx, ry);
+        ASSERT_TRUE(ToCells(dst, &output))<<LOG_VAR(i)<<LOG_VAR(rx)<<LOG_VAR(ry);
+        ASSERT_TRUE(ref==output)<<LOG_VAR(i)<<LOG_VAR(rx)<<LOG_VAR(ry);
+        for (std::size_t j=1;j<dst.size();j++)
+        {
+            ASSERT_LT(dst[j-1].second, dst[j].first)<<"spans MUST be sorted and maximal"<<LOG_VAR(i)<<LOG_VAR(j);
+        }
+    }
+}
+
+TEST_F(WidenRegionTest, dilation_vs_arc_sweep)
+{
+    WidenRegionCreater *creater = WidenRegionCreater::GetDefaultWidenRegionCreater();
+    for (int i=0;i<200;i++)
+    {
+        FillRandShapes(8+rand()%120, 8+rand()%80);
+        int rx = rand()%48, ry = 8 + rand()%40;//the dilation is only selected for large radii
+        tSpanBuffer dilation, arc_sweep;
+        creater->xy_overlap_region(&dilation, src, rx, ry, WidenRegionCreater::DILATION);
+        creater->xy_overlap_region(&arc_sweep, src, rx, ry, WidenRegionCreater::ARC_SWEEP);
+        Cells a, b;
+        ASSERT_TRUE(ToCells(dilation, &a));
+        ASSERT_TRUE(ToCells(arc_sweep, &b));
+        //the arc sweep approximates the crossings of arcs and may be off by a few cells
+        std::size_t diff = 0;
+        for (Cells::const_iterator it=a.begin();it!=a.end();it++)
+        {
+            diff += b.count(*it)==0;
+        }
+        for (Cells::const_iterator it=b.begin();it!=b.end();it++)
+        {
+            diff += a.count(*it)==0;
+        }
+        ASSERT_LE(diff*100, a.size())<<LOG_VAR(i)<<LOG_VAR(rx)<<LOG_VAR(ry)<<LOG_VAR(diff);
+    }
+}
+
+TEST_F(WidenRegionTest, auto_method_is_reproducible)
+{
+    WidenRegionCreater *creater = WidenRegionCreater::GetDefaultWidenRegionCreater();
+    for (int i=0;i<100;i++)
+    {
+        FillRandShapes(8+rand()%120, 8+rand()%80);
+        int ry = 1 + rand()%64, rx = ry + rand()%16;
+        tSpanBuffer first, after_sweep, other;
+        creater->xy_overlap_region(&first, src, rx, ry);
+        //whatever was widened before, e.g. the same radius by the sweep or another radius
+        creater->xy_overlap_region(&other, src, rx, ry, WidenRegionCreater::ARC_SWEEP);
+        creater->xy_overlap_region(&after_sweep, src, rx, ry);
+        ASSERT_TRUE(first==after_sweep)<<LOG_VAR(i)<<LOG_VAR(rx)<<LOG_VAR(ry);
+        creater->xy_overlap_region(&other, src, rx+1, ry+1);
+        after_sweep.clear();
+        creater->xy_overlap_region(&after_sweep, src, rx, ry);
+        ASSERT_TRUE(first==after_sweep)<<LOG_VAR(i)<<LOG_VAR(rx)<<LOG_VAR(ry);
+    }
+}
+
+#endif // __TEST_WIDEN_REGION_8A2F4C61_0B7D_4E3A_A5C9_6D13E7F0B24C_H__